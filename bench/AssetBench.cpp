@@ -0,0 +1,230 @@
+// AssetBench.cpp
+//
+// Startup cost of registering tile types from an asset pack against
+// decoding their PNGs, serially and on the job system. Each image is
+// registered as many distinct types to stand in for a large tile set.
+// Before timing, every type registered from the pack must match its PNG
+// one in size and alpha mask and the pack's pixels must match the decoded
+// images; any mismatch fails the run.
+
+#include <SDL3/SDL.h>
+#include <SDL3_image/SDL_image.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "core/AssetLoader.hpp"
+#include "core/AssetPack.hpp"
+#include "core/JobSystem.hpp"
+#include "core/TileRegistry.hpp"
+#include "BenchUtils.hpp"
+
+using Bench::check;
+using Bench::elapsedMs;
+
+namespace {
+
+// Copies after the first are named apart so the pack holds each of them
+std::string getCopyName(const std::string& path, int copy) {
+    return copy == 0 ? path : path + "#" + std::to_string(copy);
+}
+
+void registerFromPngs(SDL_Renderer* renderer, const std::vector<std::string>& paths, int copies) {
+    int id = 0;
+    for (int copy = 0; copy < copies; ++copy) {
+        for (const std::string& path : paths) {
+            TileRegistry::registerType(id++, path, renderer, path.c_str());
+        }
+    }
+}
+
+void registerFromPngs(SDL_Renderer* renderer, const std::vector<std::string>& paths, int copies, JobSystem& jobs) {
+    AssetLoader loader(jobs);
+    int id = 0;
+    for (int copy = 0; copy < copies; ++copy) {
+        for (const std::string& path : paths) {
+            TileRegistry::registerType(id++, path, renderer, path.c_str(), loader);
+        }
+    }
+    loader.finish();
+}
+
+bool registerFromPack(SDL_Renderer* renderer, const std::vector<std::string>& paths, int copies, const std::string& packPath) {
+    AssetPack pack;
+    if (!pack.open(packPath) || !TileRegistry::loadPack(renderer, pack)) {
+        return false;
+    }
+    int id = 0;
+    for (int copy = 0; copy < copies; ++copy) {
+        for (const std::string& path : paths) {
+            TileRegistry::registerType(id++, path, renderer, getCopyName(path, copy).c_str());
+        }
+    }
+    return true;
+}
+
+// Size and a coarse sample of the alpha mask of every registered type
+std::vector<float> describeTypes(int count) {
+    std::vector<float> description;
+    for (int id = 0; id < count; ++id) {
+        const TileType* type = TileRegistry::getType(id);
+        if (!type) {
+            description.push_back(-1.0f);
+            continue;
+        }
+        description.push_back(type->getSourceRect().w);
+        description.push_back(type->getSourceRect().h);
+        for (int v = 0; v < 16; ++v) {
+            for (int u = 0; u < 16; ++u) {
+                description.push_back(type->isOpaqueAt((u + 0.5f) / 16.0f, (v + 0.5f) / 16.0f) ? 1.0f : 0.0f);
+            }
+        }
+    }
+    return description;
+}
+
+bool samePixels(const AssetPack& pack, const AssetPack::Image& image, SDL_Surface* decoded) {
+    SDL_Surface* converted = SDL_ConvertSurface(decoded, AssetPack::PIXEL_FORMAT);
+    bool same = converted && converted->w == image.rect.w && converted->h == image.rect.h;
+    for (int y = 0; same && y < converted->h; ++y) {
+        same = std::memcmp(pack.getPixels(image) + static_cast<size_t>(y) * pack.getPitch(image),
+                           static_cast<const uint8_t*>(converted->pixels) + static_cast<size_t>(y) * converted->pitch,
+                           static_cast<size_t>(converted->w) * AssetPack::BYTES_PER_PIXEL) == 0;
+    }
+    SDL_DestroySurface(converted);
+    return same;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    std::string assetDir = "assets";
+    std::string packPath = "isoEngine_assetbench.isopack";
+    int copies = 100;
+    int repeats = 3;
+    int threads = 0;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--assets" && i + 1 < argc) {
+            assetDir = argv[++i];
+        } else if (arg == "--copies" && i + 1 < argc) {
+            copies = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--repeats" && i + 1 < argc) {
+            repeats = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--threads" && i + 1 < argc) {
+            threads = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--file" && i + 1 < argc) {
+            packPath = argv[++i];
+        } else {
+            std::fprintf(stderr, "usage: isoEngine_assetbench [--assets dir] [--copies N] [--repeats N] [--threads N] [--file path]\n");
+            return 2;
+        }
+    }
+
+    // The images the engine loads at startup
+    const char* files[] = {
+        "void.png", "grass.png", "sand.png", "water.png", "stone.png",
+        "water_lily_pad.png", "mountains.png", "cursor.png", "pencil.png",
+    };
+    std::vector<std::string> paths;
+    std::vector<SDL_Surface*> decoded;
+    for (const char* file : files) {
+        std::string path = assetDir + "/" + file;
+        SDL_Surface* surface = IMG_Load(path.c_str());
+        if (surface) {
+            paths.push_back(path);
+            decoded.push_back(surface);
+        }
+    }
+    if (paths.empty()) {
+        std::fprintf(stderr, "no images found in %s\n", assetDir.c_str());
+        return 1;
+    }
+
+    // Software renderer drawing into a plain surface, no display needed
+    SDL_Surface* target = SDL_CreateSurface(64, 64, SDL_PIXELFORMAT_ARGB8888);
+    SDL_Renderer* renderer = target ? SDL_CreateSoftwareRenderer(target) : nullptr;
+    if (!renderer) {
+        SDL_Log("Couldn't create software renderer: %s", SDL_GetError());
+        return 1;
+    }
+    JobSystem jobs(threads);
+
+    // The packer's job, done once
+    std::vector<std::string> names;
+    std::vector<SDL_Surface*> surfaces;
+    for (int copy = 0; copy < copies; ++copy) {
+        for (size_t i = 0; i < paths.size(); ++i) {
+            names.push_back(getCopyName(paths[i], copy));
+            surfaces.push_back(decoded[i]);
+        }
+    }
+    Uint64 start = SDL_GetTicksNS();
+    check(AssetPack::build(packPath, names, surfaces, TileRegistry::ATLAS_PAGE_SIZE, TileRegistry::ATLAS_PADDING), "pack builds");
+    double buildMs = elapsedMs(start);
+
+    const int typeCount = static_cast<int>(names.size());
+    registerFromPngs(renderer, paths, copies);
+    std::vector<float> fromPngs = describeTypes(typeCount);
+    TileRegistry::clear();
+    registerFromPngs(renderer, paths, copies, jobs);
+    check(describeTypes(typeCount) == fromPngs, "loader registers the same types");
+    TileRegistry::clear();
+    check(registerFromPack(renderer, paths, copies, packPath), "pack loads");
+    check(describeTypes(typeCount) == fromPngs, "pack registers the same types");
+    TileRegistry::clear();
+
+    AssetPack pack;
+    size_t packBytes = 0, pageCount = 0;
+    if (pack.open(packPath)) {
+        for (size_t i = 0; i < paths.size(); ++i) {
+            const AssetPack::Image* image = pack.findImage(paths[i]);
+            check(image && samePixels(pack, *image, decoded[i]), paths[i] + " pixels match");
+        }
+        MappedFile file;
+        packBytes = file.open(packPath, MappedFile::Access::ReadOnly) ? file.getSize() : 0;
+        pageCount = pack.getPages().size();
+        pack.close();
+    }
+
+    for (SDL_Surface* surface : decoded) {
+        SDL_DestroySurface(surface);
+    }
+    if (Bench::failures > 0) {
+        std::fprintf(stderr, "%d asset pack checks failed\n", Bench::failures);
+        std::remove(packPath.c_str());
+        return 1;
+    }
+
+    // Best of the repeats, the first run also warms the file cache
+    auto best = [repeats](auto function) {
+        double bestMs = 0.0;
+        for (int i = 0; i < repeats; ++i) {
+            Uint64 runStart = SDL_GetTicksNS();
+            function();
+            double ms = elapsedMs(runStart);
+            TileRegistry::clear();
+            bestMs = i == 0 ? ms : std::min(bestMs, ms);
+        }
+        return bestMs;
+    };
+    double pngMs = best([&] { registerFromPngs(renderer, paths, copies); });
+    double loaderMs = best([&] { registerFromPngs(renderer, paths, copies, jobs); });
+    double packMs = best([&] { registerFromPack(renderer, paths, copies, packPath); });
+
+    std::printf("{\n  \"checks\": \"passed\",\n  \"threads\": %d,\n  \"images\": %zu,\n  \"types\": %d,\n"
+                "  \"pack_bytes\": %zu,\n  \"pack_pages\": %zu,\n  \"pack_build_ms\": %.2f,\n"
+                "  \"png_ms\": %.2f,\n  \"png_parallel_ms\": %.2f,\n  \"pack_ms\": %.2f,\n"
+                "  \"speedup_over_png\": %.1f,\n  \"speedup_over_png_parallel\": %.1f\n}\n",
+                jobs.getThreadCount(), paths.size(), typeCount, packBytes, pageCount, buildMs,
+                pngMs, loaderMs, packMs, pngMs / packMs, loaderMs / packMs);
+
+    SDL_DestroyRenderer(renderer);
+    SDL_DestroySurface(target);
+    std::remove(packPath.c_str());
+    return 0;
+}
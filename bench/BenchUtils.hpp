@@ -0,0 +1,27 @@
+// BenchUtils.hpp
+
+#pragma once
+
+#include <SDL3/SDL.h>
+
+#include <cstdio>
+#include <string>
+
+// Self-checks and timing shared by the benchmarks. A failed check is
+// reported and counted; a bench exits with an error if any failed.
+namespace Bench {
+
+inline int failures = 0;
+
+inline void check(bool condition, const std::string& what) {
+    if (!condition) {
+        std::fprintf(stderr, "FAILED: %s\n", what.c_str());
+        failures++;
+    }
+}
+
+inline double elapsedMs(Uint64 start) {
+    return (SDL_GetTicksNS() - start) / 1.0e6;
+}
+
+}
@@ -0,0 +1,234 @@
+// EditBench.cpp
+//
+// Cost of the bulk region edits on dense and chunked maps, against the
+// per-cell setTile loop they replace, and of undoing them through the edit
+// journal. Results are checked against that loop and undo against saved
+// map hashes before timing; any mismatch fails the run.
+
+#include <SDL3/SDL.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "core/EditJournal.hpp"
+#include "core/Map.hpp"
+#include "BenchUtils.hpp"
+
+using Bench::check;
+using Bench::elapsedMs;
+
+namespace {
+
+void scatter(Map& map, int count, unsigned seed) {
+    std::mt19937 rng(seed);
+    for (int i = 0; i < count; ++i) {
+        map.setTile(static_cast<int>(rng() % map.getWidth()), static_cast<int>(rng() % map.getHeight()),
+                    static_cast<int>(rng() % map.getLayerCount()), static_cast<int>(rng() % 8));
+    }
+}
+
+// Region edits must give the same map as the equivalent setTile loops
+void verify(StorageMode mode) {
+    const SDL_Color color = { 0, 0, 0, 255 };
+
+    Map fast(97, 61, 3, color, mode), slow(97, 61, 3, color, mode);
+    scatter(fast, 2000, 1);
+    scatter(slow, 2000, 1);
+
+    fast.fillRect(-5, 10, 40, 20, 1, 6);
+    for (int y = 10; y < 30; ++y) {
+        for (int x = 0; x < 35; ++x) {
+            slow.setTile(x, y, 1, 6);
+        }
+    }
+    check(fast.computeStateHash() == slow.computeStateHash(), "fillRect matches setTile");
+
+    fast.fillRect(90, 50, 20, 20, 0, -1);
+    for (int y = 50; y < 61; ++y) {
+        for (int x = 90; x < 97; ++x) {
+            slow.removeTile(x, y, 0);
+        }
+    }
+    check(fast.computeStateHash() == slow.computeStateHash(), "fillRect with -1 clears");
+
+    // Masked paste of a rotated, flipped stamp with holes
+    TileStamp stamp = fast.copyRect(3, 4, 23, 17);
+    check(stamp.getWidth() == 23 && stamp.getHeight() == 17 && stamp.getLayerCount() == 3, "copyRect keeps the size");
+    stamp.rotateClockwise();
+    stamp.flipHorizontal();
+    for (int y = 0; y < stamp.getHeight(); y += 3) {
+        stamp.set(y % stamp.getWidth(), y, 2, EMPTY_TILE);
+    }
+
+    fast.pasteStamp(stamp, 80, 45, true);
+    for (int layer = 0; layer < 3; ++layer) {
+        for (int y = 0; y < stamp.getHeight(); ++y) {
+            for (int x = 0; x < stamp.getWidth(); ++x) {
+                TileID id = stamp.get(x, y, layer);
+                if (id != EMPTY_TILE && x + 80 < 97 && y + 45 < 61) {
+                    slow.setTile(x + 80, y + 45, layer, id);
+                }
+            }
+        }
+    }
+    check(fast.computeStateHash() == slow.computeStateHash(), "masked pasteStamp matches setTile");
+
+    // Unmasked copy between maps clears under the source's holes
+    Map target(97, 61, 3, color, mode);
+    target.fillWithTile(1, 2);
+    target.copyRectFrom(fast, 0, 0, 97, 61, 0, 0);
+    check(target.computeStateHash() == fast.computeStateHash(), "copyRectFrom reproduces the source");
+
+    TileStamp turned = stamp;
+    for (int i = 0; i < 4; ++i) {
+        turned.rotateCounterClockwise();
+    }
+    turned.flipVertical();
+    turned.flipVertical();
+    bool same = turned.getWidth() == stamp.getWidth() && turned.getHeight() == stamp.getHeight();
+    for (int layer = 0; same && layer < 3; ++layer) {
+        for (int y = 0; same && y < stamp.getHeight(); ++y) {
+            same = std::equal(stamp.getRow(y, layer), stamp.getRow(y, layer) + stamp.getWidth(), turned.getRow(y, layer));
+        }
+    }
+    check(same, "four rotations and two flips are the identity");
+
+    fast.clearLayers(0, 2);
+    check(fast.computeStateHash() == Map(97, 61, 3, color, mode).computeStateHash(), "clearLayers empties every layer");
+
+    // Every journaled step undoes to the map before it and redoes to the one after
+    Map edited(97, 61, 3, color, mode);
+    scatter(edited, 2000, 2);
+    EditJournal& journal = edited.getJournal();
+    std::vector<uint64_t> hashes{ edited.computeStateHash() };
+
+    journal.fillRect(10, 10, 50, 30, 0, 3);
+    hashes.push_back(edited.computeStateHash());
+    journal.begin("Mixed");
+    journal.setTile(1, 1, 2, 4);
+    journal.fillRect(0, 0, 97, 61, 2, -1);
+    journal.setTile(1, 1, 2, 5);
+    journal.setTile(2, 1, 2, 5);
+    journal.commit();
+    hashes.push_back(edited.computeStateHash());
+    journal.pasteStamp(stamp, 40, 20, true);
+    hashes.push_back(edited.computeStateHash());
+    journal.clearLayers(0, 1);
+    hashes.push_back(edited.computeStateHash());
+
+    check(journal.getUndoCount() == hashes.size() - 1, "one undo step per transaction");
+    bool undone = true;
+    for (size_t i = hashes.size() - 1; i > 0; --i) {
+        undone = journal.undo() && edited.computeStateHash() == hashes[i - 1] && undone;
+    }
+    check(undone && !journal.canUndo(), "undo restores every earlier state");
+    bool redone = true;
+    for (size_t i = 1; i < hashes.size(); ++i) {
+        redone = journal.redo() && edited.computeStateHash() == hashes[i] && redone;
+    }
+    check(redone && !journal.canRedo(), "redo restores every later state");
+
+    journal.setMemoryLimit(1);
+    check(journal.getUndoCount() == 1 && journal.getDroppedCount() == hashes.size() - 2, "the memory limit drops the oldest steps");
+}
+
+void measure(StorageMode mode, int size, bool perCellBaseline, bool& first) {
+    const SDL_Color color = { 0, 0, 0, 255 };
+    Map map(size, size, 2, color, mode);
+
+    Uint64 start = SDL_GetTicksNS();
+    map.fillRect(0, 0, size, size, 0, 1);
+    double fillMs = elapsedMs(start);
+
+    double perCellMs = -1.0;
+    if (perCellBaseline) {
+        start = SDL_GetTicksNS();
+        for (int y = 0; y < size; ++y) {
+            for (int x = 0; x < size; ++x) {
+                map.setTile(x, y, 1, 2);
+            }
+        }
+        perCellMs = elapsedMs(start);
+    }
+
+    int block = std::min(size, 1024);
+    start = SDL_GetTicksNS();
+    TileStamp stamp = map.copyRect(0, 0, block, block);
+    double copyMs = elapsedMs(start);
+
+    start = SDL_GetTicksNS();
+    stamp.rotateClockwise();
+    double rotateMs = elapsedMs(start);
+
+    start = SDL_GetTicksNS();
+    map.pasteStamp(stamp, size - block, size - block, false);
+    double pasteMs = elapsedMs(start);
+
+    start = SDL_GetTicksNS();
+    map.pasteStamp(stamp, 0, size - block, true);
+    double maskedPasteMs = elapsedMs(start);
+
+    start = SDL_GetTicksNS();
+    map.clearLayers(0, 1);
+    double clearMs = elapsedMs(start);
+
+    // Journaled fill over a partly filled layer, the undo data is as large
+    // as the run-length encoding of what it covered
+    map.pasteStamp(stamp, 0, 0, false);
+    EditJournal& journal = map.getJournal();
+    start = SDL_GetTicksNS();
+    journal.fillRect(0, 0, size, size, 0, 3);
+    double journalFillMs = elapsedMs(start);
+    size_t historyBytes = journal.getMemoryUsage();
+
+    start = SDL_GetTicksNS();
+    journal.undo();
+    double undoMs = elapsedMs(start);
+
+    start = SDL_GetTicksNS();
+    journal.redo();
+    double redoMs = elapsedMs(start);
+
+    std::printf("%s    { \"storage\": \"%s\", \"size\": %d, \"fill_layer_ms\": %.3f, \"set_tile_layer_ms\": %.3f, "
+                "\"copy_%d_ms\": %.3f, \"rotate_ms\": %.3f, \"paste_ms\": %.3f, \"masked_paste_ms\": %.3f, \"clear_layers_ms\": %.3f, "
+                "\"journal_fill_ms\": %.3f, \"undo_ms\": %.3f, \"redo_ms\": %.3f, \"history_bytes\": %zu }",
+                first ? "" : ",\n", mode == StorageMode::Chunked ? "chunked" : "dense", size, fillMs, perCellMs,
+                block, copyMs, rotateMs, pasteMs, maskedPasteMs, clearMs, journalFillMs, undoMs, redoMs, historyBytes);
+    first = false;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    int size = 4096;
+    bool perCellBaseline = true;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--size" && i + 1 < argc) {
+            size = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--no-baseline") {
+            perCellBaseline = false;
+        } else {
+            std::fprintf(stderr, "usage: isoEngine_editbench [--size N] [--no-baseline]\n");
+            return 2;
+        }
+    }
+
+    verify(StorageMode::Dense);
+    verify(StorageMode::Chunked);
+    if (Bench::failures > 0) {
+        std::fprintf(stderr, "%d region edit checks failed\n", Bench::failures);
+        return 1;
+    }
+
+    std::printf("{\n  \"checks\": \"passed\",\n  \"results\": [\n");
+    bool first = true;
+    measure(StorageMode::Dense, size, perCellBaseline, first);
+    measure(StorageMode::Chunked, size, perCellBaseline, first);
+    std::printf("\n  ]\n}\n");
+    return 0;
+}
@@ -0,0 +1,209 @@
+// JobBench.cpp
+//
+// Job system checks and throughput. Counters, dependencies, parallel-for
+// coverage, nested waits and submissions from foreign threads are checked
+// first; any failure fails the run. Then empty-job dispatch rate and
+// parallel-for speedup over a serial loop are measured and printed as JSON.
+
+#include <SDL3/SDL.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "core/JobSystem.hpp"
+#include "BenchUtils.hpp"
+
+using Bench::check;
+using Bench::elapsedMs;
+
+namespace {
+
+struct BenchConfig {
+    int threads = 0;            // 0 for one per logical core
+    int jobs = 200000;          // Empty jobs for the dispatch measurement
+    int elements = 1 << 22;     // Parallel-for work items
+};
+
+void checkCounter(JobSystem& jobs) {
+    std::atomic<int> done{ 0 };
+    JobCounter counter;
+    for (int i = 0; i < 1000; ++i) {
+        jobs.run("Check counter", [&done] { done.fetch_add(1); }, &counter);
+    }
+    jobs.wait(counter);
+    check(done.load() == 1000 && counter.isDone(), "every counted job finishes before wait returns");
+
+    // A counter that reached zero can be reused
+    jobs.run("Check counter", [&done] { done.fetch_add(1); }, &counter);
+    jobs.wait(counter);
+    check(done.load() == 1001, "counters are reusable");
+}
+
+// Each stage may only start once the whole previous stage has finished
+void checkDependencies(JobSystem& jobs) {
+    const int STAGES = 4;
+    const int JOBS_PER_STAGE = 64;
+
+    std::vector<std::atomic<int>> finished(STAGES);
+    std::vector<JobCounter> counters(STAGES);
+    std::atomic<int> violations{ 0 };
+
+    for (int stage = 0; stage < STAGES; ++stage) {
+        JobCounter* dependency = stage > 0 ? &counters[stage - 1] : nullptr;
+        for (int i = 0; i < JOBS_PER_STAGE; ++i) {
+            jobs.run("Check dependency", [&, stage] {
+                if (stage > 0 && finished[stage - 1].load() != JOBS_PER_STAGE) {
+                    violations.fetch_add(1);
+                }
+                finished[stage].fetch_add(1);
+            }, &counters[stage], dependency);
+        }
+    }
+
+    jobs.wait(counters[STAGES - 1]);
+    check(violations.load() == 0, "dependent jobs wait for their dependency");
+    check(finished[STAGES - 1].load() == JOBS_PER_STAGE, "dependency chains run to completion");
+}
+
+void checkParallelFor(JobSystem& jobs) {
+    const int counts[] = { 0, 1, 13, 1000, 100003 };
+    const int grains[] = { 1, 7, 64, 4096 };
+
+    for (int count : counts) {
+        for (int grain : grains) {
+            std::vector<std::atomic<int>> visits(count);
+            jobs.parallelFor("Check parallel-for", count, grain, [&visits](int begin, int end) {
+                for (int i = begin; i < end; ++i) {
+                    visits[i].fetch_add(1);
+                }
+            });
+
+            bool once = std::all_of(visits.begin(), visits.end(), [](const std::atomic<int>& v) { return v.load() == 1; });
+            check(once, "parallel-for visits every index exactly once");
+        }
+    }
+}
+
+// Jobs that wait on jobs of their own must not deadlock the pool
+void checkNestedWait(JobSystem& jobs) {
+    std::atomic<int> inner{ 0 };
+    jobs.parallelFor("Check nested", 32, [&](int) {
+        jobs.parallelFor("Check nested inner", 32, [&inner](int) { inner.fetch_add(1); });
+    });
+    check(inner.load() == 32 * 32, "nested parallel-for completes");
+}
+
+void checkForeignThread(JobSystem& jobs) {
+    std::atomic<int> done{ 0 };
+    std::thread outsider([&] {
+        JobCounter counter;
+        for (int i = 0; i < 500; ++i) {
+            jobs.run("Check foreign", [&done] { done.fetch_add(1); }, &counter);
+        }
+        jobs.wait(counter);
+    });
+    outsider.join();
+    check(done.load() == 500, "threads outside the system can submit and wait");
+}
+
+void checkStats(JobSystem& jobs) {
+    jobs.resetJobStats();
+    jobs.parallelFor("Check stats", 100, [](int) {});
+
+    std::vector<JobStats> stats;
+    jobs.collectJobStats(stats);
+    bool found = std::any_of(stats.begin(), stats.end(), [](const JobStats& stat) {
+        return stat.name == "Check stats" && stat.count == 100;
+    });
+    check(found || jobs.getThreadCount() == 1, "job timings are recorded per name");
+}
+
+// Enough arithmetic per element that the loop is compute bound
+double work(int index) {
+    double value = index;
+    for (int i = 0; i < 16; ++i) {
+        value = std::sqrt(value + i);
+    }
+    return value;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    BenchConfig config;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--threads" && i + 1 < argc) {
+            config.threads = std::max(0, std::atoi(argv[++i]));
+        } else if (arg == "--jobs" && i + 1 < argc) {
+            config.jobs = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--elements" && i + 1 < argc) {
+            config.elements = std::max(1, std::atoi(argv[++i]));
+        } else {
+            std::fprintf(stderr, "usage: isoEngine_jobbench [--threads N] [--jobs N] [--elements N]\n");
+            return 2;
+        }
+    }
+
+    JobSystem jobs(config.threads);
+
+    checkCounter(jobs);
+    checkDependencies(jobs);
+    checkParallelFor(jobs);
+    checkNestedWait(jobs);
+    checkForeignThread(jobs);
+    checkStats(jobs);
+    if (Bench::failures > 0) {
+        std::fprintf(stderr, "%d job system checks failed\n", Bench::failures);
+        return 1;
+    }
+
+    // Dispatch cost of jobs that do nothing
+    Uint64 start = SDL_GetTicksNS();
+    {
+        JobCounter counter;
+        for (int i = 0; i < config.jobs; ++i) {
+            jobs.run("Empty", [] {}, &counter);
+        }
+        jobs.wait(counter);
+    }
+    double dispatchMs = elapsedMs(start);
+
+    // The same loop serially and as a parallel-for
+    std::vector<double> serialOut(config.elements), parallelOut(config.elements);
+
+    start = SDL_GetTicksNS();
+    for (int i = 0; i < config.elements; ++i) {
+        serialOut[i] = work(i);
+    }
+    double serialMs = elapsedMs(start);
+
+    start = SDL_GetTicksNS();
+    jobs.parallelFor("Work", config.elements, 4096, [&parallelOut](int begin, int end) {
+        for (int i = begin; i < end; ++i) {
+            parallelOut[i] = work(i);
+        }
+    });
+    double parallelMs = elapsedMs(start);
+
+    if (serialOut != parallelOut) {
+        std::fprintf(stderr, "parallel-for produced different results\n");
+        return 1;
+    }
+
+    std::printf("{\n");
+    std::printf("  \"threads\": %d,\n", jobs.getThreadCount());
+    std::printf("  \"checks\": \"passed\",\n");
+    std::printf("  \"dispatch\": { \"jobs\": %d, \"ms\": %.3f, \"ns_per_job\": %.1f },\n",
+                config.jobs, dispatchMs, dispatchMs * 1.0e6 / config.jobs);
+    std::printf("  \"parallel_for\": { \"elements\": %d, \"serial_ms\": %.3f, \"parallel_ms\": %.3f, \"speedup\": %.2f }\n",
+                config.elements, serialMs, parallelMs, serialMs / parallelMs);
+    std::printf("}\n");
+    return 0;
+}
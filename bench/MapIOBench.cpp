@@ -0,0 +1,247 @@
+// MapIOBench.cpp
+//
+// Save and load throughput of the chunked map format and its compression
+// ratio on a few kinds of maps, serial and on the job system, next to
+// loading a screen-sized region. Every map is saved and loaded back, whole
+// and by regions, and compared with the original before timing; any
+// mismatch fails the run.
+
+#include <SDL3/SDL.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "core/JobSystem.hpp"
+#include "core/Map.hpp"
+#include "core/MapIO.hpp"
+#include "utils/BinaryIO.hpp"
+#include "BenchUtils.hpp"
+
+using Bench::check;
+using Bench::elapsedMs;
+
+namespace {
+
+struct MapKind {
+    const char* name;
+    StorageMode mode;
+    bool bounded;
+};
+
+// Terrain: blobs of a few ground tiles and sparse decoration on top.
+// Checkerboard: the engine's default maps. Noise: a random tile per cell,
+// close to the worst case. Islands: patches scattered on an unbounded map.
+const MapKind KINDS[] = {
+    { "terrain", StorageMode::Dense, true },
+    { "checkerboard", StorageMode::Dense, true },
+    { "noise", StorageMode::Dense, true },
+    { "islands", StorageMode::Chunked, false },
+};
+
+std::unique_ptr<Map> buildMap(const MapKind& kind, int size, unsigned seed) {
+    const SDL_Color color = { 0, 0, 0, 255 };
+    auto map = std::make_unique<Map>(kind.bounded ? size : 0, kind.bounded ? size : 0, 2, color, kind.mode);
+    std::mt19937 rng(seed);
+    std::string name = kind.name;
+
+    if (name == "terrain") {
+        // Coarse random grid, each cell of it a ground tile
+        const int cell = 24;
+        const int grid = size / cell + 2;
+        std::vector<int> ground(static_cast<size_t>(grid) * grid);
+        for (int& tile : ground) {
+            tile = static_cast<int>(rng() % 4);
+        }
+        for (int y = 0; y < size; ++y) {
+            for (int x = 0; x < size; ++x) {
+                // Jitter the borders so blobs are not squares
+                int jitter = static_cast<int>(rng() % 5) - 2;
+                int gx = std::clamp((x + jitter) / cell, 0, grid - 1), gy = std::clamp((y - jitter) / cell, 0, grid - 1);
+                map->setTile(x, y, 0, ground[gy * grid + gx]);
+                if (rng() % 100 < 4) {
+                    map->setTile(x, y, 1, 4 + static_cast<int>(rng() % 4));
+                }
+            }
+        }
+    } else if (name == "checkerboard") {
+        for (int y = 0; y < size; ++y) {
+            for (int x = 0; x < size; ++x) {
+                map->setTile(x, y, 0, (x + y) % 2 == 0 ? 1 : 2);
+            }
+        }
+    } else if (name == "noise") {
+        for (int layer = 0; layer < 2; ++layer) {
+            for (int y = 0; y < size; ++y) {
+                for (int x = 0; x < size; ++x) {
+                    map->setTile(x, y, layer, static_cast<int>(rng() % 8));
+                }
+            }
+        }
+    } else {
+        // About a quarter of the area, spread over four times the span
+        const int islands = std::max(1, size / 16);
+        for (int i = 0; i < islands; ++i) {
+            int originX = static_cast<int>(rng() % (size * 2)) - size, originY = static_cast<int>(rng() % (size * 2)) - size;
+            map->fillRect(originX, originY, size / 8, size / 8, 0, static_cast<int>(rng() % 4));
+            map->fillRect(originX + 4, originY + 4, size / 16, size / 16, 1, 6);
+        }
+    }
+    return map;
+}
+
+size_t getCellCount(const Map& map) {
+    size_t cells = 0;
+    for (int layer = 0; layer < map.getLayerCount(); ++layer) {
+        int minX, minY, maxX, maxY;
+        if (map.getOccupiedBounds(layer, minX, minY, maxX, maxY)) {
+            cells += static_cast<size_t>(maxX - minX + 1) * (maxY - minY + 1);
+        }
+    }
+    return cells;
+}
+
+uint64_t hashRegion(const Map& map, int x, int y, int width, int height) {
+    uint64_t hash = 14695981039346656037ull;
+    for (int layer = 0; layer < map.getLayerCount(); ++layer) {
+        for (int row = y; row < y + height; ++row) {
+            for (int column = x; column < x + width; ++column) {
+                hash = (hash ^ static_cast<uint16_t>(map.getTileID(column, row, layer))) * 1099511628211ull;
+            }
+        }
+    }
+    return hash;
+}
+
+int countTilesOutside(const Map& map, int x, int y, int width, int height) {
+    int count = 0;
+    for (int layer = 0; layer < map.getLayerCount(); ++layer) {
+        int minX, minY, maxX, maxY;
+        if (!map.getOccupiedBounds(layer, minX, minY, maxX, maxY)) {
+            continue;
+        }
+        for (int row = minY; row <= maxY; ++row) {
+            for (int column = minX; column <= maxX; ++column) {
+                bool inside = column >= x && column < x + width && row >= y && row < y + height;
+                count += !inside && map.hasTile(column, row, layer);
+            }
+        }
+    }
+    return count;
+}
+
+void verify(const MapKind& kind, JobSystem& jobs, const std::string& path) {
+    auto map = buildMap(kind, 150, 7);
+    std::string name = kind.name;
+
+    check(MapIO::saveMap(*map, path), name + " saves");
+    auto serial = MapIO::loadMap(path);
+    auto parallel = MapIO::loadMap(path, &jobs);
+    check(serial && serial->computeStateHash() == map->computeStateHash(), name + " loads back");
+    check(parallel && parallel->computeStateHash() == map->computeStateHash(), name + " loads back in parallel");
+
+    std::vector<uint8_t> serialBytes, parallelBytes;
+    check(MapIO::saveMap(*map, path + ".parallel", &jobs), name + " saves in parallel");
+    check(BinaryIO::readFile(path, serialBytes) && BinaryIO::readFile(path + ".parallel", parallelBytes)
+          && serialBytes == parallelBytes, name + " saves the same bytes in parallel");
+    std::remove((path + ".parallel").c_str());
+
+    // Regions straddling chunk borders and the map edges
+    std::mt19937 rng(3);
+    for (int i = 0; i < 20; ++i) {
+        int x = static_cast<int>(rng() % 200) - 40, y = static_cast<int>(rng() % 200) - 40;
+        int width = static_cast<int>(rng() % 130), height = static_cast<int>(rng() % 130);
+        auto region = MapIO::loadMapRegion(path, x, y, width, height, &jobs);
+        check(region && hashRegion(*region, x, y, width, height) == hashRegion(*map, x, y, width, height),
+              name + " region loads");
+        check(region && countTilesOutside(*region, x, y, width, height) == 0, name + " region holds nothing else");
+    }
+}
+
+void measure(const MapKind& kind, int size, int repeats, JobSystem& jobs, const std::string& path, bool& first) {
+    auto map = buildMap(kind, size, 1);
+
+    // Best of the repeats, the first run also warms the file cache
+    auto best = [repeats](auto function) {
+        double bestMs = 0.0;
+        for (int i = 0; i < repeats; ++i) {
+            Uint64 start = SDL_GetTicksNS();
+            function();
+            double ms = elapsedMs(start);
+            bestMs = i == 0 ? ms : std::min(bestMs, ms);
+        }
+        return bestMs;
+    };
+
+    double saveMs = best([&] { MapIO::saveMap(*map, path); });
+    double parallelSaveMs = best([&] { MapIO::saveMap(*map, path, &jobs); });
+    double loadMs = best([&] { MapIO::loadMap(path); });
+    double parallelLoadMs = best([&] { MapIO::loadMap(path, &jobs); });
+
+    // Roughly the cells a 1280x720 view shows at zoom 1, mid-map
+    int minX = 0, minY = 0, maxX = 0, maxY = 0;
+    map->getOccupiedBounds(0, minX, minY, maxX, maxY);
+    const int regionX = (minX + maxX) / 2 - 20, regionY = (minY + maxY) / 2 - 20;
+    double regionMs = best([&] { MapIO::loadMapRegion(path, regionX, regionY, 40, 40, &jobs); });
+
+    std::vector<uint8_t> bytes;
+    BinaryIO::readFile(path, bytes);
+    const double rawBytes = static_cast<double>(getCellCount(*map)) * sizeof(TileID);
+    const double rawMB = rawBytes / (1024.0 * 1024.0);
+
+    std::printf("%s    { \"map\": \"%s\", \"size\": %d, \"raw_bytes\": %.0f, \"file_bytes\": %zu, \"ratio\": %.2f,\n"
+                "      \"save_ms\": %.2f, \"save_parallel_ms\": %.2f, \"load_ms\": %.2f, \"load_parallel_ms\": %.2f, \"region_load_ms\": %.3f,\n"
+                "      \"save_mb_s\": %.1f, \"save_parallel_mb_s\": %.1f, \"load_mb_s\": %.1f, \"load_parallel_mb_s\": %.1f }",
+                first ? "" : ",\n", kind.name, size, rawBytes, bytes.size(), rawBytes / bytes.size(),
+                saveMs, parallelSaveMs, loadMs, parallelLoadMs, regionMs,
+                rawMB / (saveMs / 1000.0), rawMB / (parallelSaveMs / 1000.0), rawMB / (loadMs / 1000.0), rawMB / (parallelLoadMs / 1000.0));
+    first = false;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    int size = 2048;
+    int repeats = 3;
+    int threads = 0;
+    std::string path = "isoEngine_mapiobench.isomap";
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--size" && i + 1 < argc) {
+            size = std::max(16, std::atoi(argv[++i]));
+        } else if (arg == "--repeats" && i + 1 < argc) {
+            repeats = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--threads" && i + 1 < argc) {
+            threads = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--file" && i + 1 < argc) {
+            path = argv[++i];
+        } else {
+            std::fprintf(stderr, "usage: isoEngine_mapiobench [--size N] [--repeats N] [--threads N] [--file path]\n");
+            return 2;
+        }
+    }
+
+    JobSystem jobs(threads);
+
+    for (const MapKind& kind : KINDS) {
+        verify(kind, jobs, path);
+    }
+    if (Bench::failures > 0) {
+        std::fprintf(stderr, "%d map file checks failed\n", Bench::failures);
+        std::remove(path.c_str());
+        return 1;
+    }
+
+    std::printf("{\n  \"checks\": \"passed\",\n  \"threads\": %d,\n  \"results\": [\n", jobs.getThreadCount());
+    bool first = true;
+    for (const MapKind& kind : KINDS) {
+        measure(kind, size, repeats, jobs, path, first);
+    }
+    std::printf("\n  ]\n}\n");
+
+    std::remove(path.c_str());
+    return 0;
+}
@@ -0,0 +1,170 @@
+// MathBench.cpp
+//
+// Throughput of the batch coordinate transforms against the single-point
+// functions, for every SIMD level the CPU supports. Before timing, each
+// level is checked to produce bit-identical results to the scalar path;
+// any mismatch fails the run.
+
+#include <SDL3/SDL.h>
+
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "utils/Math.hpp"
+
+namespace {
+
+struct Coordinates {
+    std::vector<int> x;
+    std::vector<int> y;
+};
+
+// Random points plus the edge cases floor and truncation disagree on
+Coordinates makeInputs(std::size_t count, int range, unsigned seed) {
+    Coordinates input;
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> value(-range, range);
+
+    const int edges[] = { 0, 1, -1, 2, -2, 31, -31, 32, -32, 33, -33, 63, -63, 64, -64, 65, -65, range, -range };
+    for (int ex : edges) {
+        for (int ey : edges) {
+            input.x.push_back(ex);
+            input.y.push_back(ey);
+        }
+    }
+
+    while (input.x.size() < count) {
+        input.x.push_back(value(rng));
+        input.y.push_back(value(rng));
+    }
+    return input;
+}
+
+// Odd lengths and offsets exercise the scalar tail after full vector lanes
+bool verify(int w, int h, const Coordinates& input) {
+    std::size_t total = input.x.size();
+    std::vector<int> refX(total), refY(total), outX(total), outY(total);
+
+    for (int direction = 0; direction < 2; ++direction) {
+        for (std::size_t i = 0; i < total; ++i) {
+            if (direction == 0) {
+                Math::toScreenCoordinates(w, h, input.x[i], input.y[i], refX[i], refY[i]);
+            } else {
+                Math::toGridCoordinates(w, h, input.x[i], input.y[i], refX[i], refY[i]);
+            }
+        }
+
+        for (std::size_t offset = 0; offset < 8; ++offset) {
+            std::size_t count = total - offset - (offset * 3) % 7;
+            std::fill(outX.begin(), outX.end(), INT_MIN);
+            std::fill(outY.begin(), outY.end(), INT_MIN);
+
+            if (direction == 0) {
+                Math::toScreenCoordinates(w, h, &input.x[offset], &input.y[offset], &outX[offset], &outY[offset], count);
+            } else {
+                Math::toGridCoordinates(w, h, &input.x[offset], &input.y[offset], &outX[offset], &outY[offset], count);
+            }
+
+            for (std::size_t i = offset; i < offset + count; ++i) {
+                if (outX[i] != refX[i] || outY[i] != refY[i]) {
+                    std::fprintf(stderr, "%s mismatch (%s, tile %dx%d) at (%d, %d): got (%d, %d), expected (%d, %d)\n",
+                                 direction == 0 ? "toScreen" : "toGrid", Math::getSimdLevelName(Math::getSimdLevel()),
+                                 w, h, input.x[i], input.y[i], outX[i], outY[i], refX[i], refY[i]);
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+template <typename Fn>
+double bestNsPerPoint(std::size_t count, int repeats, Fn&& run) {
+    double best = 1e30;
+    for (int r = 0; r < repeats; ++r) {
+        Uint64 start = SDL_GetTicksNS();
+        run();
+        Uint64 end = SDL_GetTicksNS();
+        best = std::min(best, static_cast<double>(end - start) / count);
+    }
+    return best;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    std::size_t count = 1 << 16;
+    int repeats = 200;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        if (arg == "--points") count = std::max(1, std::atoi(argv[i + 1]));
+        else if (arg == "--repeats") repeats = std::max(1, std::atoi(argv[i + 1]));
+    }
+
+    const Math::SimdLevel supported = Math::getSupportedSimdLevel();
+    std::vector<Math::SimdLevel> levels = { Math::SimdLevel::Scalar };
+    if (supported >= Math::SimdLevel::SSE2) levels.push_back(Math::SimdLevel::SSE2);
+    if (supported >= Math::SimdLevel::AVX2) levels.push_back(Math::SimdLevel::AVX2);
+
+    // Grid range keeps screen coordinates well inside int range for 64px tiles
+    const int tileSizes[][2] = { { 64, 64 }, { 64, 32 }, { 32, 16 }, { 63, 31 }, { 128, 64 } };
+    Coordinates grid = makeInputs(count, 1 << 20, 1);
+    Coordinates screen = makeInputs(count, 1 << 24, 2);
+
+    for (Math::SimdLevel level : levels) {
+        Math::setSimdLevel(level);
+        for (const auto& size : tileSizes) {
+            if (!verify(size[0], size[1], grid) || !verify(size[0], size[1], screen)) {
+                return 1;
+            }
+        }
+    }
+
+    std::vector<int> outX(count), outY(count);
+    volatile int sink = 0;
+
+    std::printf("{\n  \"points\": %zu,\n  \"verified\": true,\n", count);
+
+    // Per-call reference: the single-point functions in a loop
+    double scalarScreen = bestNsPerPoint(count, repeats, [&] {
+        for (std::size_t i = 0; i < count; ++i) {
+            Math::toScreenCoordinates(64, 64, grid.x[i], grid.y[i], outX[i], outY[i]);
+        }
+        sink = sink + outX[count - 1];
+    });
+    double scalarGrid = bestNsPerPoint(count, repeats, [&] {
+        for (std::size_t i = 0; i < count; ++i) {
+            Math::toGridCoordinates(64, 64, screen.x[i], screen.y[i], outX[i], outY[i]);
+        }
+        sink = sink + outX[count - 1];
+    });
+    std::printf("  \"single_point\": { \"to_screen_ns\": %.3f, \"to_grid_ns\": %.3f },\n  \"batch\": [\n",
+                scalarScreen, scalarGrid);
+
+    for (std::size_t l = 0; l < levels.size(); ++l) {
+        Math::setSimdLevel(levels[l]);
+
+        double screenNs = bestNsPerPoint(count, repeats, [&] {
+            Math::toScreenCoordinates(64, 64, grid.x.data(), grid.y.data(), outX.data(), outY.data(), count);
+            sink = sink + outX[count - 1];
+        });
+        double gridNs = bestNsPerPoint(count, repeats, [&] {
+            Math::toGridCoordinates(64, 64, screen.x.data(), screen.y.data(), outX.data(), outY.data(), count);
+            sink = sink + outX[count - 1];
+        });
+
+        std::printf("    { \"level\": \"%s\", \"to_screen_ns\": %.3f, \"to_grid_ns\": %.3f, "
+                    "\"to_screen_speedup\": %.2f, \"to_grid_speedup\": %.2f }%s\n",
+                    Math::getSimdLevelName(levels[l]), screenNs, gridNs,
+                    scalarScreen / screenNs, scalarGrid / gridNs, l + 1 < levels.size() ? "," : "");
+    }
+    std::printf("  ]\n}\n");
+
+    Math::setSimdLevel(supported);
+    return 0;
+}
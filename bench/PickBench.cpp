@@ -0,0 +1,235 @@
+// PickBench.cpp
+//
+// Pixel-accurate picking checks and cost. Map::pickTile is first compared
+// with a brute-force pick that tests every drawn sprite in draw order; any
+// mismatch fails the run. Then the cost per pick is measured on maps of
+// growing size, next to the ground-plane inversion it replaces, and printed
+// as JSON. The per-pick cost should not depend on the map size.
+
+#include <SDL3/SDL.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "core/Map.hpp"
+#include "core/TileRegistry.hpp"
+
+namespace {
+
+// Map's default tile size
+constexpr float TILE_SIZE = 64.0f;
+
+struct BenchConfig {
+    int picks = 200000;
+    int layers = 3;
+    int viewWidth = 1280;
+    int viewHeight = 720;
+    unsigned seed = 1;
+};
+
+// Block sprite with a diamond top and transparent corners, like the tile art.
+// Odd variants leave a hole in the top face so the mask has interior gaps.
+SDL_Surface* createTileImage(int variant) {
+    SDL_Surface* surface = SDL_CreateSurface(64, 64, SDL_PIXELFORMAT_RGBA32);
+    if (!surface) {
+        return nullptr;
+    }
+
+    for (int y = 0; y < 64; ++y) {
+        Uint32* row = reinterpret_cast<Uint32*>(static_cast<Uint8*>(surface->pixels) + y * surface->pitch);
+        for (int x = 0; x < 64; ++x) {
+            int dx = std::abs(x - 32);
+            bool topFace = dx * 16 + std::abs(y - 16) * 32 <= 32 * 16;
+            bool bottomFace = dx * 16 + std::abs(y - 48) * 32 <= 32 * 16;
+            bool inside = topFace || bottomFace || (y >= 16 && y <= 48);
+            bool hole = (variant & 1) && dx < 6 && std::abs(y - 16) < 4;
+            row[x] = (inside && !hole) ? SDL_MapSurfaceRGBA(surface, 40 * variant, 120, 200, 255) : 0;
+        }
+    }
+    return surface;
+}
+
+void fillMap(Map& map, int width, int height, unsigned seed) {
+    std::mt19937 rng(seed);
+    map.fillRect(0, 0, width, height, 0, 0);
+
+    // Sparser upper layers so picks fall through to the ones below
+    for (int layer = 1; layer < map.getLayerCount(); ++layer) {
+        unsigned threshold = 100 / (layer * 3);
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                if (rng() % 100 < threshold) {
+                    map.setTile(x, y, layer, static_cast<int>(rng() % 4));
+                }
+            }
+        }
+    }
+}
+
+// Centre the view on the middle of the map
+void centreCamera(Map& map, int width, int height, const BenchConfig& config) {
+    int screenX, screenY;
+    map.gridToScreen(width / 2, height / 2, screenX, screenY);
+    map.setCamera(screenX * map.getCameraZoom() - config.viewWidth * 0.5f,
+                  screenY * map.getCameraZoom() - config.viewHeight * 0.5f);
+}
+
+// Every sprite of every layer in draw order, the last one covering the point wins
+bool bruteForcePick(const Map& map, int screenX, int screenY, int& gridX, int& gridY, int& layer) {
+    const float zoom = map.getCameraZoom();
+    const float pointX = screenX + 0.5f, pointY = screenY + 0.5f;
+    bool found = false;
+
+    for (int l = 0; l < map.getLayerCount(); ++l) {
+        float layerOffset = l * TILE_SIZE * zoom * 0.5f;
+        for (int y = 0; y < map.getHeight(); ++y) {
+            for (int x = 0; x < map.getWidth(); ++x) {
+                const TileType* type = TileRegistry::getType(map.getTileID(x, y, l));
+                if (!type) {
+                    continue;
+                }
+
+                int anchorX, anchorY;
+                map.gridToScreen(x, y, anchorX, anchorY);
+                float spriteX = anchorX * zoom - TILE_SIZE * zoom * 0.5f - map.getCameraX();
+                float spriteY = anchorY * zoom - map.getCameraY() - layerOffset;
+                if (type->isOpaqueAt((pointX - spriteX) / (TILE_SIZE * zoom), (pointY - spriteY) / (TILE_SIZE * zoom))) {
+                    gridX = x;
+                    gridY = y;
+                    layer = l;
+                    found = true;
+                }
+            }
+        }
+    }
+    return found;
+}
+
+int verify(const BenchConfig& config) {
+    int failures = 0;
+    std::mt19937 rng(config.seed);
+    const float zooms[] = { 0.5f, 1.0f, 1.7f, 3.0f };
+
+    for (StorageMode mode : { StorageMode::Dense, StorageMode::Chunked }) {
+        Map map(24, 20, config.layers, SDL_Color{ 0, 0, 0, 255 }, mode);
+        fillMap(map, 24, 20, config.seed);
+
+        // Holes in the bottom layer let picks miss entirely
+        for (int i = 0; i < 60; ++i) {
+            map.removeTile(static_cast<int>(rng() % 24), static_cast<int>(rng() % 20), 0);
+        }
+
+        for (float zoom : zooms) {
+            map.zoomCamera(zoom / map.getCameraZoom());
+            centreCamera(map, 24, 20, config);
+
+            for (int i = 0; i < 2000; ++i) {
+                int screenX = static_cast<int>(rng() % config.viewWidth);
+                int screenY = static_cast<int>(rng() % config.viewHeight);
+
+                int x = -1, y = -1, layer = -1;
+                int expectedX = -1, expectedY = -1, expectedLayer = -1;
+                bool hit = map.pickTile(screenX, screenY, x, y, layer);
+                bool expected = bruteForcePick(map, screenX, screenY, expectedX, expectedY, expectedLayer);
+                if (hit != expected || (hit && (x != expectedX || y != expectedY || layer != expectedLayer))) {
+                    if (failures++ < 10) {
+                        std::fprintf(stderr, "FAILED: pick at (%d, %d) zoom %.1f gave %d (%d, %d, %d), expected %d (%d, %d, %d)\n",
+                                     screenX, screenY, zoom, hit, x, y, layer, expected, expectedX, expectedY, expectedLayer);
+                    }
+                }
+            }
+        }
+    }
+    return failures;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    BenchConfig config;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--picks" && i + 1 < argc) {
+            config.picks = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--layers" && i + 1 < argc) {
+            config.layers = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--seed" && i + 1 < argc) {
+            config.seed = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        } else {
+            std::fprintf(stderr, "usage: isoEngine_pickbench [--picks N] [--layers N] [--seed N]\n");
+            return 2;
+        }
+    }
+
+    // Registration needs a renderer for the atlas, nothing is drawn
+    SDL_Surface* target = SDL_CreateSurface(16, 16, SDL_PIXELFORMAT_ARGB8888);
+    SDL_Renderer* renderer = target ? SDL_CreateSoftwareRenderer(target) : nullptr;
+    if (!renderer) {
+        SDL_Log("Couldn't create software renderer: %s", SDL_GetError());
+        return 1;
+    }
+    for (int variant = 0; variant < 4; ++variant) {
+        SDL_Surface* image = createTileImage(variant);
+        TileRegistry::registerType(variant, "Tile " + std::to_string(variant), renderer, image);
+        SDL_DestroySurface(image);
+    }
+
+    int failures = verify(config);
+    if (failures > 0) {
+        std::fprintf(stderr, "%d picks differ from the brute-force pick\n", failures);
+        return 1;
+    }
+
+    // Same screen points on every map size
+    std::mt19937 rng(config.seed);
+    std::vector<int> pointsX(config.picks), pointsY(config.picks);
+    for (int i = 0; i < config.picks; ++i) {
+        pointsX[i] = static_cast<int>(rng() % config.viewWidth);
+        pointsY[i] = static_cast<int>(rng() % config.viewHeight);
+    }
+
+    std::printf("{\n  \"checks\": \"passed\",\n  \"picks\": %d,\n  \"layers\": %d,\n  \"results\": [\n", config.picks, config.layers);
+
+    const int sizes[] = { 64, 256, 1024, 4096 };
+    double minNs = 0.0, maxNs = 0.0;
+    bool first = true;
+    for (StorageMode mode : { StorageMode::Dense, StorageMode::Chunked }) {
+        for (int size : sizes) {
+            Map map(size, size, config.layers, SDL_Color{ 0, 0, 0, 255 }, mode);
+            fillMap(map, size, size, config.seed);
+            centreCamera(map, size, size, config);
+
+            int hits = 0, x, y, layer;
+            Uint64 start = SDL_GetTicksNS();
+            for (int i = 0; i < config.picks; ++i) {
+                hits += map.pickTile(pointsX[i], pointsY[i], x, y, layer);
+            }
+            double pickNs = static_cast<double>(SDL_GetTicksNS() - start) / config.picks;
+
+            int valid = 0;
+            start = SDL_GetTicksNS();
+            for (int i = 0; i < config.picks; ++i) {
+                valid += map.getSelectedTile(pointsX[i], pointsY[i], x, y);
+            }
+            double planeNs = static_cast<double>(SDL_GetTicksNS() - start) / config.picks;
+
+            minNs = first ? pickNs : std::min(minNs, pickNs);
+            maxNs = first ? pickNs : std::max(maxNs, pickNs);
+            std::printf("%s    { \"storage\": \"%s\", \"size\": %d, \"pick_ns\": %.1f, \"plane_ns\": %.1f, \"hit_rate\": %.3f, \"plane_hit_rate\": %.3f }",
+                        first ? "" : ",\n", mode == StorageMode::Chunked ? "chunked" : "dense", size, pickNs, planeNs,
+                        static_cast<double>(hits) / config.picks, static_cast<double>(valid) / config.picks);
+            first = false;
+        }
+    }
+
+    std::printf("\n  ],\n  \"max_over_min\": %.2f\n}\n", maxNs / minNs);
+
+    TileRegistry::clear();
+    SDL_DestroyRenderer(renderer);
+    SDL_DestroySurface(target);
+    return 0;
+}
@@ -0,0 +1,196 @@
+// ProjectionBench.cpp
+//
+// Picking and vertex generation cost of the compile-time projection
+// policies, against the previous transform that rebuilt and inverted the
+// projection matrix on every call. Each policy is first checked to map
+// every cell centre back to its own cell.
+
+#include <SDL3/SDL.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "utils/Math.hpp"
+
+#if defined(__GNUC__) || defined(__clang__)
+#define BENCH_NOINLINE __attribute__((noinline))
+#else
+#define BENCH_NOINLINE __declspec(noinline)
+#endif
+
+namespace {
+
+constexpr int TILE_SIZE = 64;
+
+// The transform as it was before projection policies, kept out of line
+// like the original Math functions
+BENCH_NOINLINE void legacyToScreen(int w, int h, int gridX, int gridY, int& screenX, int& screenY) {
+    screenX = gridX * 1.0f * 0.5f * w + gridY * -1.0f * 0.5f * w;
+    screenY = gridX * 0.5f * 0.5f * h + gridY * 0.5f * 0.5f * h;
+}
+
+BENCH_NOINLINE void legacyToGrid(int w, int h, int screenX, int screenY, int& gridX, int& gridY) {
+    float a = 1.0f * 0.5f * w;
+    float b = -1.0f * 0.5f * w;
+    float c = 0.5f * 0.5f * h;
+    float d = 0.5f * 0.5f * h;
+
+    Math::invertMatrix(a, b, c, d);
+
+    float rawX = a * screenX + b * screenY;
+    float rawY = c * screenX + d * screenY;
+
+    gridX = static_cast<int>(std::floor(rawX));
+    gridY = static_cast<int>(std::floor(rawY));
+}
+
+template <typename Fn>
+double bestMs(int repeats, Fn&& run) {
+    double best = 1e30;
+    for (int r = 0; r < repeats; ++r) {
+        Uint64 start = SDL_GetTicksNS();
+        run();
+        best = std::min(best, (SDL_GetTicksNS() - start) / 1.0e6);
+    }
+    return best;
+}
+
+// Every cell centre must pick back to the cell it came from
+template <typename Policy>
+bool verifyRoundTrip(int mapSize) {
+    const TileProjection<Policy> projection(TILE_SIZE, TILE_SIZE);
+    const float* forward = projection.getForward();
+    int centreX = static_cast<int>(0.5f * (forward[0] + forward[1]));
+    int centreY = static_cast<int>(0.5f * (forward[2] + forward[3]));
+
+    for (int y = -mapSize; y < mapSize; ++y) {
+        for (int x = -mapSize; x < mapSize; ++x) {
+            int screenX, screenY, gridX, gridY;
+            projection.toScreen(x, y, screenX, screenY);
+            projection.toGrid(screenX + centreX, screenY + centreY, gridX, gridY);
+            if (gridX != x || gridY != y) {
+                std::fprintf(stderr, "%s: cell (%d, %d) picked back as (%d, %d)\n", Policy::name, x, y, gridX, gridY);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+struct Workload {
+    int mapSize;
+    int repeats;
+    std::vector<int> pickX, pickY;
+};
+
+volatile int sink = 0;
+
+template <typename Policy>
+void benchPolicy(const Workload& work, bool last) {
+    const TileProjection<Policy> projection(TILE_SIZE, TILE_SIZE);
+    std::vector<int> outX(work.mapSize), outY(work.mapSize);
+
+    double pickMs = bestMs(work.repeats, [&] {
+        int acc = 0;
+        for (std::size_t i = 0; i < work.pickX.size(); ++i) {
+            int gridX, gridY;
+            projection.toGrid(work.pickX[i], work.pickY[i], gridX, gridY);
+            acc += gridX ^ gridY;
+        }
+        sink = sink + acc;
+    });
+
+    double vertexMs = bestMs(work.repeats, [&] {
+        for (int y = 0; y < work.mapSize; ++y) {
+            for (int x = 0; x < work.mapSize; ++x) {
+                projection.toScreen(x, y, outX[x], outY[x]);
+            }
+            sink = sink + outX[work.mapSize - 1];
+        }
+    });
+
+    std::printf("    { \"projection\": \"%s\", \"pick_ms\": %.3f, \"vertex_ms\": %.3f }%s\n",
+                Policy::name, pickMs, vertexMs, last ? "" : ",");
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    Workload work;
+    work.mapSize = 1024;
+    work.repeats = 10;
+    int picks = 1 << 20;
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        if (arg == "--map") work.mapSize = std::max(1, std::atoi(argv[i + 1]));
+        else if (arg == "--picks") picks = std::max(1, std::atoi(argv[i + 1]));
+        else if (arg == "--repeats") work.repeats = std::max(1, std::atoi(argv[i + 1]));
+    }
+
+    if (!verifyRoundTrip<IsometricProjection>(256) || !verifyRoundTrip<DimetricProjection>(256) ||
+        !verifyRoundTrip<StaggeredProjection>(256)) {
+        return 1;
+    }
+
+    // Picks scattered over the screen area of the whole map
+    std::mt19937 rng(1);
+    std::uniform_int_distribution<int> pickX(-work.mapSize * TILE_SIZE / 2, work.mapSize * TILE_SIZE / 2);
+    std::uniform_int_distribution<int> pickY(0, work.mapSize * TILE_SIZE / 2);
+    for (int i = 0; i < picks; ++i) {
+        work.pickX.push_back(pickX(rng));
+        work.pickY.push_back(pickY(rng));
+    }
+
+    std::vector<int> outX(work.mapSize), outY(work.mapSize), rowX(work.mapSize), rowY(work.mapSize);
+
+    double legacyPickMs = bestMs(work.repeats, [&] {
+        int acc = 0;
+        for (int i = 0; i < picks; ++i) {
+            int gridX, gridY;
+            legacyToGrid(TILE_SIZE, TILE_SIZE, work.pickX[i], work.pickY[i], gridX, gridY);
+            acc += gridX ^ gridY;
+        }
+        sink = sink + acc;
+    });
+    double legacyVertexMs = bestMs(work.repeats, [&] {
+        for (int y = 0; y < work.mapSize; ++y) {
+            for (int x = 0; x < work.mapSize; ++x) {
+                legacyToScreen(TILE_SIZE, TILE_SIZE, x, y, outX[x], outY[x]);
+            }
+            sink = sink + outX[work.mapSize - 1];
+        }
+    });
+
+    // The active projection through the batch API, vertices one row per call
+    std::vector<int> pickedX(picks), pickedY(picks);
+    double batchPickMs = bestMs(work.repeats, [&] {
+        Math::toGridCoordinates(TILE_SIZE, TILE_SIZE, work.pickX.data(), work.pickY.data(), pickedX.data(), pickedY.data(), picks);
+        sink = sink + pickedX[picks - 1];
+    });
+    double batchVertexMs = bestMs(work.repeats, [&] {
+        for (int y = 0; y < work.mapSize; ++y) {
+            std::iota(rowX.begin(), rowX.end(), 0);
+            std::fill(rowY.begin(), rowY.end(), y);
+            Math::toScreenCoordinates(TILE_SIZE, TILE_SIZE, rowX.data(), rowY.data(), outX.data(), outY.data(), work.mapSize);
+            sink = sink + outX[work.mapSize - 1];
+        }
+    });
+
+    std::printf("{\n  \"map\": %d,\n  \"picks\": %d,\n  \"verified\": true,\n", work.mapSize, picks);
+    std::printf("  \"legacy\": { \"pick_ms\": %.3f, \"vertex_ms\": %.3f },\n", legacyPickMs, legacyVertexMs);
+    std::printf("  \"batch\": { \"projection\": \"%s\", \"simd\": \"%s\", \"pick_ms\": %.3f, \"vertex_ms\": %.3f },\n",
+                ActiveProjection::name, Math::getSimdLevelName(Math::getSimdLevel()), batchPickMs, batchVertexMs);
+    std::printf("  \"policies\": [\n");
+    benchPolicy<IsometricProjection>(work, false);
+    benchPolicy<DimetricProjection>(work, false);
+    benchPolicy<StaggeredProjection>(work, true);
+    std::printf("  ]\n}\n");
+    return 0;
+}
@@ -0,0 +1,355 @@
+// RenderBench.cpp
+//
+// Headless frame-cost benchmark. Renders a generated map through a scripted
+// camera path with SDL's software renderer (no window, no vsync) and prints
+// frame time, draw call and tile statistics as JSON.
+
+#include <SDL3/SDL.h>
+#include <SDL3_image/SDL_image.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "core/Map.hpp"
+#include "core/TileRegistry.hpp"
+#include "core/JobSystem.hpp"
+#include "utils/Statistics.hpp"
+
+namespace {
+
+struct BenchConfig {
+    int width = 256;
+    int height = 256;
+    int layers = 2;
+    float density = 1.0f;       // Chance of a cell holding a tile, per layer
+    int frames = 600;
+    int warmupFrames = 30;
+    int viewWidth = 1280;
+    int viewHeight = 720;
+    unsigned seed = 1;
+    int threads = 1;            // Render-list threads, 1 builds on the calling thread
+    RenderMode renderMode = RenderMode::Batched;
+    StorageMode storageMode = StorageMode::Dense;
+    std::string assetDir = "assets";
+    std::string outputPath;     // JSON goes to stdout when empty
+};
+
+struct Summary {
+    double min = 0, mean = 0, p50 = 0, p99 = 0, max = 0;
+};
+
+const char* renderModeName(RenderMode mode) {
+    switch (mode) {
+        case RenderMode::PerTile: return "pertile";
+        case RenderMode::Batched: return "batched";
+        case RenderMode::ChunkCached: return "cached";
+    }
+    return "unknown";
+}
+
+void printUsage() {
+    std::fprintf(stderr,
+        "usage: isoEngine_bench [options]\n"
+        "  --size WxH          map size in tiles (default 256x256)\n"
+        "  --layers N          layer count (default 2)\n"
+        "  --density F         fill probability per cell and layer, 0..1 (default 1)\n"
+        "  --frames N          measured frames (default 600)\n"
+        "  --warmup N          unmeasured frames before measuring (default 30)\n"
+        "  --view WxH          render target size (default 1280x720)\n"
+        "  --mode M            pertile | batched | cached (default batched)\n"
+        "  --storage S         dense | chunked (default dense)\n"
+        "  --seed N            map generation seed (default 1)\n"
+        "  --threads N         render-list threads, 0 for one per core (default 1)\n"
+        "  --assets DIR        tile image directory (default assets)\n"
+        "  --output FILE       write JSON to FILE instead of stdout\n");
+}
+
+bool parseSize(const char* text, int& width, int& height) {
+    return std::sscanf(text, "%dx%d", &width, &height) == 2 && width > 0 && height > 0;
+}
+
+bool parseArgs(int argc, char* argv[], BenchConfig& config) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        const char* value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+
+        if (arg == "--help" || arg == "-h") {
+            return false;
+        }
+        if (!value) {
+            std::fprintf(stderr, "missing value for %s\n", arg.c_str());
+            return false;
+        }
+        ++i;
+
+        if (arg == "--size") {
+            if (!parseSize(value, config.width, config.height)) return false;
+        } else if (arg == "--layers") {
+            config.layers = std::max(1, std::atoi(value));
+        } else if (arg == "--density") {
+            config.density = std::clamp(static_cast<float>(std::atof(value)), 0.0f, 1.0f);
+        } else if (arg == "--frames") {
+            config.frames = std::max(1, std::atoi(value));
+        } else if (arg == "--warmup") {
+            config.warmupFrames = std::max(0, std::atoi(value));
+        } else if (arg == "--view") {
+            if (!parseSize(value, config.viewWidth, config.viewHeight)) return false;
+        } else if (arg == "--mode") {
+            std::string mode = value;
+            if (mode == "pertile") config.renderMode = RenderMode::PerTile;
+            else if (mode == "batched") config.renderMode = RenderMode::Batched;
+            else if (mode == "cached") config.renderMode = RenderMode::ChunkCached;
+            else return false;
+        } else if (arg == "--storage") {
+            std::string storage = value;
+            if (storage == "dense") config.storageMode = StorageMode::Dense;
+            else if (storage == "chunked") config.storageMode = StorageMode::Chunked;
+            else return false;
+        } else if (arg == "--seed") {
+            config.seed = static_cast<unsigned>(std::strtoul(value, nullptr, 10));
+        } else if (arg == "--threads") {
+            config.threads = std::max(0, std::atoi(value));
+        } else if (arg == "--assets") {
+            config.assetDir = value;
+        } else if (arg == "--output") {
+            config.outputPath = value;
+        } else {
+            std::fprintf(stderr, "unknown option %s\n", arg.c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+// Flat-colored diamond block used when the asset images are not available
+SDL_Surface* createFallbackTile(Uint8 r, Uint8 g, Uint8 b) {
+    SDL_Surface* surface = SDL_CreateSurface(64, 64, SDL_PIXELFORMAT_RGBA32);
+    if (!surface) {
+        return nullptr;
+    }
+
+    for (int y = 0; y < 64; ++y) {
+        Uint32* row = reinterpret_cast<Uint32*>(static_cast<Uint8*>(surface->pixels) + y * surface->pitch);
+        for (int x = 0; x < 64; ++x) {
+            // Top face diamond swept down by half a tile to form the block
+            int dx = std::abs(x - 32);
+            bool topFace = dx * 16 + std::abs(y - 16) * 32 <= 32 * 16;
+            bool bottomFace = dx * 16 + std::abs(y - 48) * 32 <= 32 * 16;
+            bool inside = topFace || bottomFace || (y >= 16 && y <= 48);
+            row[x] = inside ? SDL_MapSurfaceRGBA(surface, r, g, b, 255) : 0;
+        }
+    }
+    return surface;
+}
+
+// Register the engine's tile set, falling back to generated images
+int registerTileTypes(SDL_Renderer* renderer, const std::string& assetDir) {
+    struct TileSource {
+        const char* name;
+        const char* file;
+        Uint8 r, g, b;
+    };
+    const TileSource sources[] = {
+        { "Void", "void.png", 40, 40, 50 },
+        { "Grass", "grass.png", 90, 170, 60 },
+        { "Sand", "sand.png", 220, 200, 120 },
+        { "Water", "water.png", 60, 110, 210 },
+        { "Stone", "stone.png", 130, 130, 140 },
+        { "Lily pad", "water_lily_pad.png", 70, 150, 120 },
+        { "Mountains", "mountains.png", 150, 110, 90 },
+    };
+
+    int id = 0;
+    for (const TileSource& source : sources) {
+        std::string path = assetDir + "/" + source.file;
+        SDL_Surface* surface = IMG_Load(path.c_str());
+        if (!surface) {
+            surface = createFallbackTile(source.r, source.g, source.b);
+        }
+        TileRegistry::registerType(id++, source.name, renderer, surface);
+        SDL_DestroySurface(surface);
+    }
+    return id;
+}
+
+void generateMap(Map& map, const BenchConfig& config, int typeCount) {
+    std::mt19937 rng(config.seed);
+    std::uniform_real_distribution<float> chance(0.0f, 1.0f);
+    std::uniform_int_distribution<int> type(0, typeCount - 1);
+
+    for (int layer = 0; layer < config.layers; ++layer) {
+        for (int y = 0; y < config.height; ++y) {
+            for (int x = 0; x < config.width; ++x) {
+                if (chance(rng) < config.density) {
+                    map.setTile(x, y, layer, type(rng));
+                }
+            }
+        }
+    }
+}
+
+// Camera path: one diagonal sweep across the map while zoom oscillates
+// through its full range, ending back at the start
+void placeCamera(Map& map, const BenchConfig& config, int frame, int frameCount) {
+    float t = static_cast<float>(frame) / static_cast<float>(std::max(1, frameCount));
+    float sweep = 1.0f - std::fabs(2.0f * t - 1.0f);
+    float zoom = 1.25f + 0.75f * std::sin(t * 6.2831853f * 2.0f);
+
+    map.zoomCamera(zoom / map.getCameraZoom());
+
+    int screenX, screenY;
+    map.gridToScreen(static_cast<int>(sweep * (config.width - 1)), static_cast<int>(sweep * (config.height - 1)), screenX, screenY);
+
+    float cameraZoom = map.getCameraZoom();
+    map.setCamera(screenX * cameraZoom - config.viewWidth * 0.5f, screenY * cameraZoom - config.viewHeight * 0.5f);
+}
+
+Summary summarize(std::vector<double> values) {
+    Summary summary;
+    if (values.empty()) {
+        return summary;
+    }
+
+    std::sort(values.begin(), values.end());
+    double total = 0;
+    for (double value : values) {
+        total += value;
+    }
+
+    summary.min = values.front();
+    summary.max = values.back();
+    summary.mean = total / values.size();
+    summary.p50 = Statistics::percentile(values, 0.50);
+    summary.p99 = Statistics::percentile(values, 0.99);
+    return summary;
+}
+
+void writeSummary(FILE* out, const char* name, const Summary& summary, bool last = false) {
+    std::fprintf(out, "    \"%s\": { \"min\": %.4f, \"mean\": %.4f, \"p50\": %.4f, \"p99\": %.4f, \"max\": %.4f }%s\n",
+                 name, summary.min, summary.mean, summary.p50, summary.p99, summary.max, last ? "" : ",");
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    BenchConfig config;
+    if (!parseArgs(argc, argv, config)) {
+        printUsage();
+        return 2;
+    }
+
+    // Software renderer drawing into a plain surface, no display needed
+    SDL_Surface* target = SDL_CreateSurface(config.viewWidth, config.viewHeight, SDL_PIXELFORMAT_ARGB8888);
+    SDL_Renderer* renderer = target ? SDL_CreateSoftwareRenderer(target) : nullptr;
+    if (!renderer) {
+        SDL_Log("Couldn't create software renderer: %s", SDL_GetError());
+        return 1;
+    }
+
+    int typeCount = registerTileTypes(renderer, config.assetDir);
+
+    Uint64 generateStart = SDL_GetTicksNS();
+    Map map(config.width, config.height, config.layers, SDL_Color{ 30, 30, 40, 255 }, config.storageMode);
+    map.setRenderMode(config.renderMode);
+    generateMap(map, config, typeCount);
+    double generateMs = (SDL_GetTicksNS() - generateStart) / 1.0e6;
+
+    std::unique_ptr<JobSystem> workers;
+    if (config.threads != 1) {
+        workers = std::make_unique<JobSystem>(config.threads);
+    }
+    int threadCount = workers ? workers->getThreadCount() : 1;
+
+    // The parallel path must produce the same image as the serial one
+    bool verified = true;
+    if (workers) {
+        placeCamera(map, config, 0, config.frames);
+        size_t targetBytes = static_cast<size_t>(target->pitch) * target->h;
+
+        SDL_SetRenderDrawColor(renderer, 30, 30, 40, 255);
+        SDL_RenderClear(renderer);
+        map.renderWithCamera(renderer, map.getCameraX(), map.getCameraY());
+        SDL_FlushRenderer(renderer);
+        std::vector<Uint8> serialPixels(static_cast<Uint8*>(target->pixels), static_cast<Uint8*>(target->pixels) + targetBytes);
+        int serialTiles = map.getRenderStats().tilesDrawn;
+
+        SDL_RenderClear(renderer);
+        map.renderWithCamera(renderer, map.getCameraX(), map.getCameraY(), workers.get());
+        SDL_FlushRenderer(renderer);
+        verified = serialTiles == map.getRenderStats().tilesDrawn &&
+                   std::memcmp(serialPixels.data(), target->pixels, targetBytes) == 0;
+        if (!verified) {
+            SDL_Log("Parallel render list differs from the serial one");
+        }
+    }
+
+    std::vector<double> frameMs, drawCalls, tilesDrawn, tilesVisited;
+    frameMs.reserve(config.frames);
+    drawCalls.reserve(config.frames);
+    tilesDrawn.reserve(config.frames);
+    tilesVisited.reserve(config.frames);
+
+    for (int frame = -config.warmupFrames; frame < config.frames; ++frame) {
+        placeCamera(map, config, std::max(frame, 0), config.frames);
+
+        Uint64 start = SDL_GetTicksNS();
+        SDL_SetRenderDrawColor(renderer, 30, 30, 40, 255);
+        SDL_RenderClear(renderer);
+        map.renderWithCamera(renderer, map.getCameraX(), map.getCameraY(), workers.get());
+        SDL_RenderPresent(renderer);
+        SDL_FlushRenderer(renderer);
+        Uint64 end = SDL_GetTicksNS();
+
+        if (frame < 0) {
+            continue;
+        }
+
+        const RenderStats& stats = map.getRenderStats();
+        frameMs.push_back((end - start) / 1.0e6);
+        drawCalls.push_back(stats.drawCalls);
+        tilesDrawn.push_back(stats.tilesDrawn);
+        tilesVisited.push_back(stats.tilesVisited);
+    }
+
+    FILE* out = stdout;
+    if (!config.outputPath.empty()) {
+        out = std::fopen(config.outputPath.c_str(), "w");
+        if (!out) {
+            SDL_Log("Couldn't open %s for writing", config.outputPath.c_str());
+            return 1;
+        }
+    }
+
+    std::fprintf(out, "{\n");
+    std::fprintf(out, "  \"config\": { \"width\": %d, \"height\": %d, \"layers\": %d, \"density\": %.3f, "
+                      "\"frames\": %d, \"view\": [%d, %d], \"mode\": \"%s\", \"storage\": \"%s\", \"seed\": %u, \"threads\": %d },\n",
+                 config.width, config.height, config.layers, config.density, config.frames,
+                 config.viewWidth, config.viewHeight, renderModeName(config.renderMode),
+                 config.storageMode == StorageMode::Chunked ? "chunked" : "dense", config.seed, threadCount);
+    std::fprintf(out, "  \"verified\": %s,\n", verified ? "true" : "false");
+    std::fprintf(out, "  \"generate_ms\": %.3f,\n", generateMs);
+    std::fprintf(out, "  \"map_bytes\": %zu,\n", map.getMemoryUsage());
+    std::fprintf(out, "  \"stats\": {\n");
+    writeSummary(out, "frame_ms", summarize(frameMs));
+    writeSummary(out, "draw_calls", summarize(drawCalls));
+    writeSummary(out, "tiles_drawn", summarize(tilesDrawn));
+    writeSummary(out, "tiles_visited", summarize(tilesVisited), true);
+    std::fprintf(out, "  }\n}\n");
+
+    if (out != stdout) {
+        std::fclose(out);
+    }
+
+    TileRegistry::clear();
+    SDL_DestroyRenderer(renderer);
+    SDL_DestroySurface(target);
+    SDL_Quit();
+    return verified ? 0 : 1;
+}
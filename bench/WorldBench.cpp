@@ -0,0 +1,238 @@
+// WorldBench.cpp
+//
+// Opening a memory-mapped world against loading the same map from a
+// chunked map file, and how resident memory follows the area the camera
+// walks over rather than the size of the world. A small world is checked
+// first: it must read back like the map it was saved from, keep edits out
+// of the file until flushed and persist them after; any mismatch fails the
+// run.
+
+#include <SDL3/SDL.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "core/Map.hpp"
+#include "core/MapIO.hpp"
+#include "utils/BinaryIO.hpp"
+#include "utils/MappedFile.hpp"
+#include "BenchUtils.hpp"
+
+using Bench::check;
+using Bench::elapsedMs;
+
+namespace {
+
+// Resident set of the process in bytes, 0 where it can't be read
+size_t getResidentBytes() {
+#ifdef __linux__
+    FILE* statm = std::fopen("/proc/self/statm", "r");
+    if (!statm) {
+        return 0;
+    }
+    unsigned long pages = 0, resident = 0;
+    int read = std::fscanf(statm, "%lu %lu", &pages, &resident);
+    std::fclose(statm);
+    return read == 2 ? resident * MappedFile::getPageSize() : 0;
+#else
+    return 0;
+#endif
+}
+
+// Ground everywhere, decoration and gaps scattered on the second layer
+std::unique_ptr<Map> buildMap(int width, int height, unsigned seed) {
+    const SDL_Color color = { 20, 30, 40, 255 };
+    auto map = std::make_unique<Map>(width, height, 2, color, StorageMode::Dense);
+    std::mt19937 rng(seed);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            map->setTile(x, y, 0, static_cast<int>((x / 16 + y / 16) % 4));
+            if (rng() % 100 < 5) {
+                map->setTile(x, y, 1, 4 + static_cast<int>(rng() % 4));
+            }
+        }
+    }
+    return map;
+}
+
+uint64_t hashRegion(const Map& map, int x, int y, int width, int height) {
+    uint64_t hash = 14695981039346656037ull;
+    for (int layer = 0; layer < map.getLayerCount(); ++layer) {
+        for (int row = y; row < y + height; ++row) {
+            for (int column = x; column < x + width; ++column) {
+                hash = (hash ^ static_cast<uint16_t>(map.getTileID(column, row, layer))) * 1099511628211ull;
+            }
+        }
+    }
+    return hash;
+}
+
+void verify(const std::string& path) {
+    auto map = buildMap(300, 200, 7);
+    check(MapIO::saveWorld(*map, path), "world saves");
+
+    std::vector<uint8_t> saved;
+    BinaryIO::readFile(path, saved);
+    check(saved.size() % MapIO::WORLD_ALIGNMENT == 0, "world layers are aligned");
+
+    auto world = MapIO::openWorld(path);
+    check(world && world->getStorageMode() == StorageMode::Mapped, "world opens mapped");
+    check(world && world->computeStateHash() == map->computeStateHash(), "world reads back");
+    auto loaded = MapIO::loadMap(path);
+    check(loaded && loaded->getStorageMode() == StorageMode::Mapped, "loadMap opens worlds");
+    if (!world) {
+        return;
+    }
+
+    // Edits stay in memory until flushed
+    check(world->getMemoryUsage() < MappedFile::getPageSize(), "clean world holds no private pages");
+    std::mt19937 rng(5);
+    for (int i = 0; i < 500; ++i) {
+        int x = static_cast<int>(rng() % 300), y = static_cast<int>(rng() % 200), layer = static_cast<int>(rng() % 2);
+        int id = rng() % 3 == 0 ? -1 : static_cast<int>(rng() % 8);
+        if (id < 0) {
+            world->removeTile(x, y, layer);
+            map->removeTile(x, y, layer);
+        } else {
+            world->setTile(x, y, layer, id);
+            map->setTile(x, y, layer, id);
+        }
+    }
+    world->fillRect(10, 10, 120, 30, 1, 3);
+    map->fillRect(10, 10, 120, 30, 1, 3);
+    check(world->computeStateHash() == map->computeStateHash(), "world takes edits");
+    check(world->getMemoryUsage() > 0, "edited world holds private pages");
+
+    std::vector<uint8_t> unflushed;
+    BinaryIO::readFile(path, unflushed);
+    check(unflushed == saved, "edits stay out of the file until flushed");
+
+    check(world->flush(), "world flushes");
+    check(world->getMemoryUsage() < MappedFile::getPageSize(), "flush releases private pages");
+    check(world->computeStateHash() == map->computeStateHash(), "world reads the same after flush");
+
+    world.reset();
+    auto reopened = MapIO::openWorld(path);
+    check(reopened && reopened->computeStateHash() == map->computeStateHash(), "flushed edits persist");
+
+    // Worlds save back to the chunked format as dense maps
+    check(MapIO::saveMap(*reopened, path + ".isomap"), "world saves as a map file");
+    auto converted = MapIO::loadMap(path + ".isomap");
+    check(converted && converted->getStorageMode() == StorageMode::Dense
+          && converted->computeStateHash() == map->computeStateHash(), "map file of a world loads back");
+    std::remove((path + ".isomap").c_str());
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    int size = 8192;
+    int repeats = 3;
+    std::string path = "isoEngine_worldbench.isoworld";
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--size" && i + 1 < argc) {
+            size = std::max(256, std::atoi(argv[++i]));
+        } else if (arg == "--repeats" && i + 1 < argc) {
+            repeats = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--file" && i + 1 < argc) {
+            path = argv[++i];
+        } else {
+            std::fprintf(stderr, "usage: isoEngine_worldbench [--size N] [--repeats N] [--file path]\n");
+            return 2;
+        }
+    }
+
+    verify(path);
+    std::remove(path.c_str());
+    if (Bench::failures > 0) {
+        std::fprintf(stderr, "%d world checks failed\n", Bench::failures);
+        return 1;
+    }
+
+    // Written once, then the map is dropped so it doesn't count as resident
+    const std::string mapPath = path + ".isomap";
+    {
+        auto map = buildMap(size, size, 1);
+        MapIO::saveWorld(*map, path);
+        MapIO::saveMap(*map, mapPath);
+    }
+    auto best = [repeats](auto function) {
+        double bestMs = 0.0;
+        for (int i = 0; i < repeats; ++i) {
+            Uint64 start = SDL_GetTicksNS();
+            function();
+            double ms = elapsedMs(start);
+            bestMs = i == 0 ? ms : std::min(bestMs, ms);
+        }
+        return bestMs;
+    };
+    double loadMs = best([&] { MapIO::loadMap(mapPath); });
+    double openMs = best([&] { MapIO::openWorld(path); });
+
+    // After loading, so memory the allocator kept from it is in the baseline
+    const size_t startRss = getResidentBytes();
+
+    auto world = MapIO::openWorld(path);
+    if (!world) {
+        std::fprintf(stderr, "couldn't open %s\n", path.c_str());
+        return 1;
+    }
+    const size_t openRss = getResidentBytes();
+
+    // Roughly the cells a 1280x720 view shows at zoom 1, walked diagonally
+    // across the world
+    const int viewWidth = 40, viewHeight = 40, steps = 64;
+    uint64_t viewHash = 0;
+    Uint64 start = SDL_GetTicksNS();
+    viewHash ^= hashRegion(*world, size / 2, size / 2, viewWidth, viewHeight);
+    double firstViewMs = elapsedMs(start);
+    const size_t viewRss = getResidentBytes();
+
+    start = SDL_GetTicksNS();
+    for (int step = 0; step < steps; ++step) {
+        int offset = static_cast<int>(static_cast<long long>(size - viewWidth) * step / steps);
+        viewHash ^= hashRegion(*world, offset, offset, viewWidth, viewHeight);
+    }
+    double walkMs = elapsedMs(start);
+    const size_t walkRss = getResidentBytes();
+
+    start = SDL_GetTicksNS();
+    world->fillRect(size / 2, size / 2, viewWidth, viewHeight, 1, 2);
+    double editMs = elapsedMs(start);
+    const size_t editBytes = world->getMemoryUsage();
+    start = SDL_GetTicksNS();
+    bool flushed = world->flush();
+    double flushMs = elapsedMs(start);
+
+    std::vector<uint8_t> bytes;
+    size_t worldBytes = 0, mapBytes = 0;
+    if (BinaryIO::readFile(mapPath, bytes)) {
+        mapBytes = bytes.size();
+    }
+    MappedFile probe;
+    if (probe.open(path, MappedFile::Access::ReadOnly)) {
+        worldBytes = probe.getSize();
+    }
+    probe.close();
+
+    std::printf("{\n  \"checks\": \"passed\",\n  \"size\": %d,\n  \"layers\": 2,\n"
+                "  \"world_bytes\": %zu,\n  \"map_file_bytes\": %zu,\n"
+                "  \"map_file_load_ms\": %.2f,\n  \"world_open_ms\": %.3f,\n"
+                "  \"first_view_ms\": %.3f,\n  \"walk_views\": %d,\n  \"walk_ms\": %.2f,\n"
+                "  \"rss_start_bytes\": %zu,\n  \"rss_open_bytes\": %zu,\n  \"rss_first_view_bytes\": %zu,\n  \"rss_walk_bytes\": %zu,\n"
+                "  \"edit_ms\": %.3f,\n  \"edit_private_bytes\": %zu,\n  \"flush_ms\": %.3f,\n  \"flushed\": %s,\n"
+                "  \"view_hash\": %llu\n}\n",
+                size, worldBytes, mapBytes, loadMs, openMs, firstViewMs, steps, walkMs,
+                startRss, openRss, viewRss, walkRss, editMs, editBytes, flushMs, flushed ? "true" : "false",
+                static_cast<unsigned long long>(viewHash));
+
+    world.reset();
+    std::remove(path.c_str());
+    std::remove(mapPath.c_str());
+    return 0;
+}
@@ -1,6 +1,8 @@
 #include "UI/UIDebug.hpp"
+#include "core/EditJournal.hpp"
 #include "core/Engine.hpp"
 #include "imgui.h"
+#include "utils/Profiler.hpp"
 
 UIDebug::UIDebug(IsoEngine *engineRef) : engine(engineRef) {
     // Initialize window visibility states
@@ -53,13 +55,18 @@ void UIDebug::drawMainMenuBar() {
         // Quick stats in menu bar
         ImGui::Text("| FPS: %.1f", ImGui::GetIO().Framerate);
         ImGui::Text("| Frame: %.2fms", ImGui::GetIO().DeltaTime * 1000.0f);
-        
+        if (engine->isRecording()) {
+            ImGui::TextColored(ImVec4(1.0f, 0.3f, 0.3f, 1.0f), "| REC");
+        } else if (engine->isReplaying()) {
+            ImGui::Text("| REPLAY");
+        }
+
         ImGui::EndMainMenuBar();
     }
 }
 
 void UIDebug::drawPerformanceWindow() {
-    ImGui::SetNextWindowSize(ImVec2(350, 200), ImGuiCond_FirstUseEver);
+    ImGui::SetNextWindowSize(ImVec2(380, 520), ImGuiCond_FirstUseEver);
     ImGui::SetNextWindowPos(ImVec2(10, 30), ImGuiCond_FirstUseEver);
     
     if (ImGui::Begin("Performance Monitor", &showPerformanceWindow)) {
@@ -89,6 +96,46 @@ void UIDebug::drawPerformanceWindow() {
         // Performance metrics
         ImGui::Separator();
         ImGui::Text("Target: 60 FPS (16.67ms)");
+
+        ImGui::Checkbox("Render on demand", &engine->onDemandRendering);
+        ImGui::Checkbox("Parallel render lists", &engine->parallelRenderLists);
+
+        // Map render counters from the last frame
+        Map* currentMap = engine->gameLevels[engine->activeLevelIndex]->getCurrentMap();
+        const RenderStats& stats = currentMap->getRenderStats();
+        ImGui::Text("Tiles visited: %d", stats.tilesVisited);
+        ImGui::Text("Tiles drawn: %d", stats.tilesDrawn);
+        ImGui::Text("Draw calls: %d", stats.drawCalls);
+
+        // A/B switch between the render paths
+        RenderMode mode = currentMap->getRenderMode();
+        if (ImGui::RadioButton("Per tile", mode == RenderMode::PerTile)) {
+            currentMap->setRenderMode(RenderMode::PerTile);
+        }
+        ImGui::SameLine();
+        if (ImGui::RadioButton("Batched", mode == RenderMode::Batched)) {
+            currentMap->setRenderMode(RenderMode::Batched);
+        }
+        ImGui::SameLine();
+        if (ImGui::RadioButton("Chunk cache", mode == RenderMode::ChunkCached)) {
+            currentMap->setRenderMode(RenderMode::ChunkCached);
+        }
+
+        // Chunk texture cache counters
+        if (mode == RenderMode::ChunkCached) {
+            ChunkCache& cache = currentMap->getChunkCache();
+            const ChunkCacheStats& cacheStats = cache.getStats();
+            ImGui::Text("Chunk hits: %d  misses: %d", cacheStats.hits, cacheStats.misses);
+            ImGui::Text("Rebakes: %d  evictions: %d", cacheStats.rebakes, cacheStats.evictions);
+            ImGui::Text("Cache: %zu chunks, %.1f / %.1f MB", cache.getEntryCount(),
+                        cache.getResidentBytes() / (1024.0f * 1024.0f),
+                        cache.getBudget() / (1024.0f * 1024.0f));
+
+            int budgetMB = static_cast<int>(cache.getBudget() / (1024 * 1024));
+            if (ImGui::SliderInt("Budget (MB)", &budgetMB, 16, 2048)) {
+                cache.setBudget(static_cast<size_t>(budgetMB) * 1024 * 1024);
+            }
+        }
         
         // Color-coded performance status
         if (currentFrameTime < 16.67f) {
@@ -103,6 +150,100 @@ void UIDebug::drawPerformanceWindow() {
             maxFrameTime = 16.67f;
             memset(frameTimeHistory, 0, sizeof(frameTimeHistory));
         }
+
+#if defined(ISOENGINE_PROFILING)
+        // Per-zone breakdown of the recent frames still held by the profiler
+        ImGui::SeparatorText("Profiler");
+
+        bool profiling = Profiler::isEnabled();
+        if (ImGui::Checkbox("Record zones", &profiling)) {
+            Profiler::setEnabled(profiling);
+        }
+        ImGui::SameLine();
+
+        static char exportStatus[128] = "";
+        if (ImGui::Button("Export trace")) {
+            const char* tracePath = "isoEngine_trace.json";
+            if (Profiler::exportChromeTrace(tracePath)) {
+                SDL_snprintf(exportStatus, sizeof(exportStatus), "Saved %s", tracePath);
+            } else {
+                SDL_snprintf(exportStatus, sizeof(exportStatus), "Export failed");
+            }
+        }
+        if (exportStatus[0]) {
+            ImGui::TextDisabled("%s", exportStatus);
+        }
+
+        // Sorting every zone sample is not free, refresh a few times a second
+        static std::vector<ProfileZoneStats> zoneStats;
+        static Uint64 zoneStatsTicks = 0;
+        if (SDL_GetTicks() - zoneStatsTicks >= 250) {
+            Profiler::collectZoneStats(zoneStats);
+            zoneStatsTicks = SDL_GetTicks();
+        }
+
+        if (ImGui::BeginTable("Zones", 5, ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders)) {
+            ImGui::TableSetupColumn("Zone");
+            ImGui::TableSetupColumn("Count");
+            ImGui::TableSetupColumn("p50 ms");
+            ImGui::TableSetupColumn("p95 ms");
+            ImGui::TableSetupColumn("p99 ms");
+            ImGui::TableHeadersRow();
+
+            for (const ProfileZoneStats& zone : zoneStats) {
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(zone.name.c_str());
+                ImGui::TableNextColumn();
+                ImGui::Text("%d", zone.count);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f", zone.p50Ms);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f", zone.p95Ms);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f", zone.p99Ms);
+            }
+            ImGui::EndTable();
+        }
+#endif
+
+        // Time spent in each kind of job since the last reset
+        if (engine->jobSystem) {
+            ImGui::SeparatorText("Jobs");
+            ImGui::Text("Threads: %d", engine->jobSystem->getThreadCount());
+            ImGui::SameLine();
+            if (ImGui::Button("Reset jobs")) {
+                engine->jobSystem->resetJobStats();
+            }
+
+            static std::vector<JobStats> jobStats;
+            static Uint64 jobStatsTicks = 0;
+            if (SDL_GetTicks() - jobStatsTicks >= 250) {
+                engine->jobSystem->collectJobStats(jobStats);
+                jobStatsTicks = SDL_GetTicks();
+            }
+
+            if (ImGui::BeginTable("Jobs", 4, ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders)) {
+                ImGui::TableSetupColumn("Job");
+                ImGui::TableSetupColumn("Count");
+                ImGui::TableSetupColumn("Mean ms");
+                ImGui::TableSetupColumn("Max ms");
+                ImGui::TableHeadersRow();
+
+                for (const JobStats& job : jobStats) {
+                    ImGui::TableNextRow();
+                    ImGui::TableNextColumn();
+                    ImGui::TextUnformatted(job.name.c_str());
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%d", job.count);
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%.3f", job.totalMs / job.count);
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%.3f", job.maxMs);
+                }
+                ImGui::EndTable();
+            }
+        }
     }
     ImGui::End();
 }
@@ -122,25 +263,29 @@ void UIDebug::drawTileInspectorWindow() {
             ImGui::TextColored(ImVec4(0.0f, 1.0f, 0.0f, 1.0f), "Tile Selected");
             ImGui::Text("Grid Position: (%d, %d)", engine->selectedTileX, engine->selectedTileY);
             
-            Tile* selectedTile = currentMap->getTile(engine->selectedTileX, engine->selectedTileY, engine->selectedLayer);
+            // The picked tile, or the current layer's cell when nothing was hit
+            int layer = engine->selectedTileLayer >= 0 ? engine->selectedTileLayer : engine->selectedLayer;
+            std::optional<Tile> selectedTile = currentMap->getTile(engine->selectedTileX, engine->selectedTileY, layer);
             if (selectedTile) {
                 ImGui::Text("Tile ID: %d", selectedTile->getID());
                 ImGui::Text("Screen Position: (%d, %d)", selectedTile->getScreenX(), selectedTile->getScreenY());
-                ImGui::Text("Layer: %d", engine->selectedLayer);
+                ImGui::Text("Layer: %d", layer);
                 
                 // Tile preview if texture exists
-                SDL_Texture* tex = selectedTile->getTexture();
-                if (tex) {
+                auto type = TileRegistry::getType(selectedTile->getID());
+                if (type && type->getTexture()) {
                     ImGui::Separator();
                     ImGui::Text("Preview:");
                     ImVec2 size(64, 64);
-                    ImGui::Image((ImTextureID)tex, size);
+                    const SDL_FRect& uv = type->getUVRect();
+                    ImGui::Image((ImTextureID)type->getTexture(), size, ImVec2(uv.x, uv.y), ImVec2(uv.x + uv.w, uv.y + uv.h));
+                    ImGui::Text("Atlas Page: %d", type->getAtlasPage());
                 }
                 
                 // Quick tile operations
                 ImGui::Separator();
                 if (ImGui::Button("Delete Tile")) {
-                    currentMap->removeTile(engine->selectedTileX, engine->selectedTileY, engine->selectedLayer);
+                    currentMap->getJournal().setTile(engine->selectedTileX, engine->selectedTileY, layer, -1);
                 }
                 ImGui::SameLine();
                 if (ImGui::Button("Replace Tile")) {
@@ -188,16 +333,42 @@ void UIDebug::drawLevelManagerWindow() {
         
         // Map Management
         ImGui::SeparatorText("Map Management");
-        ImGui::Text("Map Size: %dx%d", currentMap->getWidth(), currentMap->getHeight());
+        if (currentMap->isBounded()) {
+            ImGui::Text("Map Size: %dx%d", currentMap->getWidth(), currentMap->getHeight());
+        } else {
+            ImGui::Text("Map Size: unbounded");
+        }
+        const StorageMode storageMode = currentMap->getStorageMode();
+        ImGui::Text("Storage: %s", storageMode == StorageMode::Chunked ? "Chunked"
+                                   : storageMode == StorageMode::Mapped ? "Mapped" : "Dense");
+        ImGui::Text("Projection: %s", ActiveProjection::name);
         ImGui::Text("Layer Count: %d", currentMap->getLayerCount());
+        ImGui::Text("Tile Storage: %.1f KB", currentMap->getMemoryUsage() / 1024.0f);
         ImGui::Text("Current Layer: %d", engine->selectedLayer);
+        if (storageMode == StorageMode::Mapped && ImGui::Button("Flush to File")) {
+            currentMap->flush();
+        }
         
         // if (ImGui::Button("Previous Map")) {
         //     engine->gameLevels[engine->activeLevelIndex]->previousMap();
         // }
         ImGui::SameLine();
         if (ImGui::Button("Next Map")) {
-            engine->gameLevels[engine->activeLevelIndex]->nextMap();
+            currentMap = engine->gameLevels[engine->activeLevelIndex]->nextMap();
+        }
+
+        // Maps loaded from file, per level
+        ImGui::SeparatorText("Map Residency");
+        Level* level = engine->gameLevels[engine->activeLevelIndex].get();
+        LevelStats levelStats = level->getStats();
+        ImGui::Text("Map: %d / %d", level->getCurrentMapIndex() + 1, levelStats.mapCount);
+        ImGui::Text("Resident: %d maps, %.1f KB", levelStats.residentMaps, levelStats.residentBytes / 1024.0f);
+        ImGui::Text("Loads: %d (%d prefetched)", levelStats.loads, levelStats.prefetches);
+        ImGui::Text("Evictions: %d, saves: %d", levelStats.evictions, levelStats.saves);
+
+        int budgetKB = static_cast<int>(std::min<size_t>(level->getMemoryBudget() >> 10, 1 << 20));
+        if (ImGui::SliderInt("Budget (KB)", &budgetKB, 16, 1 << 20, "%d", ImGuiSliderFlags_Logarithmic)) {
+            level->setMemoryBudget(static_cast<size_t>(budgetKB) << 10);
         }
         
         if (ImGui::Button("Previous Layer")) {
@@ -211,6 +382,42 @@ void UIDebug::drawLevelManagerWindow() {
         if (ImGui::Button("Next Layer")) {
             engine->selectedLayer = (engine->selectedLayer + 1) % currentMap->getLayerCount();
         }
+
+        // Undo history of the current map
+        ImGui::SeparatorText("Edit History");
+        EditJournal& journal = currentMap->getJournal();
+
+        ImGui::BeginDisabled(!journal.canUndo());
+        if (ImGui::Button("Undo")) {
+            journal.undo();
+        }
+        ImGui::EndDisabled();
+        ImGui::SameLine();
+        ImGui::BeginDisabled(!journal.canRedo());
+        if (ImGui::Button("Redo")) {
+            journal.redo();
+        }
+        ImGui::EndDisabled();
+        ImGui::SameLine();
+        ImGui::TextDisabled("%s", journal.canUndo() ? journal.getUndoName().c_str() : "");
+
+        ImGui::Text("Steps: %zu undo, %zu redo", journal.getUndoCount(), journal.getRedoCount());
+        ImGui::Text("History: %.1f KB (%zu dropped)", journal.getMemoryUsage() / 1024.0f, journal.getDroppedCount());
+
+        static int historyLimitMB = static_cast<int>(EditJournal::DEFAULT_MEMORY_LIMIT >> 20);
+        if (ImGui::SliderInt("Limit (MB)", &historyLimitMB, 1, 512)) {
+            for (Map* map : engine->gameLevels[engine->activeLevelIndex]->getAllMaps()) {
+                map->getJournal().setMemoryLimit(static_cast<size_t>(historyLimitMB) << 20);
+            }
+        }
+
+        if (ImGui::Button("Fill Layer") && currentMap->isBounded()) {
+            journal.fillRect(0, 0, currentMap->getWidth(), currentMap->getHeight(), engine->selectedLayer, engine->selectedTileType);
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Clear Layer")) {
+            journal.clearLayers(engine->selectedLayer, engine->selectedLayer);
+        }
         
         // Background Color
         ImGui::SeparatorText("Map Settings");
@@ -241,6 +448,42 @@ void UIDebug::drawTilePaletteWindow() {
     
     if (ImGui::Begin("Tile Palette", &showTilePalette)) {
         ImGui::Text("Selected Type: %d", engine->selectedTileType);
+
+        AssetLoadStats loadStats = engine->assetLoader->getStats();
+        if (engine->assetLoader->isFinished()) {
+            ImGui::Text("Assets: %d loaded in %.1f ms, %d failed", loadStats.requested, loadStats.totalMs, loadStats.failed);
+        } else {
+            ImGui::Text("Assets: %d / %d loaded", loadStats.uploaded, loadStats.requested);
+        }
+
+        // Tile images loaded when first drawn
+        ImGui::SeparatorText("Texture Residency");
+        TileResidencyStats residency = TileRegistry::getResidencyStats();
+        ImGui::Text("Types: %d / %d resident, %d loading", residency.residentTypes, residency.managedTypes, residency.loadingTypes);
+        ImGui::Text("Atlas: %d pages, %.1f / %.1f KB", residency.atlasPages, residency.atlasBytes / 1024.0f, residency.budgetBytes / 1024.0f);
+        ImGui::Text("Hits: %llu, misses: %llu", static_cast<unsigned long long>(residency.hits),
+                    static_cast<unsigned long long>(residency.misses));
+        ImGui::Text("Loads: %llu, evictions: %llu", static_cast<unsigned long long>(residency.loads),
+                    static_cast<unsigned long long>(residency.evictions));
+
+        int textureBudgetKB = static_cast<int>(std::min<size_t>(TileRegistry::getTextureBudget() >> 10, 1 << 20));
+        if (ImGui::SliderInt("Texture Budget (KB)", &textureBudgetKB, 64, 1 << 20, "%d", ImGuiSliderFlags_Logarithmic)) {
+            TileRegistry::setTextureBudget(static_cast<size_t>(textureBudgetKB) << 10);
+        }
+        ImGui::Separator();
+
+        // Brush used by left-drag painting
+        int brushSize = engine->brush.getSize();
+        if (ImGui::SliderInt("Brush Size", &brushSize, 1, Brush::MAX_SIZE)) {
+            engine->brush.setSize(brushSize);
+        }
+        if (ImGui::RadioButton("Square", engine->brush.getShape() == BrushShape::Square)) {
+            engine->brush.setShape(BrushShape::Square);
+        }
+        ImGui::SameLine();
+        if (ImGui::RadioButton("Circle", engine->brush.getShape() == BrushShape::Circle)) {
+            engine->brush.setShape(BrushShape::Circle);
+        }
         ImGui::Separator();
         
         // Search filter
@@ -254,55 +497,74 @@ void UIDebug::drawTilePaletteWindow() {
         const float spacing = 2.0f;
         const int tilesPerRow = (int)((ImGui::GetContentRegionAvail().x - spacing) / (buttonSize + spacing));
         
-        int tileCount = 0;
+        // Types matching the filter, manifest types marked hidden left out
+        std::vector<const TileType*> shown;
         for (const auto& tile : TileRegistry::getAllTypes()) {
             int id = TileRegistry::getTileID(tile);
-            std::string name = tile->getName();
-            
-            // Filter by search
+            if (TileRegistry::getFlags(id) & TILE_HIDDEN) {
+                continue;
+            }
             if (strlen(searchBuffer) > 0) {
-                if (name.find(searchBuffer) == std::string::npos && 
+                if (tile->getName().find(searchBuffer) == std::string::npos &&
                     std::to_string(id).find(searchBuffer) == std::string::npos) {
                     continue;
                 }
             }
-            
-            // Grid layout
-            if (tileCount > 0 && tileCount % tilesPerRow != 0) {
-                ImGui::SameLine();
-            }
-            
-            // Tile button with preview
-            bool isSelected = (engine->selectedTileType == id);
-            if (isSelected) {
-                ImGui::PushStyleColor(ImGuiCol_Button, ImVec4(0.0f, 0.5f, 1.0f, 1.0f));
-            }
-            
-            if (ImGui::Button(("##" + std::to_string(id)).c_str(), ImVec2(buttonSize, buttonSize))) {
-                engine->selectedTileType = id;
-            }
-            
-            if (isSelected) {
-                ImGui::PopStyleColor();
-            }
-            
-            // Texture preview on button
-            SDL_Texture* tex = tile->getTexture();
-            if (tex) {
-                ImVec2 buttonMin = ImGui::GetItemRectMin();
-                ImVec2 buttonMax = ImGui::GetItemRectMax();
-                ImGui::GetWindowDrawList()->AddImage((ImTextureID)tex, buttonMin, buttonMax);
-            }
-            
-            // Tooltip with details
-            if (ImGui::IsItemHovered()) {
-                ImGui::BeginTooltip();
-                ImGui::Text("ID: %d", id);
-                ImGui::Text("Name: %s", name.c_str());
-                ImGui::EndTooltip();
+            shown.push_back(tile);
+        }
+
+        // Only the rows in view are laid out, and only their types get
+        // their images loaded
+        const int columns = std::max(tilesPerRow, 1);
+        const int rowCount = (static_cast<int>(shown.size()) + columns - 1) / columns;
+        ImGuiListClipper clipper;
+        clipper.Begin(rowCount, buttonSize + ImGui::GetStyle().ItemSpacing.y);
+        while (clipper.Step()) {
+            for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; ++row) {
+                const int rowEnd = std::min((row + 1) * columns, static_cast<int>(shown.size()));
+                for (int index = row * columns; index < rowEnd; ++index) {
+                    const TileType* tile = shown[index];
+                    int id = TileRegistry::getTileID(tile);
+
+                    // Grid layout
+                    if (index > row * columns) {
+                        ImGui::SameLine();
+                    }
+
+                    // Tile button with preview
+                    bool isSelected = (engine->selectedTileType == id);
+                    if (isSelected) {
+                        ImGui::PushStyleColor(ImGuiCol_Button, ImVec4(0.0f, 0.5f, 1.0f, 1.0f));
+                    }
+
+                    if (ImGui::Button(("##" + std::to_string(id)).c_str(), ImVec2(buttonSize, buttonSize))) {
+                        engine->selectedTileType = id;
+                    }
+
+                    if (isSelected) {
+                        ImGui::PopStyleColor();
+                    }
+
+                    // Texture preview on button
+                    TileRegistry::markUsed(id);
+                    SDL_Texture* tex = tile->getTexture();
+                    if (tex) {
+                        ImVec2 buttonMin = ImGui::GetItemRectMin();
+                        ImVec2 buttonMax = ImGui::GetItemRectMax();
+                        const SDL_FRect& uv = tile->getUVRect();
+                        ImGui::GetWindowDrawList()->AddImage((ImTextureID)tex, buttonMin, buttonMax,
+                                                             ImVec2(uv.x, uv.y), ImVec2(uv.x + uv.w, uv.y + uv.h));
+                    }
+
+                    // Tooltip with details
+                    if (ImGui::IsItemHovered()) {
+                        ImGui::BeginTooltip();
+                        ImGui::Text("ID: %d", id);
+                        ImGui::Text("Name: %s", tile->getName().c_str());
+                        ImGui::EndTooltip();
+                    }
+                }
             }
-            
-            tileCount++;
         }
     }
     ImGui::End();
@@ -2,6 +2,7 @@
 #include <imgui.h>
 #include <imgui_impl_sdl3.h>
 #include <imgui_impl_sdlrenderer3.h>
+#include "utils/Profiler.hpp"
 
 UIManager::UIManager() {
     // Setup Dear ImGui context
@@ -44,6 +45,7 @@ void UIManager::event(SDL_Event *event) {
 }
 
 void UIManager::update() {
+    PROFILE_ZONE("UIManager::update");
 
     // Start the Dear ImGui frame
     ImGui_ImplSDLRenderer3_NewFrame();
@@ -52,6 +54,7 @@ void UIManager::update() {
 }
 
 void UIManager::render(SDL_Renderer *renderer) {
+    PROFILE_ZONE("UIManager::render");
 
     ImGuiIO& io = ImGui::GetIO(); (void)io;
     ImVec4 clear_color = ImVec4(0.45f, 0.55f, 0.60f, 1.00f);
@@ -0,0 +1,49 @@
+// AlphaMask.cpp
+
+#include "AlphaMask.hpp"
+#include <algorithm>
+
+AlphaMask::AlphaMask(const void* pixels, int width, int height, int pitch)
+    : width(std::max(width, 0)), height(std::max(height, 0)), wordsPerRow((this->width + 63) / 64) {
+    bits.assign(static_cast<size_t>(wordsPerRow) * this->height, 0);
+
+    for (int y = 0; y < this->height; ++y) {
+        const uint8_t* row = static_cast<const uint8_t*>(pixels) + static_cast<size_t>(y) * pitch;
+        uint64_t* words = bits.data() + static_cast<size_t>(y) * wordsPerRow;
+        for (int x = 0; x < this->width; ++x) {
+            if (row[x * 4 + 3] >= ALPHA_THRESHOLD) {
+                words[x >> 6] |= uint64_t(1) << (x & 63);
+            }
+        }
+    }
+}
+
+bool AlphaMask::isEmpty() const {
+    return bits.empty();
+}
+
+int AlphaMask::getWidth() const {
+    return width;
+}
+
+int AlphaMask::getHeight() const {
+    return height;
+}
+
+size_t AlphaMask::getMemoryUsage() const {
+    return bits.capacity() * sizeof(uint64_t);
+}
+
+bool AlphaMask::test(int x, int y) const {
+    if (x < 0 || y < 0 || x >= width || y >= height) {
+        return false;
+    }
+    return (bits[static_cast<size_t>(y) * wordsPerRow + (x >> 6)] >> (x & 63)) & 1;
+}
+
+bool AlphaMask::testUV(float u, float v) const {
+    if (!(u >= 0.0f && u < 1.0f && v >= 0.0f && v < 1.0f)) {
+        return false;
+    }
+    return test(static_cast<int>(u * width), static_cast<int>(v * height));
+}
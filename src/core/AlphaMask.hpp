@@ -0,0 +1,37 @@
+// AlphaMask.hpp
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// One bit per image pixel, set where the pixel is opaque enough to be
+// picked. Built on the CPU from the image before it is uploaded, so picking
+// never reads a texture back.
+class AlphaMask {
+
+private:
+    int width = 0, height = 0;
+    int wordsPerRow = 0;
+    std::vector<uint64_t> bits;
+
+public:
+    // Alpha at or above this counts as opaque
+    static constexpr uint8_t ALPHA_THRESHOLD = 128;
+
+    AlphaMask() = default;
+
+    // From RGBA32 pixels (R, G, B, A bytes in memory order)
+    AlphaMask(const void* pixels, int width, int height, int pitch);
+
+    bool isEmpty() const;
+    int getWidth() const;
+    int getHeight() const;
+    size_t getMemoryUsage() const;
+
+    bool test(int x, int y) const;
+
+    // Normalized coordinates over the image, [0, 1) on both axes
+    bool testUV(float u, float v) const;
+};
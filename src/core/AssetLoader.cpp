@@ -0,0 +1,121 @@
+// AssetLoader.cpp
+
+#include "AssetLoader.hpp"
+#include "utils/Profiler.hpp"
+
+#include <SDL3_image/SDL_image.h>
+
+AssetLoader::AssetLoader(JobSystem& jobs) : jobs(jobs) {}
+
+// Decodes in flight write into the loader
+AssetLoader::~AssetLoader() {
+    jobs.wait(decoding);
+    for (const Decoded& decoded : ready) {
+        SDL_DestroySurface(decoded.surface);
+    }
+    for (const Decoded& decoded : uploads) {
+        SDL_DestroySurface(decoded.surface);
+    }
+}
+
+void AssetLoader::load(const std::string& path, ReadyFunction onReady) {
+    // Loading again after everything arrived starts a new batch
+    if (isFinished()) {
+        stats = AssetLoadStats();
+        decodeNs = 0;
+        startNs = SDL_GetTicksNS();
+    }
+
+    const int request = static_cast<int>(callbacks.size());
+    callbacks.push_back(std::move(onReady));
+    stats.requested++;
+
+    jobs.run("Decode image", [this, request, path] {
+        PROFILE_ZONE("AssetLoader::decode");
+        Uint64 start = SDL_GetTicksNS();
+
+        SDL_Surface* surface = IMG_Load(path.c_str());
+        if (!surface) {
+            SDL_Log("Failed to load image %s: %s", path.c_str(), SDL_GetError());
+        } else if (surface->format != SDL_PIXELFORMAT_RGBA32) {
+            // Textures and the atlas take RGBA32, convert off the main thread
+            SDL_Surface* converted = SDL_ConvertSurface(surface, SDL_PIXELFORMAT_RGBA32);
+            if (!converted) {
+                SDL_Log("Failed to convert image %s: %s", path.c_str(), SDL_GetError());
+            }
+            SDL_DestroySurface(surface);
+            surface = converted;
+        }
+
+        decodeNs += SDL_GetTicksNS() - start;
+        std::lock_guard<std::mutex> lock(readyMutex);
+        ready.push_back({ request, surface });
+    }, &decoding);
+}
+
+int AssetLoader::update(Uint64 budgetNs) {
+    if (isFinished()) {
+        return 0;
+    }
+    PROFILE_ZONE("AssetLoader::update");
+
+    // Without worker threads nothing decodes unless this thread waits
+    if (jobs.getThreadCount() <= 1) {
+        jobs.wait(decoding);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(readyMutex);
+        uploads.insert(uploads.end(), ready.begin(), ready.end());
+        ready.clear();
+    }
+
+    const Uint64 start = SDL_GetTicksNS();
+    int count = 0;
+    while (!uploads.empty() && (count == 0 || SDL_GetTicksNS() - start < budgetNs)) {
+        Decoded decoded = uploads.front();
+        uploads.pop_front();
+
+        callbacks[decoded.request](decoded.surface);
+        callbacks[decoded.request] = nullptr;
+        if (decoded.surface) {
+            SDL_DestroySurface(decoded.surface);
+        } else {
+            stats.failed++;
+        }
+        stats.uploaded++;
+        count++;
+    }
+    stats.uploadMs += (SDL_GetTicksNS() - start) / 1.0e6;
+
+    if (isFinished()) {
+        endNs = SDL_GetTicksNS();
+        callbacks.clear();
+        report();
+    }
+    return count;
+}
+
+void AssetLoader::finish() {
+    jobs.wait(decoding);
+    update(UINT64_MAX);
+}
+
+bool AssetLoader::isFinished() const {
+    return stats.uploaded == stats.requested;
+}
+
+AssetLoadStats AssetLoader::getStats() const {
+    AssetLoadStats current = stats;
+    current.decodeMs = decodeNs.load() / 1.0e6;
+    if (stats.requested > 0) {
+        current.totalMs = ((isFinished() ? endNs : SDL_GetTicksNS()) - startNs) / 1.0e6;
+    }
+    return current;
+}
+
+void AssetLoader::report() {
+    AssetLoadStats current = getStats();
+    SDL_Log("Loaded %d assets in %.1f ms (%d failed): %.1f ms decoding on %d threads, %.1f ms uploading",
+            current.requested, current.totalMs, current.failed, current.decodeMs, jobs.getThreadCount(), current.uploadMs);
+}
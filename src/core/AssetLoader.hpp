@@ -0,0 +1,79 @@
+// AssetLoader.hpp
+
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <SDL3/SDL.h>
+
+#include "JobSystem.hpp"
+
+// Progress of an AssetLoader's current batch
+struct AssetLoadStats {
+    int requested = 0;
+    int uploaded = 0;           // Handed to their callback, failures included
+    int failed = 0;             // Images that couldn't be decoded
+    double decodeMs = 0.0;      // Decode time summed over every thread
+    double uploadMs = 0.0;      // Main thread time spent in callbacks
+    double totalMs = 0.0;       // First request to last upload, so far while loading
+};
+
+// Decodes images on the job system and hands them back on the main thread.
+// Decoding and the conversion to RGBA32 run in parallel on workers; the
+// callbacks, which may touch the renderer, run from update() a batch at a
+// time so a frame never spends much more than its budget on them.
+class AssetLoader {
+
+public:
+    // Receives the decoded RGBA32 surface, or null when the image couldn't
+    // be loaded. The surface is freed after the call.
+    using ReadyFunction = std::function<void(SDL_Surface* surface)>;
+
+    static constexpr Uint64 DEFAULT_UPLOAD_BUDGET_NS = 4000000;     // 4 ms of a frame
+
+private:
+    struct Decoded {
+        int request;
+        SDL_Surface* surface;
+    };
+
+    JobSystem& jobs;
+    JobCounter decoding;
+    std::vector<ReadyFunction> callbacks;   // Indexed by request
+
+    std::mutex readyMutex;
+    std::vector<Decoded> ready;             // Decoded by workers, not yet picked up
+    std::atomic<uint64_t> decodeNs{ 0 };
+
+    std::deque<Decoded> uploads;            // Picked up, waiting for a frame's budget
+    AssetLoadStats stats;
+    Uint64 startNs = 0;
+    Uint64 endNs = 0;
+
+    void report();
+
+public:
+    explicit AssetLoader(JobSystem& jobs);
+    ~AssetLoader();
+
+    AssetLoader(const AssetLoader&) = delete;
+    AssetLoader& operator=(const AssetLoader&) = delete;
+
+    // Start decoding an image, onReady runs from a later update()
+    void load(const std::string& path, ReadyFunction onReady);
+
+    // Run the callbacks of decoded images until budgetNs is spent, at least
+    // one when any is ready. Returns how many ran.
+    int update(Uint64 budgetNs = DEFAULT_UPLOAD_BUDGET_NS);
+
+    // Wait for every image and run all remaining callbacks
+    void finish();
+
+    bool isFinished() const;
+    AssetLoadStats getStats() const;
+};
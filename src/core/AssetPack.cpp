@@ -0,0 +1,270 @@
+// AssetPack.cpp
+
+#include "AssetPack.hpp"
+#include "utils/BinaryIO.hpp"
+#include "utils/Profiler.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
+using namespace BinaryIO;
+
+namespace {
+
+constexpr size_t HEADER_SIZE = 24;
+constexpr size_t PAGE_ENTRY_SIZE = 16;
+
+size_t alignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+}
+
+bool AssetPack::open(const std::string& path) {
+    PROFILE_ZONE("AssetPack::open");
+    close();
+    if (!file.open(path, MappedFile::Access::ReadOnly)) {
+        return false;
+    }
+
+    const size_t fileSize = file.getSize();
+    std::vector<uint8_t> header(file.getData(), file.getData() + std::min(fileSize, HEADER_SIZE));
+    size_t cursor = 4;
+    Reader headerReader(header, cursor);
+    bool magicOk = header.size() >= 4 && std::memcmp(header.data(), MAGIC, 4) == 0;
+    uint16_t version = headerReader.u16();
+    padding = headerReader.u16();
+    uint32_t format = headerReader.u32();
+    uint32_t pageCount = headerReader.u32();
+    uint32_t imageCount = headerReader.u32();
+    uint32_t indexSize = headerReader.u32();
+
+    if (!magicOk || !headerReader.isOk() || version != VERSION || indexSize < HEADER_SIZE || indexSize > fileSize) {
+        SDL_Log("%s is not a version %u asset pack", path.c_str(), VERSION);
+        close();
+        return false;
+    }
+    if (format != static_cast<uint32_t>(PIXEL_FORMAT)) {
+        SDL_Log("Asset pack %s holds pixel format %u, expected %u", path.c_str(), format, static_cast<uint32_t>(PIXEL_FORMAT));
+        close();
+        return false;
+    }
+
+    std::vector<uint8_t> index(file.getData(), file.getData() + indexSize);
+    Reader reader(index, cursor);
+    bool valid = pageCount <= (indexSize - HEADER_SIZE) / PAGE_ENTRY_SIZE;
+
+    for (uint32_t i = 0; valid && i < pageCount; ++i) {
+        int width = reader.i32();
+        int height = reader.i32();
+        uint64_t offset = reader.u64();
+        const uint64_t bytes = static_cast<uint64_t>(std::max(width, 0)) * std::max(height, 0) * BYTES_PER_PIXEL;
+        valid = reader.isOk() && width > 0 && height > 0 && offset <= fileSize && bytes <= fileSize - offset;
+        if (valid) {
+            pages.push_back({ width, height, file.getData() + offset });
+        }
+    }
+
+    for (uint32_t i = 0; valid && i < imageCount; ++i) {
+        Image image;
+        uint16_t nameLength = reader.u16();
+        const uint8_t* name = reader.bytes(nameLength);
+        image.page = static_cast<int>(reader.u32());
+        image.rect.x = reader.i32();
+        image.rect.y = reader.i32();
+        image.rect.w = reader.i32();
+        image.rect.h = reader.i32();
+        valid = reader.isOk() && image.page >= 0 && image.page < static_cast<int>(pages.size());
+        if (!valid) {
+            break;
+        }
+
+        const Page& page = pages[image.page];
+        const PackedRect& rect = image.rect;
+        valid = rect.x >= 0 && rect.y >= 0 && rect.w > 0 && rect.h > 0
+                && rect.w <= page.width - rect.x && rect.h <= page.height - rect.y;
+        image.name.assign(reinterpret_cast<const char*>(name), nameLength);
+        valid = valid && imageIndex.emplace(image.name, static_cast<int>(images.size())).second;
+        images.push_back(std::move(image));
+    }
+
+    if (!valid || cursor != indexSize) {
+        SDL_Log("Asset pack %s is damaged", path.c_str());
+        close();
+        return false;
+    }
+    return true;
+}
+
+void AssetPack::close() {
+    file.close();
+    padding = 0;
+    pages.clear();
+    images.clear();
+    imageIndex.clear();
+}
+
+bool AssetPack::isOpen() const {
+    return file.isOpen();
+}
+
+int AssetPack::getPadding() const {
+    return padding;
+}
+
+const std::vector<AssetPack::Page>& AssetPack::getPages() const {
+    return pages;
+}
+
+const std::vector<AssetPack::Image>& AssetPack::getImages() const {
+    return images;
+}
+
+const AssetPack::Image* AssetPack::findImage(const std::string& name) const {
+    auto it = imageIndex.find(name);
+    return it != imageIndex.end() ? &images[it->second] : nullptr;
+}
+
+const uint8_t* AssetPack::getPixels(const Image& image) const {
+    const Page& page = pages[image.page];
+    return page.pixels + (static_cast<size_t>(image.rect.y) * page.width + image.rect.x) * BYTES_PER_PIXEL;
+}
+
+int AssetPack::getPitch(const Image& image) const {
+    return pages[image.page].width * BYTES_PER_PIXEL;
+}
+
+SDL_Surface* AssetPack::createSurface(const Image& image) const {
+    // The surface never writes its pixels, the mapping is read-only
+    void* pixels = const_cast<uint8_t*>(getPixels(image));
+    SDL_Surface* surface = SDL_CreateSurfaceFrom(image.rect.w, image.rect.h, PIXEL_FORMAT, pixels, getPitch(image));
+    if (!surface) {
+        SDL_Log("Failed to wrap packed image %s: %s", image.name.c_str(), SDL_GetError());
+    }
+    return surface;
+}
+
+bool AssetPack::build(const std::string& path, const std::vector<std::string>& names,
+                      const std::vector<SDL_Surface*>& surfaces, int pageSize, int padding) {
+    PROFILE_ZONE("AssetPack::build");
+    if (names.size() != surfaces.size()) {
+        return false;
+    }
+
+    std::unordered_map<std::string, int> seen;
+    std::vector<SDL_Surface*> converted(surfaces.size(), nullptr);
+    bool ok = true;
+    for (size_t i = 0; i < surfaces.size() && ok; ++i) {
+        if (!seen.emplace(names[i], static_cast<int>(i)).second || names[i].size() > UINT16_MAX) {
+            SDL_Log("Asset pack image name %s is repeated or too long", names[i].c_str());
+            ok = false;
+        } else if (surfaces[i]) {
+            converted[i] = SDL_ConvertSurface(surfaces[i], PIXEL_FORMAT);
+            ok = converted[i] != nullptr;
+        } else {
+            ok = false;
+        }
+    }
+
+    // Tallest first keeps the shelves tight
+    std::vector<size_t> order(surfaces.size());
+    std::iota(order.begin(), order.end(), 0);
+    if (ok) {
+        std::stable_sort(order.begin(), order.end(), [&converted](size_t a, size_t b) {
+            return converted[a]->h > converted[b]->h;
+        });
+    }
+
+    // Same placement as TileRegistry: first page with room, else a new
+    // page big enough for the image
+    std::vector<RectPacker> packers;
+    std::vector<std::vector<uint8_t>> pagePixels;
+    std::vector<Image> packed;
+    for (size_t i = 0; ok && i < order.size(); ++i) {
+        SDL_Surface* surface = converted[order[i]];
+        Image image = { names[order[i]], -1, { 0, 0, 0, 0 } };
+        for (size_t page = 0; page < packers.size() && image.page < 0; ++page) {
+            if (packers[page].insert(surface->w, surface->h, image.rect)) {
+                image.page = static_cast<int>(page);
+            }
+        }
+        if (image.page < 0) {
+            int width = std::max(pageSize, surface->w + padding * 2);
+            int height = std::max(pageSize, surface->h + padding * 2);
+            packers.emplace_back(width, height, padding);
+            pagePixels.emplace_back(static_cast<size_t>(width) * height * BYTES_PER_PIXEL, 0);
+            image.page = static_cast<int>(packers.size()) - 1;
+            packers.back().insert(surface->w, surface->h, image.rect);
+        }
+
+        const int pagePitch = packers[image.page].getWidth() * BYTES_PER_PIXEL;
+        for (int y = 0; y < surface->h; ++y) {
+            std::memcpy(pagePixels[image.page].data() + static_cast<size_t>(image.rect.y + y) * pagePitch + image.rect.x * BYTES_PER_PIXEL,
+                        static_cast<const uint8_t*>(surface->pixels) + static_cast<size_t>(y) * surface->pitch,
+                        static_cast<size_t>(surface->w) * BYTES_PER_PIXEL);
+        }
+        packed.push_back(std::move(image));
+    }
+
+    for (SDL_Surface* surface : converted) {
+        SDL_DestroySurface(surface);
+    }
+    if (!ok) {
+        SDL_Log("Couldn't pack images for %s", path.c_str());
+        return false;
+    }
+
+    std::vector<uint8_t> imageTable;
+    for (const Image& image : packed) {
+        putU16(imageTable, static_cast<uint16_t>(image.name.size()));
+        imageTable.insert(imageTable.end(), image.name.begin(), image.name.end());
+        putU32(imageTable, static_cast<uint32_t>(image.page));
+        putI32(imageTable, image.rect.x);
+        putI32(imageTable, image.rect.y);
+        putI32(imageTable, image.rect.w);
+        putI32(imageTable, image.rect.h);
+    }
+    const size_t indexSize = HEADER_SIZE + packers.size() * PAGE_ENTRY_SIZE + imageTable.size();
+
+    std::vector<uint8_t> index(MAGIC, MAGIC + 4);
+    putU16(index, VERSION);
+    putU16(index, static_cast<uint16_t>(padding));
+    putU32(index, static_cast<uint32_t>(PIXEL_FORMAT));
+    putU32(index, static_cast<uint32_t>(packers.size()));
+    putU32(index, static_cast<uint32_t>(packed.size()));
+    putU32(index, static_cast<uint32_t>(indexSize));
+
+    std::vector<size_t> offsets;
+    size_t offset = alignUp(indexSize, PIXEL_ALIGNMENT);
+    for (size_t page = 0; page < packers.size(); ++page) {
+        offsets.push_back(offset);
+        putI32(index, packers[page].getWidth());
+        putI32(index, packers[page].getHeight());
+        putU64(index, offset);
+        offset = alignUp(offset + pagePixels[page].size(), PIXEL_ALIGNMENT);
+    }
+    index.insert(index.end(), imageTable.begin(), imageTable.end());
+
+    FILE* out = std::fopen(path.c_str(), "wb");
+    if (!out) {
+        SDL_Log("Couldn't write asset pack %s", path.c_str());
+        return false;
+    }
+
+    bool written = std::fwrite(index.data(), 1, index.size(), out) == index.size();
+    size_t position = index.size();
+    const std::vector<uint8_t> zeros(PIXEL_ALIGNMENT, 0);
+    for (size_t page = 0; page < packers.size() && written; ++page) {
+        const size_t gap = offsets[page] - position;
+        written = (gap == 0 || std::fwrite(zeros.data(), 1, gap, out) == gap)
+                  && std::fwrite(pagePixels[page].data(), 1, pagePixels[page].size(), out) == pagePixels[page].size();
+        position = offsets[page] + pagePixels[page].size();
+    }
+
+    if (std::fclose(out) != 0 || !written) {
+        SDL_Log("Couldn't write asset pack %s", path.c_str());
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,79 @@
+// AssetPack.hpp
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <SDL3/SDL.h>
+
+#include "utils/MappedFile.hpp"
+#include "utils/RectPacker.hpp"
+
+// Images decoded ahead of time, laid out on atlas pages the way
+// TileRegistry lays out its own, so a page goes to the renderer straight
+// from the mapped file. Built by isoEngine_assetpacker. Little endian:
+//   header  "ISOP", u16 version, u16 padding around images, u32 SDL pixel
+//           format, u32 page count, u32 image count, u32 size of the
+//           header, page table and image table together
+//   pages   per page i32 width, i32 height, u64 offset of its pixels
+//   images  per image u16 name length, the name, u32 page, i32 x, y, w, h,
+//           in the order they were packed
+//   pixels  per page width * height pixels, rows without gaps, each page
+//           starting on a PIXEL_ALIGNMENT boundary
+class AssetPack {
+
+public:
+    static constexpr char MAGIC[4] = { 'I', 'S', 'O', 'P' };
+    static constexpr uint16_t VERSION = 1;
+    static constexpr size_t PIXEL_ALIGNMENT = 4096;
+    static constexpr SDL_PixelFormat PIXEL_FORMAT = SDL_PIXELFORMAT_RGBA32;   // What atlas pages hold
+    static constexpr int BYTES_PER_PIXEL = 4;
+
+    struct Page {
+        int width, height;
+        const uint8_t* pixels;      // Into the mapping
+    };
+
+    struct Image {
+        std::string name;
+        int page;
+        PackedRect rect;
+    };
+
+private:
+    MappedFile file;
+    int padding = 0;
+    std::vector<Page> pages;
+    std::vector<Image> images;
+    std::unordered_map<std::string, int> imageIndex;
+
+public:
+    // False when the file can't be mapped or is not a valid pack
+    bool open(const std::string& path);
+    void close();
+    bool isOpen() const;
+
+    int getPadding() const;
+    const std::vector<Page>& getPages() const;
+    const std::vector<Image>& getImages() const;
+
+    // nullptr when the pack has no image of that name
+    const Image* findImage(const std::string& name) const;
+
+    // First pixel of the image and the bytes between its rows
+    const uint8_t* getPixels(const Image& image) const;
+    int getPitch(const Image& image) const;
+
+    // Surface over the image's pixels in the mapping, nothing is copied.
+    // Valid while the pack is open, destroy it with SDL_DestroySurface.
+    SDL_Surface* createSurface(const Image& image) const;
+
+    // Lay the surfaces out on pages of at least pageSize and write them,
+    // named by names, as a pack
+    static bool build(const std::string& path, const std::vector<std::string>& names,
+                      const std::vector<SDL_Surface*>& surfaces, int pageSize, int padding);
+};
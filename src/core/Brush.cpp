@@ -0,0 +1,103 @@
+// Brush.cpp
+
+#include "Brush.hpp"
+#include <algorithm>
+#include <cstdlib>
+
+Brush::Brush() {
+    buildFootprint();
+}
+
+// Cells of a size x size box, centred on the pointer cell (up-left of the
+// centre for even sizes); the circle keeps those whose centre is within
+// half the size of the box centre
+void Brush::buildFootprint() {
+    footprint.clear();
+
+    const int origin = (size - 1) / 2;
+    const float centre = (size - 1) * 0.5f;
+    const float radiusSquared = size * size * 0.25f;
+
+    for (int y = 0; y < size; ++y) {
+        for (int x = 0; x < size; ++x) {
+            if (shape == BrushShape::Circle) {
+                float dx = x - centre, dy = y - centre;
+                if (dx * dx + dy * dy > radiusSquared) {
+                    continue;
+                }
+            }
+            footprint.push_back({ x - origin, y - origin });
+        }
+    }
+}
+
+void Brush::setSize(int size) {
+    size = std::clamp(size, 1, MAX_SIZE);
+    if (size != this->size) {
+        this->size = size;
+        buildFootprint();
+    }
+}
+
+int Brush::getSize() const {
+    return size;
+}
+
+void Brush::setShape(BrushShape shape) {
+    if (shape != this->shape) {
+        this->shape = shape;
+        buildFootprint();
+    }
+}
+
+BrushShape Brush::getShape() const {
+    return shape;
+}
+
+const std::vector<BrushCell>& Brush::getFootprint() const {
+    return footprint;
+}
+
+void Brush::rasterize(const std::vector<BrushCell>& points, std::vector<BrushCell>& cells) const {
+    cells.clear();
+    if (points.empty()) {
+        return;
+    }
+
+    auto stamp = [&](int x, int y) {
+        for (const BrushCell& offset : footprint) {
+            cells.push_back({ x + offset.x, y + offset.y });
+        }
+    };
+
+    stamp(points[0].x, points[0].y);
+
+    // Bresenham along each segment, the start cell was stamped by the previous one
+    for (size_t i = 1; i < points.size(); ++i) {
+        int x = points[i - 1].x, y = points[i - 1].y;
+        const int endX = points[i].x, endY = points[i].y;
+        const int dx = std::abs(endX - x), dy = -std::abs(endY - y);
+        const int stepX = x < endX ? 1 : -1, stepY = y < endY ? 1 : -1;
+        int error = dx + dy;
+
+        while (x != endX || y != endY) {
+            int doubled = 2 * error;
+            if (doubled >= dy) {
+                error += dy;
+                x += stepX;
+            }
+            if (doubled <= dx) {
+                error += dx;
+                y += stepY;
+            }
+            stamp(x, y);
+        }
+    }
+
+    std::sort(cells.begin(), cells.end(), [](const BrushCell& a, const BrushCell& b) {
+        return a.y != b.y ? a.y < b.y : a.x < b.x;
+    });
+    cells.erase(std::unique(cells.begin(), cells.end(), [](const BrushCell& a, const BrushCell& b) {
+        return a.x == b.x && a.y == b.y;
+    }), cells.end());
+}
@@ -0,0 +1,43 @@
+// Brush.hpp
+
+#pragma once
+
+#include <vector>
+
+// Grid cell, or a cell offset within a brush footprint
+struct BrushCell {
+    int x, y;
+};
+
+enum class BrushShape {
+    Square,
+    Circle
+};
+
+// Paint brush. A stroke is a polyline of grid cells; rasterizing it walks
+// every segment cell by cell and stamps the footprint at each step, so fast
+// strokes leave no gaps.
+class Brush {
+
+private:
+    int size = 1;
+    BrushShape shape = BrushShape::Square;
+    std::vector<BrushCell> footprint;       // Offsets from the cell under the pointer
+
+    void buildFootprint();
+
+public:
+    static constexpr int MAX_SIZE = 32;
+
+    Brush();
+
+    void setSize(int size);
+    int getSize() const;
+    void setShape(BrushShape shape);
+    BrushShape getShape() const;
+    const std::vector<BrushCell>& getFootprint() const;
+
+    // Replace cells with those covered along points, in row-major order
+    // without duplicates
+    void rasterize(const std::vector<BrushCell>& points, std::vector<BrushCell>& cells) const;
+};
@@ -0,0 +1,140 @@
+// ChunkCache.cpp
+
+#include "ChunkCache.hpp"
+
+ChunkCache::~ChunkCache() {
+    clear();
+}
+
+void ChunkCache::beginFrame() {
+    frame++;
+    stats = ChunkCacheStats();
+}
+
+ChunkCache::Entry& ChunkCache::use(int chunkX, int chunkY, int layer) {
+    const ChunkKey key = { chunkX, chunkY, layer };
+
+    auto it = entries.find(key);
+    if (it == entries.end()) {
+        it = entries.emplace(key, Entry()).first;
+        lru.push_front(key);
+        it->second.lruPosition = lru.begin();
+    } else {
+        lru.splice(lru.begin(), lru, it->second.lruPosition);
+    }
+
+    it->second.lastUsedFrame = frame;
+    return it->second;
+}
+
+bool ChunkCache::ensureTexture(SDL_Renderer* renderer, Entry& entry, int width, int height) {
+    if (entry.texture) {
+        return true;
+    }
+
+    entry.texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, width, height);
+    if (!entry.texture) {
+        SDL_Log("Failed to create chunk texture: %s", SDL_GetError());
+        return false;
+    }
+    SDL_SetTextureBlendMode(entry.texture, SDL_BLENDMODE_BLEND);
+    SDL_SetTextureScaleMode(entry.texture, SDL_SCALEMODE_NEAREST);
+
+    entry.bytes = static_cast<size_t>(width) * height * 4;
+    entry.dirty = true;
+    residentBytes += entry.bytes;
+    return true;
+}
+
+void ChunkCache::remove(int chunkX, int chunkY, int layer) {
+    auto it = entries.find(ChunkKey{ chunkX, chunkY, layer });
+    if (it != entries.end()) {
+        release(it->second);
+        lru.erase(it->second.lruPosition);
+        entries.erase(it);
+    }
+}
+
+void ChunkCache::markDirty(int x, int y, int layer) {
+    auto it = entries.find(ChunkKey{ x >> CHUNK_SHIFT, y >> CHUNK_SHIFT, layer });
+    if (it != entries.end()) {
+        it->second.dirty = true;
+    }
+}
+
+// One pass over the cached chunks, whatever the size of the region.
+// Tile bounds are inclusive.
+void ChunkCache::markDirtyRect(int minX, int minY, int maxX, int maxY, int firstLayer, int lastLayer) {
+    int minChunkX = minX >> CHUNK_SHIFT, maxChunkX = maxX >> CHUNK_SHIFT;
+    int minChunkY = minY >> CHUNK_SHIFT, maxChunkY = maxY >> CHUNK_SHIFT;
+
+    for (auto& pair : entries) {
+        const ChunkKey& key = pair.first;
+        if (key.layer >= firstLayer && key.layer <= lastLayer &&
+            key.x >= minChunkX && key.x <= maxChunkX && key.y >= minChunkY && key.y <= maxChunkY) {
+            pair.second.dirty = true;
+        }
+    }
+}
+
+void ChunkCache::markAllDirty() {
+    for (auto& pair : entries) {
+        pair.second.dirty = true;
+    }
+}
+
+void ChunkCache::release(Entry& entry) {
+    if (entry.texture) {
+        SDL_DestroyTexture(entry.texture);
+        entry.texture = nullptr;
+        residentBytes -= entry.bytes;
+        entry.bytes = 0;
+    }
+}
+
+void ChunkCache::evictToBudget() {
+    // Entries used this frame are on screen and sit at the front
+    while (residentBytes > budgetBytes && !lru.empty()) {
+        auto it = entries.find(lru.back());
+        if (it->second.lastUsedFrame == frame) {
+            break;
+        }
+
+        release(it->second);
+        lru.pop_back();
+        entries.erase(it);
+        stats.evictions++;
+    }
+}
+
+void ChunkCache::clear() {
+    for (auto& pair : entries) {
+        release(pair.second);
+    }
+    entries.clear();
+    lru.clear();
+}
+
+void ChunkCache::setBudget(size_t bytes) {
+    budgetBytes = bytes;
+}
+
+size_t ChunkCache::getBudget() const {
+    return budgetBytes;
+}
+
+size_t ChunkCache::getResidentBytes() const {
+    return residentBytes;
+}
+
+size_t ChunkCache::getEntryCount() const {
+    return entries.size();
+}
+
+const ChunkCacheStats& ChunkCache::getStats() const {
+    return stats;
+}
+
+ChunkCacheStats& ChunkCache::getStats() {
+    return stats;
+}
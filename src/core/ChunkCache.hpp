@@ -0,0 +1,91 @@
+// ChunkCache.hpp
+
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+#include <SDL3/SDL.h>
+
+#include "Tile.hpp"
+#include "utils/ChunkKey.hpp"
+
+// Per-frame counters of a ChunkCache
+struct ChunkCacheStats {
+    int hits = 0;        // Visible chunks drawn straight from their texture
+    int misses = 0;      // Visible chunks that needed a new texture
+    int rebakes = 0;     // Cached chunks redrawn because their tiles changed
+    int evictions = 0;   // Textures released to stay under budget
+};
+
+// Pre-rendered textures of map chunks, one per chunk and layer. Entries are
+// marked dirty by tile edits and rebaked on their next visible frame; the
+// least recently drawn off-screen textures are released once the cache
+// grows past its memory budget.
+class ChunkCache {
+
+public:
+    // Chunk edge in tiles, small enough to keep textures within 1024 pixels
+    static constexpr int CHUNK_SHIFT = 4;
+    static constexpr int CHUNK_SIZE = 1 << CHUNK_SHIFT;
+
+    static constexpr size_t DEFAULT_BUDGET = 256u * 1024u * 1024u;
+
+    struct Entry {
+        SDL_Texture* texture = nullptr;
+        size_t bytes = 0;
+        bool dirty = true;
+        uint64_t lastUsedFrame = 0;
+        std::list<ChunkKey>::iterator lruPosition;
+        std::vector<TileID> typeIDs;    // Tile types baked into the texture
+    };
+
+private:
+    std::unordered_map<ChunkKey, Entry, ChunkKeyHash> entries;
+    std::list<ChunkKey> lru;    // Most recently drawn first
+
+    size_t budgetBytes = DEFAULT_BUDGET;
+    size_t residentBytes = 0;
+    uint64_t frame = 0;
+    ChunkCacheStats stats;
+
+    void release(Entry& entry);
+
+public:
+    ChunkCache() = default;
+    ChunkCache(const ChunkCache&) = delete;
+    ChunkCache& operator=(const ChunkCache&) = delete;
+    ~ChunkCache();
+
+    // Start a new frame and reset the per-frame counters
+    void beginFrame();
+
+    // Entry for a visible chunk, created on first use and moved to the
+    // front of the LRU list
+    Entry& use(int chunkX, int chunkY, int layer);
+
+    // Make sure the entry owns a render target of the given size
+    bool ensureTexture(SDL_Renderer* renderer, Entry& entry, int width, int height);
+
+    // Drop the entry of a chunk that no longer holds tiles
+    void remove(int chunkX, int chunkY, int layer);
+
+    // Invalidation by tile coordinate
+    void markDirty(int x, int y, int layer);
+    void markDirtyRect(int minX, int minY, int maxX, int maxY, int firstLayer, int lastLayer);
+    void markAllDirty();
+
+    // Release off-screen textures, least recently used first, until the
+    // cache fits its budget
+    void evictToBudget();
+    void clear();
+
+    void setBudget(size_t bytes);
+    size_t getBudget() const;
+    size_t getResidentBytes() const;
+    size_t getEntryCount() const;
+    const ChunkCacheStats& getStats() const;
+    ChunkCacheStats& getStats();
+};
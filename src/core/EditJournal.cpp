@@ -0,0 +1,296 @@
+// EditJournal.cpp
+
+#include "EditJournal.hpp"
+#include "Map.hpp"
+#include <algorithm>
+#include <climits>
+#include <iostream>
+
+namespace {
+
+const std::string NO_NAME;
+
+}
+
+EditJournal::EditJournal(Map& map) : map(map) {
+}
+
+void EditJournal::begin(const std::string& name) {
+    if (depth++ == 0) {
+        current = Transaction();
+        current.name = name;
+    }
+}
+
+void EditJournal::commit() {
+    if (depth == 0) {
+        std::cerr << "EditJournal::commit without begin" << std::endl;
+        return;
+    }
+    if (--depth > 0) {
+        return;
+    }
+    if (current.cells.empty() && current.regions.empty()) {
+        return;
+    }
+
+    current.cells.shrink_to_fit();
+    current.regions.shrink_to_fit();
+    current.memory = measure(current);
+
+    // A new edit ends the redo branch
+    for (const Transaction& transaction : redoStack) {
+        memoryUsage -= transaction.memory;
+    }
+    redoStack.clear();
+
+    memoryUsage += current.memory;
+    undoStack.push_back(std::move(current));
+    current = Transaction();
+    trim();
+}
+
+bool EditJournal::isRecording() const {
+    return depth > 0;
+}
+
+void EditJournal::setTile(int x, int y, int layer, int tileID) {
+    int before = map.getTileID(x, y, layer);
+    if (tileID < 0) {
+        map.removeTile(x, y, layer);
+    } else {
+        map.setTile(x, y, layer, tileID);
+    }
+
+    // Rejected edits and rewrites of the same ID leave nothing to undo
+    int after = map.getTileID(x, y, layer);
+    if (after == before) {
+        return;
+    }
+
+    begin("Set tile");
+    CellEdit edit{ x, y, static_cast<uint16_t>(layer),
+                   before < 0 ? EMPTY_TILE : static_cast<TileID>(before),
+                   after < 0 ? EMPTY_TILE : static_cast<TileID>(after) };
+
+    // Repeated writes to the last cell collapse into one delta
+    bool lastIsCell = !current.cells.empty() &&
+                      (current.regions.empty() || current.regions.back().cellsBefore < current.cells.size());
+    CellEdit* last = lastIsCell ? &current.cells.back() : nullptr;
+    if (last && last->x == edit.x && last->y == edit.y && last->layer == edit.layer) {
+        last->after = edit.after;
+        if (last->after == last->before) {
+            current.cells.pop_back();
+        }
+    } else {
+        current.cells.push_back(edit);
+    }
+    commit();
+}
+
+void EditJournal::fillRect(int x, int y, int width, int height, int layer, int tileID) {
+    if (tileID < -1 || tileID >= EMPTY_TILE) {
+        std::cerr << "Invalid tile ID: " << tileID << std::endl;
+        return;
+    }
+
+    TileRuns before = map.encodeRect(x, y, width, height, layer, layer);
+    if (before.isEmpty()) {
+        return;
+    }
+    map.fillRect(x, y, width, height, layer, tileID);
+
+    // The new contents are a single run, no need to read them back
+    TileRuns after(before.getX(), before.getY(), before.getWidth(), before.getHeight(), layer, layer);
+    after.appendRun(tileID < 0 ? EMPTY_TILE : static_cast<TileID>(tileID), after.getCellCount());
+    after.finish();
+
+    begin("Fill");
+    addRegion(std::move(before), std::move(after));
+    commit();
+}
+
+void EditJournal::clearLayers(int firstLayer, int lastLayer) {
+    firstLayer = std::max(firstLayer, 0);
+    lastLayer = std::min(lastLayer, map.getLayerCount() - 1);
+
+    // Only the occupied part of the layers needs saving
+    int minX = INT_MAX, minY = INT_MAX, maxX = INT_MIN, maxY = INT_MIN;
+    for (int layer = firstLayer; layer <= lastLayer; ++layer) {
+        int layerMinX, layerMinY, layerMaxX, layerMaxY;
+        if (map.getOccupiedBounds(layer, layerMinX, layerMinY, layerMaxX, layerMaxY)) {
+            minX = std::min(minX, layerMinX);
+            minY = std::min(minY, layerMinY);
+            maxX = std::max(maxX, layerMaxX);
+            maxY = std::max(maxY, layerMaxY);
+        }
+    }
+    if (minX > maxX || minY > maxY) {
+        return;
+    }
+
+    TileRuns before = map.encodeRect(minX, minY, maxX - minX + 1, maxY - minY + 1, firstLayer, lastLayer);
+    map.clearLayers(firstLayer, lastLayer);
+
+    TileRuns after(before.getX(), before.getY(), before.getWidth(), before.getHeight(), firstLayer, lastLayer);
+    after.appendRun(EMPTY_TILE, after.getCellCount());
+    after.finish();
+
+    begin("Clear layers");
+    addRegion(std::move(before), std::move(after));
+    commit();
+}
+
+void EditJournal::pasteStamp(const TileStamp& stamp, int x, int y, bool masked) {
+    TileRuns before = map.encodeRect(x, y, stamp.getWidth(), stamp.getHeight(), 0, stamp.getLayerCount() - 1);
+    if (before.isEmpty()) {
+        return;
+    }
+    map.pasteStamp(stamp, x, y, masked);
+
+    // Read back, a masked paste keeps some of the old cells
+    TileRuns after = map.encodeRect(before.getX(), before.getY(), before.getWidth(), before.getHeight(),
+                                    before.getFirstLayer(), before.getLastLayer());
+
+    begin("Paste");
+    addRegion(std::move(before), std::move(after));
+    commit();
+}
+
+void EditJournal::addRegion(TileRuns before, TileRuns after) {
+    if (before == after) {
+        return;
+    }
+    current.regions.push_back({ current.cells.size(), std::move(before), std::move(after) });
+}
+
+void EditJournal::writeCell(const CellEdit& edit, bool undo) {
+    TileID id = undo ? edit.before : edit.after;
+    if (id == EMPTY_TILE) {
+        map.removeTile(edit.x, edit.y, edit.layer);
+    } else {
+        map.setTile(edit.x, edit.y, edit.layer, id);
+    }
+}
+
+bool EditJournal::undo() {
+    if (depth > 0 || undoStack.empty()) {
+        return false;
+    }
+
+    Transaction transaction = std::move(undoStack.back());
+    undoStack.pop_back();
+
+    // Walk the deltas newest first, regions interleaved with the cells
+    // recorded around them
+    size_t cellEnd = transaction.cells.size();
+    for (auto region = transaction.regions.rbegin(); region != transaction.regions.rend(); ++region) {
+        for (size_t i = cellEnd; i > region->cellsBefore; --i) {
+            writeCell(transaction.cells[i - 1], true);
+        }
+        map.decodeRect(region->before);
+        cellEnd = region->cellsBefore;
+    }
+    for (size_t i = cellEnd; i > 0; --i) {
+        writeCell(transaction.cells[i - 1], true);
+    }
+
+    redoStack.push_back(std::move(transaction));
+    return true;
+}
+
+bool EditJournal::redo() {
+    if (depth > 0 || redoStack.empty()) {
+        return false;
+    }
+
+    Transaction transaction = std::move(redoStack.back());
+    redoStack.pop_back();
+
+    size_t cell = 0;
+    for (const RegionEdit& region : transaction.regions) {
+        for (; cell < region.cellsBefore; ++cell) {
+            writeCell(transaction.cells[cell], false);
+        }
+        map.decodeRect(region.after);
+    }
+    for (; cell < transaction.cells.size(); ++cell) {
+        writeCell(transaction.cells[cell], false);
+    }
+
+    undoStack.push_back(std::move(transaction));
+    return true;
+}
+
+bool EditJournal::canUndo() const {
+    return depth == 0 && !undoStack.empty();
+}
+
+bool EditJournal::canRedo() const {
+    return depth == 0 && !redoStack.empty();
+}
+
+const std::string& EditJournal::getUndoName() const {
+    return undoStack.empty() ? NO_NAME : undoStack.back().name;
+}
+
+const std::string& EditJournal::getRedoName() const {
+    return redoStack.empty() ? NO_NAME : redoStack.back().name;
+}
+
+size_t EditJournal::getUndoCount() const {
+    return undoStack.size();
+}
+
+size_t EditJournal::getRedoCount() const {
+    return redoStack.size();
+}
+
+void EditJournal::clear() {
+    undoStack.clear();
+    redoStack.clear();
+    current = Transaction();
+    depth = 0;
+    memoryUsage = 0;
+}
+
+// Oldest undo steps go first, then the furthest redo steps
+void EditJournal::trim() {
+    while (memoryUsage > memoryLimit && undoStack.size() + redoStack.size() > 1) {
+        if (!undoStack.empty()) {
+            memoryUsage -= undoStack.front().memory;
+            undoStack.pop_front();
+        } else {
+            memoryUsage -= redoStack.front().memory;
+            redoStack.erase(redoStack.begin());
+        }
+        droppedCount++;
+    }
+}
+
+size_t EditJournal::measure(const Transaction& transaction) {
+    size_t bytes = sizeof(Transaction) + transaction.name.capacity() +
+                   transaction.cells.capacity() * sizeof(CellEdit) +
+                   transaction.regions.capacity() * sizeof(RegionEdit);
+    for (const RegionEdit& region : transaction.regions) {
+        bytes += region.before.getMemoryUsage() + region.after.getMemoryUsage() - 2 * sizeof(TileRuns);
+    }
+    return bytes;
+}
+
+void EditJournal::setMemoryLimit(size_t bytes) {
+    memoryLimit = bytes;
+    trim();
+}
+
+size_t EditJournal::getMemoryLimit() const {
+    return memoryLimit;
+}
+
+size_t EditJournal::getMemoryUsage() const {
+    return memoryUsage;
+}
+
+size_t EditJournal::getDroppedCount() const {
+    return droppedCount;
+}
@@ -0,0 +1,94 @@
+// EditJournal.hpp
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "Tile.hpp"
+#include "TileRuns.hpp"
+#include "TileStamp.hpp"
+
+class Map;
+
+// Undo history of one map. Edits made through the journal are applied to
+// the map and recorded as deltas grouped into transactions: single cells as
+// (cell, layer, old ID, new ID), region edits as run-length encoded
+// rectangles of their old and new contents, so undoing a layer fill costs
+// about as much memory as the fill. The oldest transactions are dropped
+// once the history grows past its memory limit.
+class EditJournal {
+
+private:
+    struct CellEdit {
+        int32_t x, y;
+        uint16_t layer;
+        TileID before, after;
+    };
+
+    struct RegionEdit {
+        size_t cellsBefore;         // Cell edits of the transaction recorded before this one
+        TileRuns before, after;
+    };
+
+    struct Transaction {
+        std::string name;
+        std::vector<CellEdit> cells;
+        std::vector<RegionEdit> regions;
+        size_t memory = 0;
+    };
+
+    Map& map;
+    std::deque<Transaction> undoStack;      // Oldest first
+    std::vector<Transaction> redoStack;     // Next redo last
+    Transaction current;                    // Being recorded while depth > 0
+    int depth = 0;
+
+    size_t memoryLimit = DEFAULT_MEMORY_LIMIT;
+    size_t memoryUsage = 0;
+    size_t droppedCount = 0;
+
+    void addRegion(TileRuns before, TileRuns after);
+    void writeCell(const CellEdit& edit, bool undo);
+    void trim();
+    static size_t measure(const Transaction& transaction);
+
+public:
+    static constexpr size_t DEFAULT_MEMORY_LIMIT = 64 * 1024 * 1024;
+
+    explicit EditJournal(Map& map);
+
+    // Edits between begin and commit undo as one step. Transactions nest,
+    // the outermost name is kept. Edits outside one get their own.
+    void begin(const std::string& name);
+    void commit();
+    bool isRecording() const;
+
+    // Recorded counterparts of the Map edits, a tileID of -1 clears
+    void setTile(int x, int y, int layer, int tileID);
+    void fillRect(int x, int y, int width, int height, int layer, int tileID);
+    void clearLayers(int firstLayer, int lastLayer);
+    void pasteStamp(const TileStamp& stamp, int x, int y, bool masked = true);
+
+    // False when there is nothing to undo or redo, or while recording
+    bool undo();
+    bool redo();
+    bool canUndo() const;
+    bool canRedo() const;
+    const std::string& getUndoName() const;
+    const std::string& getRedoName() const;
+    size_t getUndoCount() const;
+    size_t getRedoCount() const;
+
+    // Also drops an open transaction, later commits for it report no begin
+    void clear();
+
+    // The newest transaction is kept even when it alone exceeds the limit
+    void setMemoryLimit(size_t bytes);
+    size_t getMemoryLimit() const;
+    size_t getMemoryUsage() const;
+    size_t getDroppedCount() const;
+};
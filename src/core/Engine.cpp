@@ -4,7 +4,33 @@
 #include "SDL3/SDL_mouse.h"
 
 #include "UI/UIManager.hpp"
+#include "core/AssetPack.hpp"
+#include "core/EditJournal.hpp"
+#include "core/MapIO.hpp"
 #include "core/TileRegistry.hpp"
+#include "utils/Profiler.hpp"
+#include "utils/Statistics.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+// Null when there is no image, cursors are skipped until theirs arrives
+SDL_Texture* createCursorTexture(SDL_Renderer* renderer, SDL_Surface* surface, const char* name) {
+    if (!surface) {
+        return nullptr;
+    }
+    SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, surface);
+    if (!texture) {
+        SDL_Log("Failed to create %s texture: %s", name, SDL_GetError());
+        return nullptr;
+    }
+    SDL_SetTextureScaleMode(texture, SDL_SCALEMODE_NEAREST);
+    return texture;
+}
+
+}
 
 IsoEngine::IsoEngine() {
     
@@ -18,28 +44,106 @@ SDL_AppResult IsoEngine::EngineInit(void **appstate, int argc, char *argv[])
 {
     SDL_SetAppMetadata("IsoEngine", "0.0.1", "com.louisravaux.isoengine");
 
+    // Command line
+    const char* recordPath = nullptr;
+    const char* replayPath = nullptr;
+    const char* assetPackPath = nullptr;
+    const char* tileManifestPath = DEFAULT_TILE_MANIFEST;
+    bool headless = false;
+    bool vsync = true;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            recordPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            replayPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--asset-pack") == 0 && i + 1 < argc) {
+            assetPackPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--tiles") == 0 && i + 1 < argc) {
+            tileManifestPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--headless") == 0) {
+            headless = true;
+        } else if (std::strcmp(argv[i], "--no-vsync") == 0) {
+            vsync = false;
+        } else {
+            SDL_Log("Usage: %s [--record file | --replay file] [--asset-pack file] [--tiles file] [--headless] [--no-vsync]", argv[0]);
+            return SDL_APP_FAILURE;
+        }
+    }
+
+    int initialWidth = WIN_WIDTH;
+    int initialHeight = WIN_HEIGHT;
+    if (replayPath) {
+        if (!inputReplay.load(replayPath)) {
+            return SDL_APP_FAILURE;
+        }
+        // Replays run flat out with every frame drawn, so frame N sees the
+        // same events it saw while recording
+        initialWidth = inputReplay.getWindowWidth();
+        initialHeight = inputReplay.getWindowHeight();
+        onDemandRendering = false;
+        vsync = false;
+    }
+
+    // The offscreen driver renders in software without opening a window
+    if (headless) {
+        SDL_SetHint(SDL_HINT_VIDEO_DRIVER, "offscreen");
+    }
+
     if (!SDL_Init(SDL_INIT_VIDEO)) {
         SDL_Log("Couldn't initialize SDL: %s", SDL_GetError());
         return SDL_APP_FAILURE;
     }
 
+    // Zones are recorded from the start so early hitches show up too
+    Profiler::setThreadName("Main");
+    Profiler::setEnabled(true);
+
     // Create a window and renderer
-    if (!SDL_CreateWindowAndRenderer("IsoEngine", WIN_WIDTH, WIN_HEIGHT, 0, &window, &renderer)) {
+    SDL_WindowFlags windowFlags = headless ? SDL_WINDOW_HIDDEN : 0;
+    if (!SDL_CreateWindowAndRenderer("IsoEngine", initialWidth, initialHeight, windowFlags, &window, &renderer)) {
         SDL_Log("Couldn't create window/renderer: %s", SDL_GetError());
         return SDL_APP_FAILURE;
     }
 
-    // set window icon
-    SDL_Surface* iconSurface = IMG_Load("assets/stone.png");
-    if (iconSurface) {
-        SDL_SetWindowIcon(window, iconSurface);
-        SDL_DestroySurface(iconSurface);
-    } else {
-        SDL_Log("Failed to load icon.png: %s", SDL_GetError());
+    // One thread per logical core, the main thread included
+    jobSystem = std::make_unique<JobSystem>();
+
+    // Images decode on the job system and reach the renderer a batch per
+    // frame; tiles draw a placeholder until theirs has arrived
+    assetLoader = std::make_unique<AssetLoader>(*jobSystem);
+
+    // Images baked by isoEngine_assetpacker go to the renderer straight from
+    // the pack, whatever it lacks is decoded from its PNG
+    AssetPack assetPack;
+    if (assetPack.open(assetPackPath ? assetPackPath : DEFAULT_ASSET_PACK)) {
+        if (!TileRegistry::loadPack(renderer, assetPack)) {
+            assetPack.close();
+        }
+    } else if (assetPackPath) {
+        SDL_Log("Couldn't open asset pack %s", assetPackPath);
+        return SDL_APP_FAILURE;
     }
 
+    auto loadImage = [this, &assetPack](const char* path, AssetLoader::ReadyFunction onReady) {
+        const AssetPack::Image* image = assetPack.findImage(path);
+        if (!image) {
+            assetLoader->load(path, std::move(onReady));
+            return;
+        }
+        SDL_Surface* surface = assetPack.createSurface(*image);
+        onReady(surface);
+        SDL_DestroySurface(surface);
+    };
+
+    // set window icon
+    loadImage("assets/stone.png", [this](SDL_Surface* surface) {
+        if (surface) {
+            SDL_SetWindowIcon(window, surface);
+        }
+    });
+
     //Enable VSync
-    if( SDL_SetRenderVSync( renderer, 1 ) == false )
+    if( vsync && SDL_SetRenderVSync( renderer, 1 ) == false )
     {
         SDL_Log( "Could not enable VSync! SDL error: %s\n", SDL_GetError() );
         return SDL_APP_FAILURE;
@@ -52,129 +156,111 @@ SDL_AppResult IsoEngine::EngineInit(void **appstate, int argc, char *argv[])
     SDL_SetWindowResizable(window, true);
 
     // Load mouse cursor texture
-    SDL_Surface* mouseCursorSurface = IMG_Load("assets/pencil.png");
-    if (mouseCursorSurface) {
-        mouseCursorTexture = SDL_CreateTextureFromSurface(renderer, mouseCursorSurface);
-        SDL_DestroySurface(mouseCursorSurface);
-        if (!mouseCursorTexture) {
-            SDL_Log("Failed to create mouse cursor texture: %s", SDL_GetError());
-        }
-        SDL_SetTextureScaleMode(mouseCursorTexture, SDL_SCALEMODE_NEAREST);
-
-    } else {
-        SDL_Log("Failed to load mouse cursor.png: %s", SDL_GetError());
-    }    
+    loadImage("assets/pencil.png", [this](SDL_Surface* surface) {
+        mouseCursorTexture = createCursorTexture(renderer, surface, "mouse cursor");
+    });
 
     // Load cursor texture
-    SDL_Surface* cursorSurface = IMG_Load("assets/cursor.png");
-    if (cursorSurface) {
-        cursorTexture = SDL_CreateTextureFromSurface(renderer, cursorSurface);
-        SDL_DestroySurface(cursorSurface);
-        if (!cursorTexture) {
-            SDL_Log("Failed to create cursor texture: %s", SDL_GetError());
-        }
-        SDL_SetTextureScaleMode(cursorTexture, SDL_SCALEMODE_NEAREST);
-
-    } else {
-        SDL_Log("Failed to load cursor.png: %s", SDL_GetError());
-    }
+    loadImage("assets/cursor.png", [this](SDL_Surface* surface) {
+        cursorTexture = createCursorTexture(renderer, surface, "cursor");
+    });
 
     // init gameLevels
     gameLevels.push_back(std::make_unique<Level>("Level 1"));
     gameLevels.push_back(std::make_unique<Level>("Level 2"));
 
+    // Tile images load when a tile of their type is first drawn. Recording
+    // and replaying load them on the main thread, so picking sees the same
+    // alpha masks on the same frames in both.
+    residencyLoader = (recordPath || replayPath) ? nullptr : assetLoader.get();
+    if (!TileRegistry::loadManifest(renderer, tileManifestPath, residencyLoader)) {
+        SDL_Log("Couldn't load tile types from %s", tileManifestPath);
+        return SDL_APP_FAILURE;
+    }
 
-    // Create a small test map
-    int layerNumber = 2;
-    gameLevels[0]->addMap(std::make_unique<Map>(8, 8, layerNumber, SDL_Color{ 135, 206, 235, 255 })); // Level 1, map 0
-    gameLevels[0]->addMap(std::make_unique<Map>(12, 12, layerNumber, SDL_Color{ 65, 202, 165, 255 })); // Level 1, map 1
-    gameLevels[0]->addMap(std::make_unique<Map>(50, 50, layerNumber, SDL_Color{ 114, 50, 50, 255 })); // Level 1, map 2
-
-    // invert color to know it is level 2
-    gameLevels[1]->addMap(std::make_unique<Map>(8, 8, layerNumber, SDL_Color{ 25, 206, 235, 255 })); // Level 2, map 0
-    gameLevels[1]->addMap(std::make_unique<Map>(12, 12, layerNumber, SDL_Color{ 25, 202, 165, 255 })); // Level 2, map 1
-    gameLevels[1]->addMap(std::make_unique<Map>(50, 50, layerNumber, SDL_Color{ 25, 50, 50, 255 })); // Level 2, map 2
-
-
-    TileRegistry::registerType(0, "Void", renderer, "assets/void.png");
-    TileRegistry::registerType(1, "Grass", renderer, "assets/grass.png");
-    TileRegistry::registerType(2, "Sand", renderer, "assets/sand.png");
-    TileRegistry::registerType(3, "Water", renderer, "assets/water.png");
-    TileRegistry::registerType(4, "Stone", renderer, "assets/stone.png");
-    TileRegistry::registerType(5, "Red Stone", renderer, "assets/red_stone.png");
-    TileRegistry::registerType(6, "Lily pad", renderer, "assets/water_lily_pad.png");
-    TileRegistry::registerType(7, "Mountains", renderer, "assets/mountains.png");
-
-    // Fill the map with texture tiles
-    // Create a simple checkerboard pattern
-    for (int layer = 0; layer < 1; ++layer) {
-        for (int y = 0; y < 8; ++y) {
-            for (int x = 0; x < 8; ++x) {
-                if ((x + y) % 2 == 0) {
-                    // Use grass texture for even positions
-                    gameLevels[0]->getMap(0)->setTile(x, y, layer, 1);
-                } else {
-                    // Use sand texture for odd positions
-                    gameLevels[0]->getMap(0)->setTile(x, y, layer, 2);
-                }
-            }
-        }
+    // The cursors must be there from the first recorded frame
+    if (recordPath || replayPath) {
+        assetLoader->finish();
     }
 
-    for (int layer = 0; layer < 1; ++layer) {
-        for (int y = 0; y < 12; ++y) {
-            for (int x = 0; x < 12; ++x) {
-                if ((x + y) % 2 == 0) {
-                    gameLevels[0]->getMap(1)->setTile(x, y, layer, 2);
-                } else {
-                    gameLevels[0]->getMap(1)->setTile(x, y, layer, 3);
-                }
-            }
+    // Levels reference their maps by file and read them when first shown.
+    // Missing files are generated with a checkerboard pattern on layer 0.
+    // Recording and replaying regenerate them all in a directory of their
+    // own, so every session starts from the same maps and the user's maps
+    // are left alone.
+    struct MapFile {
+        const char* name;
+        int size;
+        SDL_Color color;
+        int evenTile, oddTile;      // -1 leaves the map empty
+    };
+
+    const MapFile mapFiles[2][3] = {
+        {
+            { "level1_map0.isomap", 8, SDL_Color{ 135, 206, 235, 255 }, 1, 2 },     // Grass and sand
+            { "level1_map1.isomap", 12, SDL_Color{ 65, 202, 165, 255 }, 2, 3 },     // Sand and water
+            { "level1_map2.isomap", 50, SDL_Color{ 114, 50, 50, 255 }, 4, 5 },      // Stone and red stone
+        },
+        {
+            // invert color to know it is level 2
+            { "level2_map0.isomap", 8, SDL_Color{ 25, 206, 235, 255 }, -1, -1 },
+            { "level2_map1.isomap", 12, SDL_Color{ 25, 202, 165, 255 }, -1, -1 },
+            { "level2_map2.isomap", 50, SDL_Color{ 25, 50, 50, 255 }, 4, 5 },
         }
-    }
+    };
 
-    for (int layer = 0; layer < 1; ++layer) {
-        for (int y = 0; y < 50; ++y) {
-            for (int x = 0; x < 50; ++x) {
-                if ((x + y) % 2 == 0) {
-                    gameLevels[0]->getMap(2)->setTile(x, y, layer, 4);
-                } else {
-                    gameLevels[0]->getMap(2)->setTile(x, y, layer, 5);
-                }
+    const int layerNumber = 2;
+    const bool regenerate = recordPath || replayPath;
+    const std::string mapDirectory = regenerate ? SESSION_MAP_DIRECTORY : MAP_DIRECTORY;
+    SDL_CreateDirectory(mapDirectory.c_str());
+
+    // Each map is generated and saved by its own job, maps share no state
+    JobCounter generation;
+    for (const auto& levelFiles : mapFiles) {
+        for (const MapFile& file : levelFiles) {
+            std::string path = mapDirectory + "/" + file.name;
+            if (!regenerate && SDL_GetPathInfo(path.c_str(), nullptr)) {
+                continue;
             }
-        }
-    }
 
-        for (int layer = 0; layer < 1; ++layer) {
-        for (int y = 0; y < 50; ++y) {
-            for (int x = 0; x < 50; ++x) {
-                if ((x + y) % 2 == 0) {
-                    gameLevels[1]->getMap(2)->setTile(x, y, layer, 4);
-                } else {
-                    gameLevels[1]->getMap(2)->setTile(x, y, layer, 5);
+            jobSystem->run("Generate map", [this, &file, path, layerNumber] {
+                Map map(file.size, file.size, layerNumber, file.color);
+                for (int y = 0; file.evenTile >= 0 && y < file.size; ++y) {
+                    for (int x = 0; x < file.size; ++x) {
+                        map.setTile(x, y, 0, (x + y) % 2 == 0 ? file.evenTile : file.oddTile);
+                    }
                 }
-            }
+
+                // Center the camera on the map
+                map.setCamera(-WIN_WIDTH/2.0f, -WIN_HEIGHT/4.0f);
+                MapIO::saveMap(map, path);
+            }, &generation);
         }
     }
-        
-    // Add a special water tile in the center
-    // gameMap->setTile(2, 2, 1, 3);
-    // gameMap->setTile(2, 2, 2, 2);
+    jobSystem->wait(generation);
 
-    // Center the camera on the map
-    gameLevels[0]->getMap(0)->setCamera(-WIN_WIDTH/2.0f, -WIN_HEIGHT/4.0f);
-    gameLevels[0]->getMap(1)->setCamera(-WIN_WIDTH/2.0f, -WIN_HEIGHT/4.0f);
-    gameLevels[0]->getMap(2)->setCamera(-WIN_WIDTH/2.0f, -WIN_HEIGHT/4.0f);
+    for (size_t level = 0; level < gameLevels.size(); ++level) {
+        for (const MapFile& file : mapFiles[level]) {
+            gameLevels[level]->addMapFile(mapDirectory + "/" + file.name);
+        }
+        gameLevels[level]->setJobSystem(jobSystem.get());
 
-    gameLevels[1]->getMap(0)->setCamera(-WIN_WIDTH/2.0f, -WIN_HEIGHT/4.0f);
-    gameLevels[1]->getMap(1)->setCamera(-WIN_WIDTH/2.0f, -WIN_HEIGHT/4.0f);
-    gameLevels[1]->getMap(2)->setCamera(-WIN_WIDTH/2.0f, -WIN_HEIGHT/4.0f);
+        // Reads the first map and starts prefetching the second
+        if (!gameLevels[level]->getCurrentMap()) {
+            SDL_Log("Couldn't load map %s/%s", mapDirectory.c_str(), mapFiles[level][0].name);
+            return SDL_APP_FAILURE;
+        }
+    }
 
     uiManager = std::make_unique<UIDebug>(this);
 
     // Initialize UI Manager
     uiManager->init(window, renderer);
 
+    if (recordPath && !inputRecorder.open(recordPath, initialWidth, initialHeight)) {
+        return SDL_APP_FAILURE;
+    }
+
     return SDL_APP_CONTINUE;
 }
 
@@ -184,22 +270,39 @@ SDL_AppResult IsoEngine::EngineEvent(void *appstate, SDL_Event *event)
         return SDL_APP_SUCCESS;
     }
 
+    // A replay owns the input, live events would make it diverge
+    if (inputReplay.isLoaded()) {
+        return SDL_APP_CONTINUE;
+    }
+
+    inputRecorder.recordEvent(frameIndex, *event);
+    return handleEvent(event);
+}
+
+SDL_AppResult IsoEngine::handleEvent(SDL_Event *event)
+{
+    PROFILE_ZONE("EngineEvent");
+
+    if (event->type == SDL_EVENT_QUIT) {
+        return SDL_APP_SUCCESS;
+    }
+
+    // Any input can change the scene or the UI, draw at least a few frames
+    markSceneDirty();
+
     // Handle UI events
     uiManager->event(event);
     ImGuiIO& io = uiManager->getIO();
 
-    // Handle mouse movement for tile selection
+    // Mouse movement only records the position, selection and painting
+    // catch up once per frame
     if (event->type == SDL_EVENT_MOUSE_MOTION && !io.WantCaptureMouse) {
         mouseX = static_cast<int>(event->motion.x);
         mouseY = static_cast<int>(event->motion.y);
-        
-        int gridX, gridY;
-        if (gameLevels[activeLevelIndex]->getCurrentMap()->getSelectedTile(mouseX, mouseY, gridX, gridY)) {
-            selectedTileX = gridX;
-            selectedTileY = gridY;
-        } else { // No valid tile selected
-            selectedTileX = -1;
-            selectedTileY = -1;
+        pointerMoved = true;
+
+        if (strokeMap) {
+            strokePoints.push_back({ mouseX, mouseY });
         }
     }
 
@@ -207,18 +310,34 @@ SDL_AppResult IsoEngine::EngineEvent(void *appstate, SDL_Event *event)
     if (event->type == SDL_EVENT_MOUSE_BUTTON_DOWN && !io.WantCaptureMouse) {
 
         if (event->button.button == SDL_BUTTON_LEFT) {
-            if (selectedTileX >= 0 && selectedTileY >= 0) {
-                gameLevels[activeLevelIndex]->getCurrentMap()->setTile(selectedTileX, selectedTileY, selectedLayer, selectedTileType);
-            }
+            mouseX = static_cast<int>(event->button.x);
+            mouseY = static_cast<int>(event->button.y);
+            beginStroke();
         }
         if (event->button.button == SDL_BUTTON_MIDDLE) {
             uiManager->toggleVisibility();
         }
     }
+
+    // The release still ends a stroke when the UI has taken the mouse
+    if (event->type == SDL_EVENT_MOUSE_BUTTON_UP && event->button.button == SDL_BUTTON_LEFT) {
+        endStroke();
+    }
     
     // Simple camera controls with arrow keys
     if (event->type == SDL_EVENT_KEY_DOWN && !io.WantCaptureKeyboard) {
         const float cameraSpeed = 32.0f;
+
+        // Ctrl+Z undoes, Ctrl+Y or Ctrl+Shift+Z redoes
+        if (event->key.mod & SDL_KMOD_CTRL) {
+            EditJournal& journal = gameLevels[activeLevelIndex]->getCurrentMap()->getJournal();
+            if (event->key.key == SDLK_Z && !(event->key.mod & SDL_KMOD_SHIFT)) {
+                journal.undo();
+            } else if (event->key.key == SDLK_Y || event->key.key == SDLK_Z) {
+                journal.redo();
+            }
+        }
+
         switch (event->key.key) {
             case SDLK_LEFT:
                 gameLevels[activeLevelIndex]->getCurrentMap()->moveCamera(-cameraSpeed, 0);
@@ -257,34 +376,163 @@ SDL_AppResult IsoEngine::EngineEvent(void *appstate, SDL_Event *event)
     return SDL_APP_CONTINUE;
 }
 
+void IsoEngine::beginStroke() {
+    endStroke();
+
+    strokeMap = gameLevels[activeLevelIndex]->getCurrentMap();
+    strokeMap->getJournal().begin("Paint");
+    strokePoints.assign(1, { mouseX, mouseY });
+    strokeHasAnchor = false;
+}
+
+void IsoEngine::endStroke() {
+    if (!strokeMap) {
+        return;
+    }
+
+    // Paint what arrived since the last frame, the stroke is one undo step
+    updatePointer();
+    strokeMap->getJournal().commit();
+    strokeMap = nullptr;
+    strokePoints.clear();
+}
+
+void IsoEngine::updatePointer() {
+    PROFILE_ZONE("Pointer");
+    Map* map = gameLevels[activeLevelIndex]->getCurrentMap();
+
+    // Select the tile drawn under the pointer, or the empty cell of the
+    // current layer when there is none
+    if (pointerMoved) {
+        pointerMoved = false;
+        int gridX, gridY, layer;
+        if (map->pickTile(mouseX, mouseY, gridX, gridY, layer)) {
+            selectedTileX = gridX;
+            selectedTileY = gridY;
+            selectedTileLayer = layer;
+        } else if (map->getSelectedTile(mouseX, mouseY, gridX, gridY, selectedLayer)) {
+            selectedTileX = gridX;
+            selectedTileY = gridY;
+            selectedTileLayer = -1;
+        } else { // No valid tile selected
+            selectedTileX = -1;
+            selectedTileY = -1;
+            selectedTileLayer = -1;
+        }
+    }
+
+    if (!strokeMap || strokePoints.empty()) {
+        return;
+    }
+
+    // Continue from where the previous frame stopped so strokes stay connected
+    strokeGrid.clear();
+    if (strokeHasAnchor) {
+        strokeGrid.push_back(strokeAnchor);
+    }
+    for (const BrushCell& point : strokePoints) {
+        BrushCell cell;
+        strokeMap->getSelectedTile(point.x, point.y, cell.x, cell.y, selectedLayer);
+        if (strokeGrid.empty() || cell.x != strokeGrid.back().x || cell.y != strokeGrid.back().y) {
+            strokeGrid.push_back(cell);
+        }
+    }
+    strokePoints.clear();
+    strokeAnchor = strokeGrid.back();
+    strokeHasAnchor = true;
+
+    brush.rasterize(strokeGrid, strokeCells);
+    EditJournal& journal = strokeMap->getJournal();
+    const bool bounded = strokeMap->isBounded();
+    for (const BrushCell& cell : strokeCells) {
+        if (bounded && (cell.x < 0 || cell.y < 0 || cell.x >= strokeMap->getWidth() || cell.y >= strokeMap->getHeight())) {
+            continue;
+        }
+        journal.setTile(cell.x, cell.y, selectedLayer, selectedTileType);
+    }
+}
+
 SDL_AppResult IsoEngine::EngineIterate(void *appstate) 
 {
+    if (inputReplay.isLoaded()) {
+        if (inputReplay.isFinished(frameIndex)) {
+            reportReplay();
+            return SDL_APP_SUCCESS;
+        }
+
+        // Feed what was handled before this frame while recording
+        SDL_Event event;
+        while (inputReplay.nextEvent(frameIndex, SDL_GetWindowID(window), event)) {
+            if (event.type == SDL_EVENT_WINDOW_RESIZED) {
+                SDL_SetWindowSize(window, event.window.data1, event.window.data2);
+            }
+            handleEvent(&event);
+        }
+    }
+
+    if (!needsRedraw()) {
+        return SDL_APP_CONTINUE;
+    }
+
+    PROFILE_ZONE("EngineIterate");
+    Uint64 frameStartNs = SDL_GetTicksNS();
+    frameIndex++;
+
+    // Images decoded since the last frame replace their placeholders
+    assetLoader->update();
+
+    // Remember what this frame shows; changes made while it is being built,
+    // e.g. by the UI, are picked up by the next check
+    renderedSceneRevision = sceneRevision;
+    renderedMap = gameLevels[activeLevelIndex]->getCurrentMap();
+    renderedMapRevision = renderedMap ? renderedMap->getRevision() : 0;
+    lastFrameTicks = SDL_GetTicks();
+    if (settleFrames > 0) {
+        settleFrames--;
+    }
+
+    // A stroke only paints the map it started on
+    if (strokeMap && strokeMap != gameLevels[activeLevelIndex]->getCurrentMap()) {
+        endStroke();
+    }
+
+    // Maps are only unloaded here, pointers taken during the last frame
+    // are done with
+    for (auto& level : gameLevels) {
+        level->trimToBudget();
+    }
+
+    updatePointer();
 
     uiManager->update();
 
-    // Clear screen to sky blue
-    SDL_SetRenderDrawColor(renderer, gameLevels[activeLevelIndex]->getCurrentMap()->getBackgroundColor().r, gameLevels[activeLevelIndex]->getCurrentMap()->getBackgroundColor().g, gameLevels[activeLevelIndex]->getCurrentMap()->getBackgroundColor().b, gameLevels[activeLevelIndex]->getCurrentMap()->getBackgroundColor().a);
+    // Clear screen to the map's background color
+    Map* currentMap = gameLevels[activeLevelIndex]->getCurrentMap();
+    if (currentMap) {
+        SDL_Color background = currentMap->getBackgroundColor();
+        SDL_SetRenderDrawColor(renderer, background.r, background.g, background.b, background.a);
+    }
     SDL_RenderClear(renderer);
 
     // Render the map
-    if (gameLevels[activeLevelIndex]->getCurrentMap()) {
-        gameLevels[activeLevelIndex]->getCurrentMap()->renderWithCamera(renderer, gameLevels[activeLevelIndex]->getCurrentMap()->getCameraX(), gameLevels[activeLevelIndex]->getCurrentMap()->getCameraY());
+    if (currentMap) {
+        currentMap->renderWithCamera(renderer, currentMap->getCameraX(), currentMap->getCameraY(), parallelRenderLists ? jobSystem.get() : nullptr);
 
         // Render cursor on selected tile
-        if (cursorTexture && selectedTileX >= 0 && selectedTileY >= 0) {
+        if (cursorTexture && selectedTileX >= 0 && selectedTileY >= 0 && selectedTileLayer >= 0) {
             // Get the actual tile at this position
-            Tile* selectedTile = gameLevels[activeLevelIndex]->getCurrentMap()->getTile(selectedTileX, selectedTileY, selectedLayer);
+            std::optional<Tile> selectedTile = currentMap->getTile(selectedTileX, selectedTileY, selectedTileLayer);
             if (selectedTile) {
 
                 // Get zoom factor
-                float zoom = gameLevels[activeLevelIndex]->getCurrentMap()->getCameraZoom();
+                float zoom = currentMap->getCameraZoom();
 
                 // Calculate cursor size with zoom
                 const float CURSOR_SIZE = 64.0f * zoom;
 
                 // Apply the same camera offset as the map does
-                float cursorX = (selectedTile->getScreenX() * zoom) - CURSOR_SIZE * 0.5f - gameLevels[activeLevelIndex]->getCurrentMap()->getCameraX();
-                float cursorY = (selectedTile->getScreenY() * zoom) - gameLevels[activeLevelIndex]->getCurrentMap()->getCameraY();
+                float cursorX = (selectedTile->getScreenX() * zoom) - CURSOR_SIZE * 0.5f - currentMap->getCameraX();
+                float cursorY = (selectedTile->getScreenY() * zoom) - currentMap->getCameraY() - selectedTileLayer * CURSOR_SIZE * 0.5f;
 
                 SDL_FRect cursorRect = {
                     cursorX,
@@ -305,21 +553,76 @@ SDL_AppResult IsoEngine::EngineIterate(void *appstate)
         32.0f, // Width of the cursor
         32.0f  // Height of the cursor
     };
-    SDL_RenderTexture(renderer, mouseCursorTexture, nullptr, &mouseCursorRect);
+    if (mouseCursorTexture) {
+        SDL_RenderTexture(renderer, mouseCursorTexture, nullptr, &mouseCursorRect);
+    }
 
-    uiManager->content();
+    {
+        PROFILE_ZONE("UIManager::content");
+        uiManager->content();
+    }
     uiManager->render(renderer);
 
+    // Load the tile images this frame asked for, evict unused ones
+    TileRegistry::updateResidency(renderer, residencyLoader);
+    renderedTileRevision = TileRegistry::getRevision();
+
     // Present the frame
-    SDL_RenderPresent(renderer);
+    {
+        PROFILE_ZONE("SDL_RenderPresent");
+        SDL_RenderPresent(renderer);
+    }
+
+    if (inputReplay.isLoaded()) {
+        replayFrameMs.push_back((SDL_GetTicksNS() - frameStartNs) / 1.0e6);
+    }
 
     return SDL_APP_CONTINUE;
 }
 
+// Frame times of the replay and a hash of every map, comparable across runs
+void IsoEngine::reportReplay() const {
+    std::vector<double> sorted = replayFrameMs;
+    std::sort(sorted.begin(), sorted.end());
+
+    if (!sorted.empty()) {
+        double total = 0.0;
+        for (double value : sorted) {
+            total += value;
+        }
+        SDL_Log("Replay: %zu frames, %.1f ms total", sorted.size(), total);
+        SDL_Log("Frame ms: min %.3f  mean %.3f  p50 %.3f  p95 %.3f  p99 %.3f  max %.3f",
+                sorted.front(), total / sorted.size(), Statistics::percentile(sorted, 0.50),
+                Statistics::percentile(sorted, 0.95), Statistics::percentile(sorted, 0.99), sorted.back());
+    } else {
+        SDL_Log("Replay: no frames rendered");
+    }
+
+    // FNV-1a over the level hashes, which cover every map loaded or not
+    uint64_t hash = 14695981039346656037ull;
+    for (const auto& level : gameLevels) {
+        hash = (hash ^ level->computeStateHash()) * 1099511628211ull;
+    }
+    SDL_Log("Map state hash: %016llx", static_cast<unsigned long long>(hash));
+}
+
 void IsoEngine::EngineQuit(void *appstate, SDL_AppResult result) 
 {
     // Cleanup
-    gameLevels[activeLevelIndex].reset(); // Destroy the maps
+    inputRecorder.close(frameIndex);
+
+    // Keep the edits of the maps still loaded
+    for (auto& level : gameLevels) {
+        level->saveMaps();
+    }
+
+    // Destroy the maps and the atlas while the renderer that owns their
+    // textures is still alive
+    residencyLoader = nullptr;
+    assetLoader.reset();
+    gameLevels.clear();
+    TileRegistry::clear();
+    jobSystem.reset();
 
     if (cursorTexture) {
         SDL_DestroyTexture(cursorTexture);
@@ -343,6 +646,51 @@ void IsoEngine::EngineQuit(void *appstate, SDL_AppResult result)
     SDL_Quit();
 }
 
+// On-demand rendering
+
+void IsoEngine::markSceneDirty() {
+    sceneRevision++;
+    settleFrames = UI_SETTLE_FRAMES;
+}
+
+bool IsoEngine::needsRedraw() const {
+    // Frames keep coming while images arrive so they can be uploaded
+    if (!onDemandRendering || inputReplay.isLoaded() || settleFrames > 0 || sceneRevision != renderedSceneRevision
+        || !assetLoader->isFinished() || TileRegistry::getRevision() != renderedTileRevision) {
+        return true;
+    }
+
+    const Map* map = gameLevels[activeLevelIndex]->getCurrentMap();
+    if (map != renderedMap || (map && map->getRevision() != renderedMapRevision)) {
+        return true;
+    }
+
+    // Keep the debug UI ticking at a low rate while it is on screen
+    return !uiManager->getIsHidden() && SDL_GetTicks() - lastFrameTicks >= UI_REFRESH_INTERVAL_MS;
+}
+
+bool IsoEngine::isIdle() const {
+    return !needsRedraw();
+}
+
+// Milliseconds the main loop may block waiting for events, -1 for no limit
+Sint32 IsoEngine::getIdleTimeout() const {
+    if (uiManager->getIsHidden()) {
+        return -1;
+    }
+
+    Uint64 elapsed = SDL_GetTicks() - lastFrameTicks;
+    return elapsed >= UI_REFRESH_INTERVAL_MS ? 0 : static_cast<Sint32>(UI_REFRESH_INTERVAL_MS - elapsed);
+}
+
+bool IsoEngine::isRecording() const {
+    return inputRecorder.isOpen();
+}
+
+bool IsoEngine::isReplaying() const {
+    return inputReplay.isLoaded();
+}
+
 // getters
 
 SDL_Window* IsoEngine::getWindow() const {
@@ -2,10 +2,15 @@
 
 #pragma once
 
+#include "core/AssetLoader.hpp"
+#include "core/Brush.hpp"
+#include "core/InputRecording.hpp"
+#include "core/JobSystem.hpp"
 #include "core/Level.hpp"
 #include "SDL3/SDL_init.h"
 #include <SDL3/SDL.h>
 #include <memory>
+#include <vector>
 
 #include "UI/UIDebug.hpp"
 
@@ -15,6 +20,16 @@ private:
     const int WIN_WIDTH = 1280;
     const int WIN_HEIGHT = 720;
 
+    // Used when present unless --asset-pack names another
+    static constexpr const char* DEFAULT_ASSET_PACK = "assets/assets.isopack";
+
+    // Map files, and the ones recording and replaying generate afresh
+    static constexpr const char* MAP_DIRECTORY = "maps";
+    static constexpr const char* SESSION_MAP_DIRECTORY = "maps/session";
+
+    // Tile types, unless --tiles names another manifest
+    static constexpr const char* DEFAULT_TILE_MANIFEST = "assets/tiles.manifest";
+
     int windowWidth;
     int windowHeight;
 
@@ -23,6 +38,39 @@ private:
 
     std::unique_ptr<UIManager> uiManager = nullptr;
 
+    // On-demand rendering state
+    const int UI_SETTLE_FRAMES = 3;             // Frames drawn after input so ImGui can settle
+    const Uint64 UI_REFRESH_INTERVAL_MS = 250;  // Idle refresh period while the debug UI is shown
+    uint64_t sceneRevision = 0;
+    uint64_t renderedSceneRevision = 0;
+    const Map* renderedMap = nullptr;
+    uint64_t renderedMapRevision = 0;
+    uint64_t renderedTileRevision = 0;
+    int settleFrames = 0;
+    Uint64 lastFrameTicks = 0;
+
+    // Input recording and replay, see --record and --replay
+    InputRecorder inputRecorder;
+    InputReplay inputReplay;
+    uint64_t frameIndex = 0;                // Rendered frames so far
+    std::vector<double> replayFrameMs;
+
+    // Pointer state gathered from the events of a frame. Picking and
+    // painting run once per frame in updatePointer, however many motion
+    // events arrived.
+    bool pointerMoved = false;
+    Map* strokeMap = nullptr;                   // Map being painted, null between strokes
+    std::vector<BrushCell> strokePoints;        // Screen positions since the last frame
+    BrushCell strokeAnchor = { 0, 0 };          // Grid cell the stroke reached last frame
+    bool strokeHasAnchor = false;
+    std::vector<BrushCell> strokeGrid, strokeCells;
+
+    SDL_AppResult handleEvent(SDL_Event *event);
+    void reportReplay() const;
+    void beginStroke();
+    void endStroke();
+    void updatePointer();
+
 public:
     IsoEngine();
     ~IsoEngine();
@@ -34,9 +82,22 @@ public:
     // selection
     int selectedTileX = -1;  // -1 means no tile selected
     int selectedTileY = -1;
+    int selectedTileLayer = -1;  // Layer of the picked tile, -1 over empty cells
     int mouseX = 0, mouseY = 0;
     int selectedTileType = 1;
     int selectedLayer = 0;
+    Brush brush;
+
+    // Skip frames while nothing on screen has changed
+    bool onDemandRendering = true;
+
+    // Engine-wide job scheduler, one thread per logical core
+    std::unique_ptr<JobSystem> jobSystem;
+
+    // Images decoding in the background, uploaded a batch per frame
+    std::unique_ptr<AssetLoader> assetLoader;
+    AssetLoader* residencyLoader = nullptr;   // Loads tile images, null to load them in place
+    bool parallelRenderLists = true;       // Build the map's render lists as jobs
 
     // Game objects
     int activeLevelIndex = 0;
@@ -44,6 +105,15 @@ public:
 
     SDL_Window* getWindow() const;
 
+    // On-demand rendering
+    void markSceneDirty();
+    bool needsRedraw() const;
+    bool isIdle() const;
+    Sint32 getIdleTimeout() const;
+
+    bool isRecording() const;
+    bool isReplaying() const;
+
     SDL_AppResult EngineInit(void **appstate, int argc, char *argv[]);
     SDL_AppResult EngineEvent(void *appstate, SDL_Event *event);
     SDL_AppResult EngineIterate(void *appstate);
@@ -0,0 +1,270 @@
+// InputRecording.cpp
+
+#include "InputRecording.hpp"
+#include "utils/BinaryIO.hpp"
+#include <cstring>
+
+using InputRecording::RecordKind;
+using namespace BinaryIO;
+
+// ---------------------------------------------------------------------------
+// InputRecorder
+
+InputRecorder::~InputRecorder() {
+    if (file) {
+        close(lastFrame);
+    }
+}
+
+bool InputRecorder::open(const char* path, int windowWidth, int windowHeight) {
+    file = std::fopen(path, "wb");
+    if (!file) {
+        SDL_Log("Couldn't open recording %s for writing", path);
+        return false;
+    }
+
+    std::vector<uint8_t> header(InputRecording::MAGIC, InputRecording::MAGIC + 4);
+    putU16(header, InputRecording::VERSION);
+    putU16(header, 0);
+    putU32(header, static_cast<uint32_t>(windowWidth));
+    putU32(header, static_cast<uint32_t>(windowHeight));
+    std::fwrite(header.data(), 1, header.size(), file);
+
+    lastFrame = 0;
+    return true;
+}
+
+bool InputRecorder::isOpen() const {
+    return file != nullptr;
+}
+
+void InputRecorder::recordEvent(uint64_t frame, const SDL_Event& event) {
+    if (!file) {
+        return;
+    }
+
+    record.clear();
+    putVarint(record, frame - lastFrame);
+
+    switch (event.type) {
+        case SDL_EVENT_MOUSE_MOTION:
+            putU8(record, static_cast<uint8_t>(RecordKind::MouseMotion));
+            putF32(record, event.motion.x);
+            putF32(record, event.motion.y);
+            break;
+        case SDL_EVENT_MOUSE_BUTTON_DOWN:
+        case SDL_EVENT_MOUSE_BUTTON_UP:
+            putU8(record, static_cast<uint8_t>(RecordKind::MouseButton));
+            putU8(record, event.button.button);
+            putU8(record, event.button.down ? 1 : 0);
+            putU8(record, event.button.clicks);
+            putF32(record, event.button.x);
+            putF32(record, event.button.y);
+            break;
+        case SDL_EVENT_MOUSE_WHEEL:
+            putU8(record, static_cast<uint8_t>(RecordKind::MouseWheel));
+            putF32(record, event.wheel.x);
+            putF32(record, event.wheel.y);
+            putF32(record, event.wheel.mouse_x);
+            putF32(record, event.wheel.mouse_y);
+            break;
+        case SDL_EVENT_KEY_DOWN:
+        case SDL_EVENT_KEY_UP:
+            putU8(record, static_cast<uint8_t>(RecordKind::Key));
+            putU8(record, event.key.down ? 1 : 0);
+            putU8(record, event.key.repeat ? 1 : 0);
+            putU32(record, event.key.key);
+            putU32(record, static_cast<uint32_t>(event.key.scancode));
+            putU16(record, event.key.mod);
+            break;
+        case SDL_EVENT_TEXT_INPUT: {
+            size_t length = event.text.text ? std::strlen(event.text.text) : 0;
+            putU8(record, static_cast<uint8_t>(RecordKind::TextInput));
+            putVarint(record, length);
+            record.insert(record.end(), event.text.text, event.text.text + length);
+            break;
+        }
+        case SDL_EVENT_WINDOW_RESIZED:
+            putU8(record, static_cast<uint8_t>(RecordKind::WindowResized));
+            putU32(record, static_cast<uint32_t>(event.window.data1));
+            putU32(record, static_cast<uint32_t>(event.window.data2));
+            break;
+        default:
+            return;
+    }
+
+    std::fwrite(record.data(), 1, record.size(), file);
+    lastFrame = frame;
+}
+
+void InputRecorder::close(uint64_t frame) {
+    if (!file) {
+        return;
+    }
+
+    record.clear();
+    putVarint(record, frame - lastFrame);
+    putU8(record, static_cast<uint8_t>(RecordKind::End));
+    std::fwrite(record.data(), 1, record.size(), file);
+
+    std::fclose(file);
+    file = nullptr;
+}
+
+// ---------------------------------------------------------------------------
+// InputReplay
+
+bool InputReplay::load(const char* path) {
+    loaded = false;
+    data.clear();
+    cursor = 0;
+
+    if (!readFile(path, data)) {
+        SDL_Log("Couldn't open recording %s", path);
+        return false;
+    }
+
+    Reader reader(data, cursor);
+    bool magicOk = data.size() >= 4 && std::memcmp(data.data(), InputRecording::MAGIC, 4) == 0;
+    cursor = 4;
+    uint16_t version = reader.u16();
+    reader.u16();
+    windowWidth = static_cast<int>(reader.u32());
+    windowHeight = static_cast<int>(reader.u32());
+
+    if (!magicOk || !reader.isOk() || version != InputRecording::VERSION) {
+        SDL_Log("%s is not a version %u input recording", path, InputRecording::VERSION);
+        data.clear();
+        return false;
+    }
+
+    nextFrame = 0;
+    endFrame = 0;
+    loaded = readFrameDelta();
+    return loaded;
+}
+
+// Advance nextFrame to the frame of the record at cursor
+bool InputReplay::readFrameDelta() {
+    if (cursor >= data.size()) {
+        // Truncated recording, end after the last complete record
+        endFrame = nextFrame;
+        return true;
+    }
+
+    Reader reader(data, cursor);
+    nextFrame += reader.varint();
+    if (!reader.isOk() || cursor >= data.size()) {
+        cursor = data.size();
+        endFrame = nextFrame;
+        return reader.isOk();
+    }
+
+    if (static_cast<RecordKind>(data[cursor]) == RecordKind::End) {
+        endFrame = nextFrame;
+        cursor = data.size();
+    }
+    return true;
+}
+
+bool InputReplay::isLoaded() const {
+    return loaded;
+}
+
+int InputReplay::getWindowWidth() const {
+    return windowWidth;
+}
+
+int InputReplay::getWindowHeight() const {
+    return windowHeight;
+}
+
+uint64_t InputReplay::getEndFrame() const {
+    return endFrame;
+}
+
+bool InputReplay::nextEvent(uint64_t frame, SDL_WindowID windowID, SDL_Event& event) {
+    if (!loaded || cursor >= data.size() || nextFrame != frame) {
+        return false;
+    }
+
+    Reader reader(data, cursor);
+    SDL_zero(event);
+
+    switch (static_cast<RecordKind>(reader.u8())) {
+        case RecordKind::MouseMotion:
+            event.type = SDL_EVENT_MOUSE_MOTION;
+            event.motion.windowID = windowID;
+            event.motion.x = reader.f32();
+            event.motion.y = reader.f32();
+            break;
+        case RecordKind::MouseButton: {
+            event.button.button = reader.u8();
+            event.button.down = reader.u8() != 0;
+            event.type = event.button.down ? SDL_EVENT_MOUSE_BUTTON_DOWN : SDL_EVENT_MOUSE_BUTTON_UP;
+            event.button.windowID = windowID;
+            event.button.clicks = reader.u8();
+            event.button.x = reader.f32();
+            event.button.y = reader.f32();
+            break;
+        }
+        case RecordKind::MouseWheel:
+            event.type = SDL_EVENT_MOUSE_WHEEL;
+            event.wheel.windowID = windowID;
+            event.wheel.direction = SDL_MOUSEWHEEL_NORMAL;
+            event.wheel.x = reader.f32();
+            event.wheel.y = reader.f32();
+            event.wheel.mouse_x = reader.f32();
+            event.wheel.mouse_y = reader.f32();
+            break;
+        case RecordKind::Key:
+            event.key.down = reader.u8() != 0;
+            event.type = event.key.down ? SDL_EVENT_KEY_DOWN : SDL_EVENT_KEY_UP;
+            event.key.windowID = windowID;
+            event.key.repeat = reader.u8() != 0;
+            event.key.key = reader.u32();
+            event.key.scancode = static_cast<SDL_Scancode>(reader.u32());
+            event.key.mod = reader.u16();
+            break;
+        case RecordKind::TextInput: {
+            uint64_t length = reader.varint();
+            if (!reader.isOk() || length > data.size() - cursor) {
+                cursor = data.size();
+                return false;
+            }
+            text.assign(reinterpret_cast<const char*>(data.data() + cursor), static_cast<size_t>(length));
+            cursor += static_cast<size_t>(length);
+            event.type = SDL_EVENT_TEXT_INPUT;
+            event.text.windowID = windowID;
+            event.text.text = text.c_str();
+            break;
+        }
+        case RecordKind::WindowResized:
+            event.type = SDL_EVENT_WINDOW_RESIZED;
+            event.window.windowID = windowID;
+            event.window.data1 = static_cast<Sint32>(reader.u32());
+            event.window.data2 = static_cast<Sint32>(reader.u32());
+            break;
+        default:
+            reader.u8();
+            SDL_Log("Unknown record in input recording, stopping replay");
+            cursor = data.size();
+            endFrame = frame;
+            return false;
+    }
+
+    if (!reader.isOk()) {
+        SDL_Log("Input recording is truncated, stopping replay");
+        cursor = data.size();
+        endFrame = frame;
+        return false;
+    }
+
+    event.common.timestamp = SDL_GetTicksNS();
+    readFrameDelta();
+    return true;
+}
+
+bool InputReplay::isFinished(uint64_t frame) const {
+    return !loaded || (cursor >= data.size() && frame >= endFrame);
+}
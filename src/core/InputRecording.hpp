@@ -0,0 +1,82 @@
+// InputRecording.hpp
+
+#pragma once
+
+#include <SDL3/SDL.h>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Binary input recordings, little endian:
+//   header  "ISOR", u16 version, u16 reserved, i32 window width, i32 window height
+//   record  varint frame delta, u8 kind, kind-specific payload
+// Only the event types the engine reacts to are stored. An End record
+// carries the frame the session stopped at.
+namespace InputRecording {
+    constexpr char MAGIC[4] = { 'I', 'S', 'O', 'R' };
+    constexpr uint16_t VERSION = 1;
+
+    enum class RecordKind : uint8_t {
+        End,
+        MouseMotion,    // f32 x, f32 y
+        MouseButton,    // u8 button, u8 down, u8 clicks, f32 x, f32 y
+        MouseWheel,     // f32 x, f32 y, f32 mouseX, f32 mouseY
+        Key,            // u8 down, u8 repeat, u32 key, u32 scancode, u16 mod
+        TextInput,      // varint length, bytes
+        WindowResized   // i32 width, i32 height
+    };
+}
+
+// Appends live events to a recording file as they are handled
+class InputRecorder {
+
+private:
+    FILE* file = nullptr;
+    uint64_t lastFrame = 0;
+    std::vector<uint8_t> record;    // Scratch for the record being written
+
+public:
+    InputRecorder() = default;
+    ~InputRecorder();
+
+    InputRecorder(const InputRecorder&) = delete;
+    InputRecorder& operator=(const InputRecorder&) = delete;
+
+    bool open(const char* path, int windowWidth, int windowHeight);
+    bool isOpen() const;
+
+    // Events of types the engine ignores are skipped
+    void recordEvent(uint64_t frame, const SDL_Event& event);
+
+    // Write the End record and close the file
+    void close(uint64_t frame);
+};
+
+// Feeds a recording back one frame at a time
+class InputReplay {
+
+private:
+    std::vector<uint8_t> data;
+    size_t cursor = 0;
+    uint64_t nextFrame = 0;         // Frame of the record at cursor
+    uint64_t endFrame = 0;
+    bool loaded = false;
+    int windowWidth = 0, windowHeight = 0;
+    std::string text;               // Backing store for the current text input event
+
+    bool readFrameDelta();
+
+public:
+    bool load(const char* path);
+    bool isLoaded() const;
+
+    int getWindowWidth() const;
+    int getWindowHeight() const;
+    uint64_t getEndFrame() const;
+
+    // Next event recorded for this frame, stamped with the live window's
+    // ID. Returns false once the frame has no more events.
+    bool nextEvent(uint64_t frame, SDL_WindowID windowID, SDL_Event& event);
+    bool isFinished(uint64_t frame) const;
+};
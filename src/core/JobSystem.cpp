@@ -0,0 +1,299 @@
+// JobSystem.cpp
+
+#include "JobSystem.hpp"
+#include "utils/Profiler.hpp"
+
+#include <SDL3/SDL.h>
+
+#include <algorithm>
+#include <map>
+
+// A job parked on its dependency's counter
+struct JobCounter::PendingJob {
+    JobSystem* system;
+    const char* name;
+    JobSystem::JobFunction function;
+    JobCounter* counter;
+};
+
+namespace {
+
+// Worker slot of the calling thread in the system it belongs to
+thread_local const JobSystem* threadSystem = nullptr;
+thread_local int threadWorker = -1;
+
+}
+
+JobCounter::JobCounter() = default;
+
+// The last finishing job may still be inside the counter's lock when a
+// waiter sees zero and destroys it; wait for it to leave
+JobCounter::~JobCounter() {
+    std::lock_guard<std::mutex> lock(mutex);
+}
+
+JobSystem::JobSystem(int threadCount) {
+    if (threadCount <= 0) {
+        threadCount = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    }
+
+    for (int i = 0; i < threadCount; ++i) {
+        workers.push_back(std::make_unique<Worker>());
+    }
+
+    threadSystem = this;
+    threadWorker = 0;
+
+    for (int i = 1; i < threadCount; ++i) {
+        threads.emplace_back(&JobSystem::workerMain, this, i);
+    }
+}
+
+// Queued jobs are drained before the workers exit
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    sleeping.notify_all();
+
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    if (threadSystem == this) {
+        threadSystem = nullptr;
+        threadWorker = -1;
+    }
+}
+
+int JobSystem::getThreadCount() const {
+    return static_cast<int>(workers.size());
+}
+
+// -1 for threads that do not belong to this system
+int JobSystem::currentWorker() const {
+    return threadSystem == this ? threadWorker : -1;
+}
+
+void JobSystem::workerMain(int workerIndex) {
+    threadSystem = this;
+    threadWorker = workerIndex;
+
+    std::string name = "Worker " + std::to_string(workerIndex);
+    Profiler::setThreadName(name.c_str());
+
+    while (true) {
+        if (runOne(workerIndex)) {
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        sleeping.wait(lock, [this] { return stopping || queuedJobs.load(std::memory_order_acquire) > 0; });
+        if (stopping && queuedJobs.load(std::memory_order_acquire) <= 0) {
+            return;
+        }
+    }
+}
+
+// Queue on the calling worker's deque, or spread jobs coming from outside
+void JobSystem::push(Job job) {
+    int index = currentWorker();
+    if (index < 0) {
+        index = static_cast<int>(nextQueue.fetch_add(1, std::memory_order_relaxed) % workers.size());
+    }
+
+    // Counted first so a thread that sees the job never sees a negative count
+    queuedJobs.fetch_add(1, std::memory_order_release);
+    {
+        std::lock_guard<std::mutex> lock(workers[index]->mutex);
+        workers[index]->jobs.push_back(std::move(job));
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+    }
+    sleeping.notify_one();
+}
+
+// Newest job of the thread's own deque, it is the most likely to be cached
+bool JobSystem::pop(int workerIndex, Job& job) {
+    Worker& worker = *workers[workerIndex];
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    if (worker.jobs.empty()) {
+        return false;
+    }
+
+    job = std::move(worker.jobs.back());
+    worker.jobs.pop_back();
+    return true;
+}
+
+// Oldest job of another deque, starting after the thief's own
+bool JobSystem::steal(int workerIndex, Job& job) {
+    int count = static_cast<int>(workers.size());
+    int start = workerIndex < 0 ? 0 : workerIndex + 1;
+
+    for (int i = 0; i < count; ++i) {
+        Worker& victim = *workers[(start + i) % count];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.jobs.empty()) {
+            job = std::move(victim.jobs.front());
+            victim.jobs.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+bool JobSystem::runOne(int workerIndex) {
+    if (queuedJobs.load(std::memory_order_acquire) <= 0) {
+        return false;
+    }
+
+    Job job;
+    if (!(workerIndex >= 0 && pop(workerIndex, job)) && !steal(workerIndex, job)) {
+        return false;
+    }
+
+    queuedJobs.fetch_sub(1, std::memory_order_acq_rel);
+    execute(workerIndex, job);
+    return true;
+}
+
+void JobSystem::execute(int workerIndex, Job& job) {
+    uint64_t startNs = SDL_GetTicksNS();
+    {
+#if defined(ISOENGINE_PROFILING)
+        ProfileZone zone(job.name);
+#endif
+        job.function();
+    }
+    uint64_t durationNs = SDL_GetTicksNS() - startNs;
+
+    // Threads outside the system book their jobs on the first slot
+    Worker& worker = *workers[std::max(workerIndex, 0)];
+    {
+        std::lock_guard<std::mutex> lock(worker.statsMutex);
+        auto entry = std::find_if(worker.stats.begin(), worker.stats.end(),
+                                  [&](const StatEntry& stat) { return stat.name == job.name; });
+        if (entry == worker.stats.end()) {
+            worker.stats.push_back({ job.name, 1, durationNs, durationNs });
+        } else {
+            entry->count++;
+            entry->totalNs += durationNs;
+            entry->maxNs = std::max(entry->maxNs, durationNs);
+        }
+    }
+
+    finish(job.counter);
+}
+
+// Count a job as done, releasing its dependents and waiters at zero
+void JobSystem::finish(JobCounter* counter) {
+    if (!counter) {
+        return;
+    }
+
+    std::vector<std::unique_ptr<JobCounter::PendingJob>> released;
+    {
+        std::lock_guard<std::mutex> lock(counter->mutex);
+        if (counter->pending.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+            return;
+        }
+        released.swap(counter->dependents);
+    }
+
+    for (auto& pending : released) {
+        pending->system->push({ pending->name, std::move(pending->function), pending->counter });
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+    }
+    sleeping.notify_all();
+}
+
+void JobSystem::run(const char* name, JobFunction function, JobCounter* counter, JobCounter* dependency) {
+    if (counter) {
+        counter->pending.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    if (dependency) {
+        std::lock_guard<std::mutex> lock(dependency->mutex);
+        if (!dependency->isDone()) {
+            dependency->dependents.push_back(std::unique_ptr<JobCounter::PendingJob>(
+                new JobCounter::PendingJob{ this, name, std::move(function), counter }));
+            return;
+        }
+    }
+
+    push({ name, std::move(function), counter });
+}
+
+void JobSystem::wait(JobCounter& counter) {
+    int workerIndex = currentWorker();
+
+    while (!counter.isDone()) {
+        if (runOne(workerIndex)) {
+            continue;
+        }
+
+        // Nothing to help with, sleep until a job is queued or the counter drops
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        sleeping.wait(lock, [&] { return counter.isDone() || queuedJobs.load(std::memory_order_acquire) > 0; });
+    }
+}
+
+void JobSystem::parallelFor(const char* name, int count, int grain, const std::function<void(int begin, int end)>& function) {
+    if (count <= 0) {
+        return;
+    }
+
+    grain = std::max(1, grain);
+    if (count <= grain || workers.size() == 1) {
+        function(0, count);
+        return;
+    }
+
+    JobCounter counter;
+    for (int begin = 0; begin < count; begin += grain) {
+        int end = std::min(count, begin + grain);
+        run(name, [&function, begin, end] { function(begin, end); }, &counter);
+    }
+    wait(counter);
+}
+
+void JobSystem::parallelFor(const char* name, int count, const std::function<void(int index)>& function) {
+    parallelFor(name, count, 1, [&function](int begin, int end) {
+        for (int i = begin; i < end; ++i) {
+            function(i);
+        }
+    });
+}
+
+void JobSystem::collectJobStats(std::vector<JobStats>& stats) {
+    std::map<std::string, JobStats> merged;
+    for (const auto& worker : workers) {
+        std::lock_guard<std::mutex> lock(worker->statsMutex);
+        for (const StatEntry& entry : worker->stats) {
+            JobStats& stat = merged[entry.name];
+            stat.name = entry.name;
+            stat.count += entry.count;
+            stat.totalMs += entry.totalNs / 1.0e6;
+            stat.maxMs = std::max(stat.maxMs, entry.maxNs / 1.0e6);
+        }
+    }
+
+    stats.clear();
+    for (auto& [name, stat] : merged) {
+        stats.push_back(std::move(stat));
+    }
+}
+
+void JobSystem::resetJobStats() {
+    for (const auto& worker : workers) {
+        std::lock_guard<std::mutex> lock(worker->statsMutex);
+        worker->stats.clear();
+    }
+}
@@ -0,0 +1,124 @@
+// JobSystem.hpp
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class JobSystem;
+
+// Counts unfinished jobs. A counter passed to JobSystem::run goes up when
+// the job is queued and down when it finishes; jobs that depend on it are
+// held back until it reaches zero. Must outlive every job it tracks.
+class JobCounter {
+
+private:
+    friend class JobSystem;
+
+    struct PendingJob;
+
+    std::atomic<int> pending{ 0 };
+    std::mutex mutex;
+    std::vector<std::unique_ptr<PendingJob>> dependents;   // Released at zero
+
+public:
+    JobCounter();
+    ~JobCounter();
+
+    JobCounter(const JobCounter&) = delete;
+    JobCounter& operator=(const JobCounter&) = delete;
+
+    bool isDone() const { return pending.load(std::memory_order_acquire) == 0; }
+};
+
+// Run time of every job sharing a name since the last reset
+struct JobStats {
+    std::string name;
+    int count = 0;
+    double totalMs = 0.0;
+    double maxMs = 0.0;
+};
+
+// Work-stealing scheduler. Each thread owns a deque: it pushes and pops
+// its own jobs at the back, idle threads steal the oldest job from the
+// front of another's. The thread that creates the system counts as worker
+// 0 and only runs jobs from inside wait() and parallelFor().
+class JobSystem {
+
+public:
+    using JobFunction = std::function<void()>;
+
+private:
+    struct Job {
+        const char* name;           // String literal, jobs are grouped by its content
+        JobFunction function;
+        JobCounter* counter;
+    };
+
+    struct StatEntry {
+        const char* name;
+        int count;
+        uint64_t totalNs, maxNs;
+    };
+
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Job> jobs;
+
+        std::mutex statsMutex;
+        std::vector<StatEntry> stats;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+
+    std::atomic<int> queuedJobs{ 0 };
+    std::atomic<uint32_t> nextQueue{ 0 };   // Round robin for threads outside the system
+    std::mutex sleepMutex;
+    std::condition_variable sleeping;       // Idle threads and waiters
+    bool stopping = false;
+
+    int currentWorker() const;
+    void push(Job job);
+    bool pop(int workerIndex, Job& job);
+    bool steal(int workerIndex, Job& job);
+    bool runOne(int workerIndex);
+    void execute(int workerIndex, Job& job);
+    void finish(JobCounter* counter);
+    void workerMain(int workerIndex);
+
+public:
+    // threadCount counts the creating thread, 0 picks one per logical core
+    explicit JobSystem(int threadCount = 0);
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    int getThreadCount() const;
+
+    // Queue a job. It is counted by counter, if any, and only starts once
+    // dependency, if any, has reached zero.
+    void run(const char* name, JobFunction function, JobCounter* counter = nullptr,
+             JobCounter* dependency = nullptr);
+
+    // Run queued jobs on the calling thread until the counter reaches zero
+    void wait(JobCounter& counter);
+
+    // Split [0, count) into ranges of at most grain indices, run them as
+    // jobs and wait for all of them
+    void parallelFor(const char* name, int count, int grain, const std::function<void(int begin, int end)>& function);
+    void parallelFor(const char* name, int count, const std::function<void(int index)>& function);
+
+    // Per-name job timings gathered from every thread
+    void collectJobStats(std::vector<JobStats>& stats);
+    void resetJobStats();
+};
@@ -1,44 +1,271 @@
 #include "core/Level.hpp"
+#include "core/EditJournal.hpp"
+#include "core/JobSystem.hpp"
+#include "core/MapIO.hpp"
+#include "utils/Profiler.hpp"
+#include <algorithm>
+
+namespace {
+
+constexpr int EMPTY_MAP_SIZE = 8;
+
+// A mapped map writes its changed pages back to the file it maps
+bool storeMap(Map& map, const std::string& path, JobSystem* jobs) {
+    if (map.getStorageMode() == StorageMode::Mapped) {
+        return map.flush();
+    }
+    return MapIO::saveMap(map, path, jobs);
+}
+
+}
+
+struct Level::PendingLoad {
+    JobCounter done;
+    std::unique_ptr<Map> map;
+};
 
 Level::Level(const std::string& levelName) : name(levelName) {
     currentMapIndex = 0;
 }
 
 Level::~Level() {
-    // Destructor implementation
+    // Prefetch jobs write into their slot
+    for (MapSlot& slot : maps) {
+        if (slot.pending) {
+            jobSystem->wait(slot.pending->done);
+        }
+    }
 }
 
 void Level::addMap(std::unique_ptr<Map> map) {
-    maps.push_back(std::move(map));
+    MapSlot slot;
+    slot.savedRevision = map->getRevision();
+    slot.lastUse = ++useCounter;
+    slot.map = std::move(map);
+    maps.push_back(std::move(slot));
+}
+
+void Level::addMapFile(const std::string& path) {
+    MapSlot slot;
+    slot.path = path;
+    maps.push_back(std::move(slot));
+}
+
+void Level::setJobSystem(JobSystem* jobs) {
+    jobSystem = jobs;
 }
 
-Map* Level::getCurrentMap() const {
-    if (currentMapIndex < maps.size()) {
-        return maps[currentMapIndex].get();
+Map* Level::getCurrentMap() {
+    if (currentMapIndex >= getMapCount()) {
+        return nullptr;
     }
-    return nullptr;
+    Map* map = acquire(currentMapIndex);
+    prefetch((currentMapIndex + 1) % getMapCount());
+    return map;
 }
 
 int Level::getCurrentMapIndex() const {
     return currentMapIndex;
 }
 
-Map* Level::getMap(int index) const {
-    if (index >= 0 && index < maps.size()) {
-        return maps[index].get();
+int Level::getMapCount() const {
+    return static_cast<int>(maps.size());
+}
+
+Map* Level::getMap(int index) {
+    if (index >= 0 && index < getMapCount()) {
+        return acquire(index);
     }
     return nullptr;
 }
 
+bool Level::isMapResident(int index) const {
+    return index >= 0 && index < getMapCount() && maps[index].map;
+}
+
 Map* Level::nextMap() {
-    currentMapIndex = (currentMapIndex + 1) % maps.size();
-    return maps[currentMapIndex].get();
+    if (maps.empty()) {
+        return nullptr;
+    }
+    currentMapIndex = (currentMapIndex + 1) % getMapCount();
+    return getCurrentMap();
 }
 
 std::vector<Map*> Level::getAllMaps() const {
     std::vector<Map*> allMaps;
-    for (const auto& map : maps) {
-        allMaps.push_back(map.get());
+    for (const MapSlot& slot : maps) {
+        if (slot.map) {
+            allMaps.push_back(slot.map.get());
+        }
     }
     return allMaps;
 }
+
+// Applied by the next trimToBudget
+void Level::setMemoryBudget(size_t bytes) {
+    memoryBudget = bytes;
+}
+
+size_t Level::getMemoryBudget() const {
+    return memoryBudget;
+}
+
+LevelStats Level::getStats() const {
+    LevelStats current = stats;
+    current.mapCount = getMapCount();
+    for (const MapSlot& slot : maps) {
+        if (slot.map) {
+            current.residentMaps++;
+            current.residentBytes += getMapBytes(slot);
+        }
+    }
+    return current;
+}
+
+bool Level::saveMaps() {
+    bool saved = true;
+    for (MapSlot& slot : maps) {
+        if (slot.map && !slot.path.empty() && !slot.failed && slot.map->getRevision() != slot.savedRevision) {
+            if (storeMap(*slot.map, slot.path, jobSystem)) {
+                slot.savedRevision = slot.map->getRevision();
+                stats.saves++;
+            } else {
+                saved = false;
+            }
+        }
+    }
+    return saved;
+}
+
+uint64_t Level::computeStateHash() {
+    uint64_t hash = 14695981039346656037ull;
+    for (MapSlot& slot : maps) {
+        if (slot.pending) {
+            finishPending(slot);
+        }
+
+        // Unloaded maps were saved first, their file holds their state
+        uint64_t mapHash = 0;
+        if (slot.map) {
+            mapHash = slot.map->computeStateHash();
+        } else if (std::unique_ptr<Map> map = MapIO::loadMap(slot.path, jobSystem)) {
+            mapHash = map->computeStateHash();
+        }
+        hash = (hash ^ mapHash) * 1099511628211ull;
+    }
+    return hash;
+}
+
+Map* Level::acquire(int index) {
+    // Adopt finished prefetches so they count against the budget
+    for (MapSlot& slot : maps) {
+        if (slot.pending && slot.pending->done.isDone()) {
+            finishPending(slot);
+        }
+    }
+
+    MapSlot& slot = maps[index];
+    if (!slot.map && !slot.failed) {
+        if (slot.pending) {
+            finishPending(slot);
+        } else {
+            PROFILE_ZONE("Level::loadMap");
+            adopt(slot, MapIO::loadMap(slot.path, jobSystem));
+        }
+    }
+
+    slot.lastUse = ++useCounter;
+    return slot.map.get();
+}
+
+void Level::prefetch(int index) {
+    MapSlot& slot = maps[index];
+    if (!jobSystem || slot.map || slot.pending || slot.failed || slot.path.empty()) {
+        return;
+    }
+
+    slot.pending = std::make_unique<PendingLoad>();
+    PendingLoad* pending = slot.pending.get();
+    std::string path = slot.path;
+    JobSystem* jobs = jobSystem;
+    jobSystem->run("Load map", [pending, path, jobs] {
+        pending->map = MapIO::loadMap(path, jobs);
+    }, &pending->done);
+    stats.prefetches++;
+}
+
+void Level::finishPending(MapSlot& slot) {
+    jobSystem->wait(slot.pending->done);
+    std::unique_ptr<Map> map = std::move(slot.pending->map);
+    slot.pending.reset();
+    adopt(slot, std::move(map));
+}
+
+// A file that can't be read is stood in for by an empty map, so the level
+// always has a current map; that one is never saved over the file
+void Level::adopt(MapSlot& slot, std::unique_ptr<Map> map) {
+    if (map) {
+        slot.savedRevision = map->getRevision();
+        stats.loads++;
+    } else {
+        SDL_Log("Couldn't load map %s, using an empty map instead", slot.path.c_str());
+        map = std::make_unique<Map>(EMPTY_MAP_SIZE, EMPTY_MAP_SIZE, 1, SDL_Color{ 0, 0, 0, 255 });
+        slot.failed = true;
+    }
+    slot.map = std::move(map);
+}
+
+size_t Level::getMapBytes(const MapSlot& slot) const {
+    return slot.map->getMemoryUsage() + slot.map->getJournal().getMemoryUsage();
+}
+
+void Level::trimToBudget() {
+    if (maps.empty()) {
+        return;
+    }
+
+    size_t resident = 0;
+    std::vector<int> candidates;
+    const int next = (currentMapIndex + 1) % getMapCount();
+    for (int index = 0; index < getMapCount(); ++index) {
+        const MapSlot& slot = maps[index];
+        if (!slot.map) {
+            continue;
+        }
+        resident += getMapBytes(slot);
+
+        // The map after the current one is kept too, it would only be
+        // prefetched again
+        if (!slot.path.empty() && !slot.failed && index != currentMapIndex && index != next) {
+            candidates.push_back(index);
+        }
+    }
+
+    std::sort(candidates.begin(), candidates.end(), [this](int a, int b) {
+        return maps[a].lastUse < maps[b].lastUse;
+    });
+
+    for (int index : candidates) {
+        if (resident <= memoryBudget) {
+            break;
+        }
+        size_t bytes = getMapBytes(maps[index]);
+        if (unload(maps[index])) {
+            resident -= bytes;
+        }
+    }
+}
+
+// An edited map is saved first and stays resident if that fails
+bool Level::unload(MapSlot& slot) {
+    if (slot.map->getRevision() != slot.savedRevision) {
+        if (!storeMap(*slot.map, slot.path, jobSystem)) {
+            return false;
+        }
+        stats.saves++;
+    }
+
+    slot.map.reset();
+    stats.evictions++;
+    return true;
+}
@@ -6,24 +6,93 @@
 
 #include "core/Map.hpp"
 
+class JobSystem;
+class JobCounter;
+
+// Residency of a level's maps
+struct LevelStats {
+    int mapCount = 0;
+    int residentMaps = 0;
+    size_t residentBytes = 0;   // Tile storage and edit history of the resident maps
+    int loads = 0;              // Maps read from their file, prefetched ones included
+    int prefetches = 0;         // Loads started ahead of use on a worker
+    int evictions = 0;          // Maps unloaded to stay within the budget
+    int saves = 0;              // Edited maps written back to their file
+};
+
+// Ordered maps of a level. Maps added from a file are read on first use
+// and may be unloaded again by trimToBudget, least recently used first,
+// when the resident maps exceed the memory budget; edited ones are saved
+// back before that. The current map and the one after it are never
+// unloaded. Nothing is unloaded outside trimToBudget, so map pointers
+// taken between two calls stay valid.
 class Level {
 private:
+    // A prefetch in flight, the job fills map and drops the counter to zero
+    struct PendingLoad;
+
+    struct MapSlot {
+        std::string path;                       // Empty for maps added in memory, those stay resident
+        std::unique_ptr<Map> map;               // Null while not resident
+        std::unique_ptr<PendingLoad> pending;
+        uint64_t lastUse = 0;
+        uint64_t savedRevision = 0;             // Map revision when it was loaded or last saved
+        bool failed = false;                    // The file could not be read, map is an empty stand-in
+    };
+
     std::string name;
     std::string description;
-    std::vector<std::unique_ptr<Map>> maps;
+    std::vector<MapSlot> maps;
     int currentMapIndex;
-    
+
+    JobSystem* jobSystem = nullptr;
+    size_t memoryBudget = DEFAULT_MEMORY_BUDGET;
+    uint64_t useCounter = 0;
+    LevelStats stats;
+
+    // Make a map resident and mark it used
+    Map* acquire(int index);
+    void prefetch(int index);
+    void finishPending(MapSlot& slot);
+    void adopt(MapSlot& slot, std::unique_ptr<Map> map);
+    size_t getMapBytes(const MapSlot& slot) const;
+
+    bool unload(MapSlot& slot);
 
 public:
+    static constexpr size_t DEFAULT_MEMORY_BUDGET = size_t(256) << 20;
+
     Level(const std::string& levelName);
     ~Level();
 
     void addMap(std::unique_ptr<Map> map);
-    Map* getCurrentMap() const;
+    // Reference a map file, nothing is read until the map is needed
+    void addMapFile(const std::string& path);
+
+    // Maps are loaded on demand, the one after the current map is
+    // prefetched on a worker when a job system is set
+    void setJobSystem(JobSystem* jobs);
+    Map* getCurrentMap();
     int getCurrentMapIndex() const;
-    Map* getMap(int index) const;
+    int getMapCount() const;
+    Map* getMap(int index);
+    bool isMapResident(int index) const;
+    // Resident maps only
     std::vector<Map*> getAllMaps() const;
     Map* nextMap();
 
+    // Unload least recently used maps, other than the pinned ones, until
+    // the resident maps fit the budget. The engine calls it once per frame.
+    void trimToBudget();
+
+    void setMemoryBudget(size_t bytes);
+    size_t getMemoryBudget() const;
+    LevelStats getStats() const;
+
+    // Write every edited resident map back to its file
+    bool saveMaps();
 
-};
\ No newline at end of file
+    // FNV-1a over the state hashes of all maps in order. Maps that aren't
+    // resident are read from their file for it and not kept.
+    uint64_t computeStateHash();
+};
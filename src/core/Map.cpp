@@ -1,26 +1,97 @@
 // Map.cpp
 #include "Map.hpp"
+#include "EditJournal.hpp"
+#include "JobSystem.hpp"
 #include "utils/Math.hpp"
+#include "utils/Profiler.hpp"
 #include <iostream>
 #include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+
+namespace {
+
+// Narrow [minX, maxX] to the columns whose coordinate origin + x * step lies in [lo, hi]
+void clipSpan(float origin, float step, float lo, float hi, int& minX, int& maxX) {
+    if (step == 0.0f) {
+        if (origin < lo || origin > hi) {
+            maxX = minX - 1;
+        }
+        return;
+    }
+
+    float a = (lo - origin) / step;
+    float b = (hi - origin) / step;
+    if (a > b) {
+        std::swap(a, b);
+    }
+
+    // Clamp in float space before converting so huge spans cannot overflow
+    a = std::max(a, static_cast<float>(minX) - 1.0f);
+    b = std::min(b, static_cast<float>(maxX) + 1.0f);
+
+    minX = std::max(minX, static_cast<int>(std::floor(a)) - 1);
+    maxX = std::min(maxX, static_cast<int>(std::ceil(b)) + 1);
+}
+
+// Queue one textured quad
+void appendQuad(std::vector<SDL_Vertex>& vertices, const SDL_FRect& destRect, const SDL_FRect& uvRect) {
+    const SDL_FColor white = { 1.0f, 1.0f, 1.0f, 1.0f };
+    float x0 = destRect.x, x1 = destRect.x + destRect.w;
+    float y0 = destRect.y, y1 = destRect.y + destRect.h;
+    float u0 = uvRect.x, u1 = uvRect.x + uvRect.w;
+    float v0 = uvRect.y, v1 = uvRect.y + uvRect.h;
+
+    vertices.push_back({ { x0, y0 }, white, { u0, v0 } });
+    vertices.push_back({ { x1, y0 }, white, { u1, v0 } });
+    vertices.push_back({ { x0, y1 }, white, { u0, v1 } });
+    vertices.push_back({ { x1, y1 }, white, { u1, v1 } });
+}
+
+// FNV-1a, folded in one value at a time
+void hashValue(uint64_t& hash, uint64_t value) {
+    for (int i = 0; i < 8; ++i) {
+        hash ^= (value >> (i * 8)) & 0xFF;
+        hash *= 1099511628211ull;
+    }
+}
+
+}
 
 // Constructor - creates empty map
-Map::Map(int width, int height, int numLayers, SDL_Color bgColor)
-    : mapWidth(width), mapHeight(height), numLayers(numLayers), cameraX(0.0f), cameraY(0.0f), backgroundColor(bgColor) {
+Map::Map(int width, int height, int numLayers, SDL_Color bgColor, StorageMode mode)
+    : mapWidth(width), mapHeight(height), numLayers(numLayers), storageMode(mode), backgroundColor(bgColor), cameraX(0.0f), cameraY(0.0f) {
 
     // Set default tile size
     tileWidth = 64;
     tileHeight = 64;
+    projection = Math::Projection(tileWidth, tileHeight);
 
-    // Initialize 3D vector with empty tiles
-    tiles.resize(numLayers);
-    for (int z = 0; z < numLayers; ++z) {
-        tiles[z].resize(mapHeight);
-        for (int y = 0; y < mapHeight; ++y) {
-            tiles[z][y].resize(mapWidth);
-            // unique_ptr automatically initializes to nullptr
+    if (storageMode == StorageMode::Chunked) {
+        if (mapWidth <= 0 || mapHeight <= 0) {
+            mapWidth = 0;
+            mapHeight = 0;
         }
+        storage = std::make_unique<ChunkedTileStorage>();
+    } else {
+        // Mapped storage needs a file, see the other constructor
+        storageMode = StorageMode::Dense;
+        storage = std::make_unique<DenseTileStorage>(mapWidth, mapHeight, numLayers);
     }
+
+    journal = std::make_unique<EditJournal>(*this);
+}
+
+Map::Map(std::unique_ptr<TileStorage> tileStorage, int width, int height, int numLayers, SDL_Color bgColor, StorageMode mode)
+    : mapWidth(width), mapHeight(height), numLayers(numLayers), storageMode(mode), storage(std::move(tileStorage)),
+      backgroundColor(bgColor), cameraX(0.0f), cameraY(0.0f) {
+
+    tileWidth = 64;
+    tileHeight = 64;
+    projection = Math::Projection(tileWidth, tileHeight);
+    journal = std::make_unique<EditJournal>(*this);
 }
 
 // Destructor
@@ -30,118 +101,535 @@ Map::~Map() {
 
 // Helper method to check if coordinates are valid
 bool Map::isValidPosition(int x, int y) const {
+    if (!isBounded()) {
+        return true;
+    }
     return (x >= 0 && x < mapWidth && y >= 0 && y < mapHeight);
 }
 
-// Tile management - set tile with existing unique_ptr
-void Map::setTile(int x, int y, int layer, std::unique_ptr<Tile> tile) {
-    if (!isValidPosition(x, y)) {
-        std::cerr << "Invalid tile position: (" << x << ", " << y << ")" << std::endl;
-        return;
-    }
-    
-    // Move the unique_ptr
-    tiles[layer][y][x] = std::move(tile);
+bool Map::isValidLayer(int layer) const {
+    return (layer >= 0 && layer < numLayers);
 }
 
-// Tile management - create new tile from image
+// Tile management - copy the ID of an existing tile view
+void Map::setTile(int x, int y, int layer, const Tile& tile) {
+    setTile(x, y, layer, tile.getID());
+}
+
+// Tile management - store tile ID at position
 void Map::setTile(int x, int y, int layer, int tileID) {
-    if (!isValidPosition(x, y)) {
-        std::cerr << "Invalid tile position: (" << x << ", " << y << ")" << std::endl;
+    if (!isValidPosition(x, y) || !isValidLayer(layer)) {
+        std::cerr << "Invalid tile position: (" << x << ", " << y << ", layer " << layer << ")" << std::endl;
         return;
     }
-    
-    // Create new tile and move it into position
-    auto tile = std::make_unique<Tile>(tileID, x, y, tileWidth, tileHeight);
-    tiles[layer][y][x] = std::move(tile);
+    if (tileID < 0 || tileID >= EMPTY_TILE) {
+        std::cerr << "Invalid tile ID: " << tileID << std::endl;
+        return;
+    }
+
+    storage->set(x, y, layer, static_cast<TileID>(tileID));
+    chunkCache.markDirty(x, y, layer);
+    revision++;
 }
 
 // Remove tile at position
 void Map::removeTile(int x, int y, int layer) {
-    if (!isValidPosition(x, y)) {
+    if (!isValidPosition(x, y) || !isValidLayer(layer)) {
         return;
     }
     
-    // Reset unique_ptr (automatically destroys the tile)
-    tiles[layer][y][x].reset();
+    storage->set(x, y, layer, EMPTY_TILE);
+    chunkCache.markDirty(x, y, layer);
+    revision++;
+}
+
+// Get a view of the tile at position
+std::optional<Tile> Map::getTile(int x, int y, int layer) const {
+    int id = getTileID(x, y, layer);
+    if (id < 0) {
+        return std::nullopt;
+    }
+
+    return Tile(id, x, y, tileWidth, tileHeight);
 }
 
-// Get tile at position
-Tile* Map::getTile(int x, int y, int layer) const {
-    if (!isValidPosition(x, y)) {
-        return nullptr;
+// Get the raw tile ID at position, -1 if empty or out of bounds
+int Map::getTileID(int x, int y, int layer) const {
+    if (!isValidPosition(x, y) || !isValidLayer(layer)) {
+        return -1;
     }
 
-    return tiles[layer][y][x].get(); // get() returns raw pointer from unique_ptr
+    TileID id = storage->get(x, y, layer);
+    return (id == EMPTY_TILE) ? -1 : id;
 }
 
 // Check if tile exists at position
 bool Map::hasTile(int x, int y, int layer) const {
-    if (!isValidPosition(x, y)) {
-        return false;
+    return getTileID(x, y, layer) >= 0;
+}
+
+// Collect the rows of a layer whose tiles can intersect the view
+void Map::computeVisibleRows(int layer, int viewWidth, int viewHeight, std::vector<RowSpan>& rows) const {
+    rows.clear();
+
+    float layerOffset = layer * tileHeight * cameraZoom * 0.5f;
+
+    // Unzoomed range of tile anchors (top-center of the sprite) for which
+    // some part of the sprite still lands inside the view
+    float left = cameraX / cameraZoom - tileWidth * 0.5f;
+    float right = (viewWidth + cameraX) / cameraZoom + tileWidth * 0.5f;
+    float top = (cameraY + layerOffset) / cameraZoom - tileHeight;
+    float bottom = (viewHeight + cameraY + layerOffset) / cameraZoom;
+
+    // Invert the corners of that rectangle to bound the grid region
+    const float cornersX[4] = { left, right, left, right };
+    const float cornersY[4] = { top, top, bottom, bottom };
+
+    int minX = INT_MAX, maxX = INT_MIN;
+    int minY = INT_MAX, maxY = INT_MIN;
+    for (int i = 0; i < 4; ++i) {
+        int gridX, gridY;
+        screenToGrid(static_cast<int>(std::floor(cornersX[i])), static_cast<int>(std::floor(cornersY[i])), gridX, gridY);
+        minX = std::min(minX, gridX);
+        maxX = std::max(maxX, gridX);
+        minY = std::min(minY, gridY);
+        maxY = std::max(maxY, gridY);
     }
 
-    return tiles[layer][y][x] != nullptr;
+    // One cell of slack absorbs the rounding of the inverse projection
+    minX -= 1;
+    maxX += 1;
+    minY -= 1;
+    maxY += 1;
+
+    // Unbounded maps are only limited by the view
+    if (isBounded()) {
+        minX = std::max(minX, 0);
+        maxX = std::min(maxX, mapWidth - 1);
+        minY = std::max(minY, 0);
+        maxY = std::min(maxY, mapHeight - 1);
+    }
+
+    // Within a row the anchor moves linearly with x, so the visible
+    // diamond slice is the intersection of two intervals
+    for (int y = minY; y <= maxY; ++y) {
+        float originX, stepX, originY, stepY;
+        projection.getRowLine(y, originX, stepX, originY, stepY);
+
+        int spanMin = minX;
+        int spanMax = maxX;
+        clipSpan(originX, stepX, left, right, spanMin, spanMax);
+        clipSpan(originY, stepY, top, bottom, spanMin, spanMax);
+
+        if (spanMin <= spanMax) {
+            rows.push_back({ y, spanMin, spanMax });
+        }
+    }
+}
+
+// Split the rows into bands holding about the same number of cells
+void Map::splitBands(const std::vector<RowSpan>& rows, int bandCount) {
+    size_t totalCells = 0;
+    for (const RowSpan& row : rows) {
+        totalCells += row.maxX - row.minX + 1;
+    }
+
+    bandCount = std::max(1, std::min(bandCount, static_cast<int>(rows.size())));
+    if (renderBands.size() < static_cast<size_t>(bandCount)) {
+        renderBands.resize(bandCount);
+    }
+
+    size_t row = 0;
+    size_t cells = 0;
+    for (int band = 0; band < bandCount; ++band) {
+        size_t target = totalCells * (band + 1) / bandCount;
+        renderBands[band].firstRow = row;
+        while (row < rows.size() && (cells < target || band == bandCount - 1)) {
+            cells += rows[row].maxX - rows[row].minX + 1;
+            row++;
+        }
+        renderBands[band].endRow = row;
+    }
+    renderBands.resize(bandCount);
+}
+
+// Build the render list of a band's rows. Unzoomed map positions are
+// scaled, then offset into the current render target.
+void Map::buildBand(RenderBand& band, int layer, const std::vector<RowSpan>& rows,
+                    float scale, float offsetX, float offsetY, RenderMode mode) const {
+    band.vertices.clear();
+    band.runs.clear();
+    band.tileDraws.clear();
+    band.typeIDs.clear();
+    band.tilesVisited = 0;
+    band.tilesDrawn = 0;
+
+    // Calculate scaled tile dimensions for rendering only
+    float scaledTileWidth = tileWidth * scale;
+    float scaledTileHeight = tileHeight * scale;
+
+    // Neighbouring cells usually repeat an ID, remember the last lookup
+    TileID lastID = EMPTY_TILE;
+    const TileType* type = nullptr;
+
+    for (size_t rowIndex = band.firstRow; rowIndex < band.endRow; ++rowIndex) {
+        const RowSpan& row = rows[rowIndex];
+        for (int runX = row.minX; runX <= row.maxX;) {
+            // Walk the row in runs that are contiguous in storage,
+            // unallocated runs are empty and skipped outright
+            int runLength = 0;
+            const TileID* cells = storage->readRow(runX, row.y, layer, row.maxX - runX + 1, runLength);
+            if (!cells) {
+                runX += runLength;
+                continue;
+            }
+            band.tilesVisited += runLength;
+
+            // Derive the run's base screen positions from its grid positions
+            band.gridX.resize(runLength);
+            std::iota(band.gridX.begin(), band.gridX.end(), runX);
+            band.gridY.assign(runLength, row.y);
+            band.screenX.resize(runLength);
+            band.screenY.resize(runLength);
+            Math::toScreenCoordinates(static_cast<int>(tileWidth), static_cast<int>(tileHeight),
+                                      band.gridX.data(), band.gridY.data(), band.screenX.data(), band.screenY.data(), runLength);
+
+            for (int i = 0; i < runLength; ++i, ++cells) {
+                if (*cells == EMPTY_TILE) {
+                    continue;
+                }
+
+                if (*cells != lastID) {
+                    lastID = *cells;
+                    type = TileRegistry::getType(lastID);
+                    TileRegistry::markUsed(lastID);
+                    band.typeIDs.push_back(lastID);
+                }
+                if (!type) {
+                    continue;
+                }
+
+                SDL_FRect destRect = {
+                    band.screenX[i] * scale - scaledTileWidth * 0.5f + offsetX,
+                    band.screenY[i] * scale + offsetY,
+                    scaledTileWidth,
+                    scaledTileHeight
+                };
+
+                SDL_Texture* texture = type->getTexture();
+                if (!texture) {
+                    continue;
+                }
+
+                if (mode == RenderMode::PerTile) {
+                    band.tileDraws.push_back({ texture, type->getSourceRect(), destRect });
+                } else {
+                    // Sprites overlap their neighbours, so a batch only spans
+                    // consecutive tiles on the same atlas page to keep
+                    // back-to-front order intact
+                    if (band.runs.empty() || band.runs.back().texture != texture) {
+                        band.runs.push_back({ texture, static_cast<int>(band.vertices.size()), 0 });
+                    }
+                    appendQuad(band.vertices, destRect, type->getUVRect());
+                    band.runs.back().vertexCount += 4;
+                }
+                band.tilesDrawn++;
+            }
+            runX += runLength;
+        }
+    }
+}
+
+// Issue the SDL calls of a built band
+void Map::submitBand(SDL_Renderer* renderer, const RenderBand& band, RenderMode mode) {
+    renderStats.tilesVisited += band.tilesVisited;
+    renderStats.tilesDrawn += band.tilesDrawn;
+
+    if (mode == RenderMode::PerTile) {
+        for (const TileDraw& draw : band.tileDraws) {
+            // Render tile's atlas region at offset position
+            SDL_RenderTexture(renderer, draw.texture, &draw.srcRect, &draw.destRect);
+            renderStats.drawCalls++;
+        }
+        return;
+    }
+
+    for (const BatchRun& run : band.runs) {
+        // The index pattern is identical for every batch, so it only grows
+        int quadCount = run.vertexCount / 4;
+        int builtQuads = static_cast<int>(batchIndices.size() / 6);
+        for (int quad = builtQuads; quad < quadCount; ++quad) {
+            int base = quad * 4;
+            batchIndices.insert(batchIndices.end(), { base, base + 1, base + 2, base + 2, base + 1, base + 3 });
+        }
+
+        SDL_RenderGeometry(renderer, run.texture, band.vertices.data() + run.firstVertex, run.vertexCount,
+                           batchIndices.data(), quadCount * 6);
+        renderStats.drawCalls++;
+    }
+}
+
+// Draw the tiles of the given rows of a layer. Large views are split into
+// bands built as jobs; a batch never spans two bands, which
+// costs at most one extra draw call per band.
+void Map::drawRows(SDL_Renderer* renderer, int layer, const std::vector<RowSpan>& rows,
+                   float scale, float offsetX, float offsetY, RenderMode mode, JobSystem* jobs) {
+    size_t cells = 0;
+    for (const RowSpan& row : rows) {
+        cells += row.maxX - row.minX + 1;
+    }
+
+    // Two bands per thread evens out rows of uneven cost
+    int bandCount = 1;
+    if (jobs && jobs->getThreadCount() > 1 && cells >= PARALLEL_MIN_CELLS) {
+        bandCount = jobs->getThreadCount() * 2;
+    }
+    splitBands(rows, bandCount);
+
+    if (renderBands.size() == 1) {
+        buildBand(renderBands[0], layer, rows, scale, offsetX, offsetY, mode);
+    } else {
+        PROFILE_ZONE("Map::buildBands");
+        jobs->parallelFor("Map::buildBand", static_cast<int>(renderBands.size()), [&](int band) {
+            buildBand(renderBands[band], layer, rows, scale, offsetX, offsetY, mode);
+        });
+    }
+
+    // Bands are submitted in row order, so layers and rows keep their
+    // back-to-front order whatever thread built them
+    for (const RenderBand& band : renderBands) {
+        submitBand(renderer, band, mode);
+    }
+}
+
+// Unzoomed bounding box of every sprite a cache chunk can hold
+SDL_FRect Map::getChunkBounds(int chunkX, int chunkY) const {
+    int x0 = chunkX << ChunkCache::CHUNK_SHIFT;
+    int y0 = chunkY << ChunkCache::CHUNK_SHIFT;
+    int last = ChunkCache::CHUNK_SIZE - 1;
+
+    const int cornersX[4] = { x0, x0 + last, x0, x0 + last };
+    const int cornersY[4] = { y0, y0, y0 + last, y0 + last };
+
+    int minX = INT_MAX, maxX = INT_MIN;
+    int minY = INT_MAX, maxY = INT_MIN;
+    for (int i = 0; i < 4; ++i) {
+        int screenX, screenY;
+        gridToScreen(cornersX[i], cornersY[i], screenX, screenY);
+        minX = std::min(minX, screenX);
+        maxX = std::max(maxX, screenX);
+        minY = std::min(minY, screenY);
+        maxY = std::max(maxY, screenY);
+    }
+
+    return {
+        minX - tileWidth * 0.5f,
+        static_cast<float>(minY),
+        maxX - minX + tileWidth,
+        maxY - minY + tileHeight
+    };
+}
+
+// Rows of a cache chunk that lie inside the map
+void Map::getChunkRows(int chunkX, int chunkY, std::vector<RowSpan>& rows) const {
+    rows.clear();
+
+    int x0 = chunkX << ChunkCache::CHUNK_SHIFT;
+    int y0 = chunkY << ChunkCache::CHUNK_SHIFT;
+    int x1 = x0 + ChunkCache::CHUNK_SIZE - 1;
+    int y1 = y0 + ChunkCache::CHUNK_SIZE - 1;
+
+    if (isBounded()) {
+        x0 = std::max(x0, 0);
+        y0 = std::max(y0, 0);
+        x1 = std::min(x1, mapWidth - 1);
+        y1 = std::min(y1, mapHeight - 1);
+    }
+
+    for (int y = y0; y <= y1 && x0 <= x1; ++y) {
+        rows.push_back({ y, x0, x1 });
+    }
+}
+
+// True if any cell of the rows holds a tile
+bool Map::hasTilesInRows(int layer, const std::vector<RowSpan>& rows) const {
+    for (const RowSpan& row : rows) {
+        for (int runX = row.minX; runX <= row.maxX;) {
+            int runLength = 0;
+            const TileID* cells = storage->readRow(runX, row.y, layer, row.maxX - runX + 1, runLength);
+            if (cells && std::any_of(cells, cells + runLength, [](TileID id) { return id != EMPTY_TILE; })) {
+                return true;
+            }
+            runX += runLength;
+        }
+    }
+    return false;
+}
+
+// Redraw a chunk of a layer into its cache texture
+void Map::bakeChunk(SDL_Renderer* renderer, ChunkCache::Entry& entry, int layer, const SDL_FRect& bounds) {
+    SDL_Texture* previousTarget = SDL_GetRenderTarget(renderer);
+    SDL_SetRenderTarget(renderer, entry.texture);
+
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
+    SDL_RenderClear(renderer);
+    drawRows(renderer, layer, chunkRows, 1.0f, -bounds.x, -bounds.y, RenderMode::Batched);
+
+    SDL_SetRenderTarget(renderer, previousTarget);
+    entry.dirty = false;
+
+    entry.typeIDs.clear();
+    for (const RenderBand& band : renderBands) {
+        entry.typeIDs.insert(entry.typeIDs.end(), band.typeIDs.begin(), band.typeIDs.end());
+    }
+    std::sort(entry.typeIDs.begin(), entry.typeIDs.end());
+    entry.typeIDs.erase(std::unique(entry.typeIDs.begin(), entry.typeIDs.end()), entry.typeIDs.end());
+}
+
+// Draw one cached texture per visible chunk, baking the ones that are new
+// or were edited since their last bake
+void Map::drawCachedChunks(SDL_Renderer* renderer, int layer) {
+    // Chunk rows touched by the visible tile rows, with the union of their
+    // chunk columns
+    visibleChunks.clear();
+    for (const RowSpan& row : visibleRows) {
+        int chunkY = row.y >> ChunkCache::CHUNK_SHIFT;
+        int minChunkX = row.minX >> ChunkCache::CHUNK_SHIFT;
+        int maxChunkX = row.maxX >> ChunkCache::CHUNK_SHIFT;
+
+        if (!visibleChunks.empty() && visibleChunks.back().y == chunkY) {
+            visibleChunks.back().minX = std::min(visibleChunks.back().minX, minChunkX);
+            visibleChunks.back().maxX = std::max(visibleChunks.back().maxX, maxChunkX);
+        } else {
+            visibleChunks.push_back({ chunkY, minChunkX, maxChunkX });
+        }
+    }
+
+    ChunkCacheStats& cacheStats = chunkCache.getStats();
+    float layerOffset = layer * tileHeight * cameraZoom * 0.5f;
+
+    // Row-major chunk order matches the tile order, so overlapping sprites
+    // of neighbouring chunks still stack back to front
+    for (const RowSpan& chunkRow : visibleChunks) {
+        for (int chunkX = chunkRow.minX; chunkX <= chunkRow.maxX; ++chunkX) {
+            SDL_FRect bounds = getChunkBounds(chunkX, chunkRow.y);
+            ChunkCache::Entry& entry = chunkCache.use(chunkX, chunkRow.y, layer);
+
+            if (!entry.texture || entry.dirty) {
+                getChunkRows(chunkX, chunkRow.y, chunkRows);
+                if (!hasTilesInRows(layer, chunkRows)) {
+                    chunkCache.remove(chunkX, chunkRow.y, layer);
+                    continue;
+                }
+
+                bool isNew = (entry.texture == nullptr);
+                int textureWidth = static_cast<int>(std::ceil(bounds.w));
+                int textureHeight = static_cast<int>(std::ceil(bounds.h));
+                if (!chunkCache.ensureTexture(renderer, entry, textureWidth, textureHeight)) {
+                    continue;
+                }
+
+                bakeChunk(renderer, entry, layer, bounds);
+                if (isNew) {
+                    cacheStats.misses++;
+                } else {
+                    cacheStats.rebakes++;
+                }
+            } else {
+                // The texture shows these types, the registry must keep them
+                for (TileID id : entry.typeIDs) {
+                    TileRegistry::markUsed(id);
+                }
+                cacheStats.hits++;
+            }
+
+            SDL_FRect destRect = {
+                bounds.x * cameraZoom - cameraX,
+                bounds.y * cameraZoom - cameraY - layerOffset,
+                bounds.w * cameraZoom,
+                bounds.h * cameraZoom
+            };
+            SDL_RenderTexture(renderer, entry.texture, nullptr, &destRect);
+            renderStats.drawCalls++;
+        }
+    }
 }
 
 // Render with camera offset
-void Map::renderWithCamera(SDL_Renderer* renderer, float camX, float camY) {
-    // Store current camera position
-    float oldCamX = cameraX;
-    float oldCamY = cameraY;
-    
+void Map::renderWithCamera(SDL_Renderer* renderer, float camX, float camY, JobSystem* jobs) {
+    PROFILE_ZONE("Map::renderWithCamera");
+
     // Set new camera position
     cameraX = camX;
     cameraY = camY;
-    
-    // Calculate zoomed tile dimensions for rendering only
-    float zoomedTileWidth = tileWidth * cameraZoom;
-    float zoomedTileHeight = tileHeight * cameraZoom;
+
+    renderStats = RenderStats();
+    chunkCache.beginFrame();
+
+    // Types replaced since, e.g. placeholders by their images, are stale
+    // in every baked chunk
+    if (bakedRegistryRevision != TileRegistry::getRevision()) {
+        bakedRegistryRevision = TileRegistry::getRevision();
+        chunkCache.markAllDirty();
+    }
+
+    int viewWidth = 0, viewHeight = 0;
+    SDL_GetCurrentRenderOutputSize(renderer, &viewWidth, &viewHeight);
     
     // Render tiles with layer as outermost loop for proper layering
     for (int layer = 0; layer < numLayers; ++layer) {
-        for (int y = 0; y < mapHeight; ++y) {
-            for (int x = 0; x < mapWidth; ++x) {
-                if (tiles[layer][y][x]) {
-                    // Get tile's base screen position
-                    int tileScreenX = tiles[layer][y][x]->getScreenX();
-                    int tileScreenY = tiles[layer][y][x]->getScreenY();
-                    
-                    // Apply zoom to the position
-                    float zoomedX = tileScreenX * cameraZoom;
-                    float zoomedY = tileScreenY * cameraZoom;
-
-                    // Apply camera offset
-                    SDL_FRect destRect = {
-                        zoomedX - zoomedTileWidth * 0.5f - cameraX,
-                        zoomedY - cameraY - layer * zoomedTileHeight * 0.5f,
-                        zoomedTileWidth,
-                        zoomedTileHeight
-                    };
-                    
-                    // Render tile at offset position
-                    SDL_RenderTexture(renderer, tiles[layer][y][x]->getTexture(), nullptr, &destRect);
-                }
-            }
+        computeVisibleRows(layer, viewWidth, viewHeight, visibleRows);
+
+        if (renderMode == RenderMode::ChunkCached) {
+            drawCachedChunks(renderer, layer);
+        } else {
+            // Apply zoom, camera offset and the layer's vertical offset
+            float layerOffset = layer * tileHeight * cameraZoom * 0.5f;
+            drawRows(renderer, layer, visibleRows, cameraZoom, -cameraX, -cameraY - layerOffset, renderMode, jobs);
         }
     }
+
+    if (renderMode == RenderMode::ChunkCached) {
+        chunkCache.evictToBudget();
+    }
+}
+
+const RenderStats& Map::getRenderStats() const {
+    return renderStats;
+}
+
+void Map::setRenderMode(RenderMode mode) {
+    renderMode = mode;
+    revision++;
+
+    // Cached textures are useless to the other paths, give the memory back
+    if (renderMode != RenderMode::ChunkCached) {
+        chunkCache.clear();
+    }
+}
+
+RenderMode Map::getRenderMode() const {
+    return renderMode;
 }
 
 // Camera control
 void Map::setCamera(float x, float y) {
     cameraX = x;
     cameraY = y;
+    revision++;
 }
 
 void Map::moveCamera(float deltaX, float deltaY) {
     cameraX += deltaX;
     cameraY += deltaY;
+    revision++;
 }
 
 void Map::zoomCamera(float zoomFactor) {
     cameraZoom *= zoomFactor;
     // Ensure zoom factor is within reasonable limits
     cameraZoom = std::clamp(cameraZoom, 0.5f, 4.0f);
+    revision++;
 }
 
 float Map::getCameraZoom() const {
@@ -169,47 +657,389 @@ int Map::getLayerCount() const {
     return numLayers;
 }
 
+bool Map::isBounded() const {
+    return mapWidth > 0 && mapHeight > 0;
+}
+
+StorageMode Map::getStorageMode() const {
+    return storageMode;
+}
+
 // Clear all tiles
 void Map::clearMap() {
-    for (int y = 0; y < mapHeight; ++y) {
-        for (int x = 0; x < mapWidth; ++x) {
-            tiles[numLayers - 1][y][x].reset(); // Destroy tile and set to nullptr
-        }
-    }
+    clearLayers(0, numLayers - 1);
 }
 
 // Fill entire map with same tile type
 void Map::fillWithTile(int tileID, int layer) {
-    for (int y = 0; y < mapHeight; ++y) {
-        for (int x = 0; x < mapWidth; ++x) {
-            setTile(x, y, layer, tileID);
+    if (!isValidLayer(layer) || tileID < 0 || tileID >= EMPTY_TILE) {
+        return;
+    }
+    if (!isBounded()) {
+        std::cerr << "Cannot fill an unbounded map" << std::endl;
+        return;
+    }
+
+    fillRect(0, 0, mapWidth, mapHeight, layer, tileID);
+}
+
+bool Map::clipRect(int& x, int& y, int& width, int& height) const {
+    if (width <= 0 || height <= 0) {
+        return false;
+    }
+    if (!isBounded()) {
+        return true;
+    }
+
+    // 64-bit ends so rectangles reaching past INT_MAX cannot wrap
+    int64_t x0 = std::max<int64_t>(x, 0);
+    int64_t y0 = std::max<int64_t>(y, 0);
+    int64_t x1 = std::min<int64_t>(static_cast<int64_t>(x) + width, mapWidth);
+    int64_t y1 = std::min<int64_t>(static_cast<int64_t>(y) + height, mapHeight);
+    if (x0 >= x1 || y0 >= y1) {
+        return false;
+    }
+
+    x = static_cast<int>(x0);
+    y = static_cast<int>(y0);
+    width = static_cast<int>(x1 - x0);
+    height = static_cast<int>(y1 - y0);
+    return true;
+}
+
+void Map::fillRect(int x, int y, int width, int height, int layer, int tileID) {
+    if (!isValidLayer(layer)) {
+        return;
+    }
+    if (tileID < -1 || tileID >= EMPTY_TILE) {
+        std::cerr << "Invalid tile ID: " << tileID << std::endl;
+        return;
+    }
+    if (!clipRect(x, y, width, height)) {
+        return;
+    }
+
+    TileID id = (tileID < 0) ? EMPTY_TILE : static_cast<TileID>(tileID);
+    for (int row = y; row < y + height; ++row) {
+        storage->fillRow(x, row, layer, width, id);
+    }
+
+    chunkCache.markDirtyRect(x, y, x + width - 1, y + height - 1, layer, layer);
+    revision++;
+}
+
+void Map::clearLayers(int firstLayer, int lastLayer) {
+    firstLayer = std::max(firstLayer, 0);
+    lastLayer = std::min(lastLayer, numLayers - 1);
+    if (firstLayer > lastLayer) {
+        return;
+    }
+
+    for (int layer = firstLayer; layer <= lastLayer; ++layer) {
+        storage->clearLayer(layer);
+    }
+
+    chunkCache.markDirtyRect(INT_MIN, INT_MIN, INT_MAX, INT_MAX, firstLayer, lastLayer);
+    revision++;
+}
+
+TileStamp Map::copyRect(int x, int y, int width, int height) const {
+    TileStamp stamp(width, height, numLayers);
+
+    int clippedX = x, clippedY = y, clippedWidth = width, clippedHeight = height;
+    if (!clipRect(clippedX, clippedY, clippedWidth, clippedHeight)) {
+        return stamp;
+    }
+
+    for (int layer = 0; layer < numLayers; ++layer) {
+        for (int row = clippedY; row < clippedY + clippedHeight; ++row) {
+            TileID* target = stamp.getRow(row - y, layer) + (clippedX - x);
+
+            // Unallocated runs are empty, and so is the fresh stamp
+            for (int runX = clippedX; runX < clippedX + clippedWidth;) {
+                int runLength = 0;
+                const TileID* cells = storage->readRow(runX, row, layer, clippedX + clippedWidth - runX, runLength);
+                if (cells) {
+                    std::copy(cells, cells + runLength, target + (runX - clippedX));
+                }
+                runX += runLength;
+            }
         }
     }
+    return stamp;
+}
+
+void Map::pasteStamp(const TileStamp& stamp, int x, int y, bool masked) {
+    int clippedX = x, clippedY = y, clippedWidth = stamp.getWidth(), clippedHeight = stamp.getHeight();
+    int layerCount = std::min(stamp.getLayerCount(), numLayers);
+    if (layerCount == 0 || !clipRect(clippedX, clippedY, clippedWidth, clippedHeight)) {
+        return;
+    }
+
+    for (int layer = 0; layer < layerCount; ++layer) {
+        for (int row = clippedY; row < clippedY + clippedHeight; ++row) {
+            const TileID* source = stamp.getRow(row - y, layer) + (clippedX - x);
+
+            if (!masked) {
+                storage->writeRow(clippedX, row, layer, clippedWidth, source);
+                continue;
+            }
+
+            // Write only the runs of non-empty cells
+            for (int i = 0; i < clippedWidth;) {
+                if (source[i] == EMPTY_TILE) {
+                    ++i;
+                    continue;
+                }
+                int end = i + 1;
+                while (end < clippedWidth && source[end] != EMPTY_TILE) {
+                    ++end;
+                }
+                storage->writeRow(clippedX + i, row, layer, end - i, source + i);
+                i = end;
+            }
+        }
+    }
+
+    chunkCache.markDirtyRect(clippedX, clippedY, clippedX + clippedWidth - 1, clippedY + clippedHeight - 1, 0, layerCount - 1);
+    revision++;
+}
+
+// Goes through a stamp, so overlapping copies within one map are safe
+void Map::copyRectFrom(const Map& source, int sourceX, int sourceY, int width, int height,
+                       int x, int y, bool masked) {
+    pasteStamp(source.copyRect(sourceX, sourceY, width, height), x, y, masked);
+}
+
+TileRuns Map::encodeRect(int x, int y, int width, int height, int firstLayer, int lastLayer) const {
+    firstLayer = std::max(firstLayer, 0);
+    lastLayer = std::min(lastLayer, numLayers - 1);
+    if (firstLayer > lastLayer || !clipRect(x, y, width, height)) {
+        return TileRuns();
+    }
+
+    TileRuns runs(x, y, width, height, firstLayer, lastLayer);
+    for (int layer = firstLayer; layer <= lastLayer; ++layer) {
+        for (int row = y; row < y + height; ++row) {
+            for (int runX = x; runX < x + width;) {
+                int runLength = 0;
+                const TileID* cells = storage->readRow(runX, row, layer, x + width - runX, runLength);
+                if (cells) {
+                    runs.appendCells(cells, runLength);
+                } else {
+                    runs.appendRun(EMPTY_TILE, runLength);
+                }
+                runX += runLength;
+            }
+        }
+    }
+    runs.finish();
+    return runs;
+}
+
+void Map::decodeRect(const TileRuns& runs) {
+    if (runs.isEmpty()) {
+        return;
+    }
+
+    const int x = runs.getX(), y = runs.getY(), width = runs.getWidth(), height = runs.getHeight();
+    int layer = runs.getFirstLayer(), row = 0, column = 0;
+    std::vector<TileID> literals;
+
+    size_t offset = 0;
+    TileRuns::Packet packet;
+    while (layer <= runs.getLastLayer() && runs.readPacket(offset, packet)) {
+        const uint8_t* source = packet.literals;
+
+        // Packets run on across rows and layers, split them at row ends
+        for (uint64_t remaining = packet.count; remaining > 0 && layer <= runs.getLastLayer();) {
+            int count = static_cast<int>(std::min<uint64_t>(remaining, width - column));
+            if (source) {
+                literals.resize(count);
+                std::memcpy(literals.data(), source, count * sizeof(TileID));
+                storage->writeRow(x + column, y + row, layer, count, literals.data());
+                source += count * sizeof(TileID);
+            } else {
+                storage->fillRow(x + column, y + row, layer, count, packet.id);
+            }
+
+            remaining -= count;
+            column += count;
+            if (column == width) {
+                column = 0;
+                if (++row == height) {
+                    row = 0;
+                    layer++;
+                }
+            }
+        }
+    }
+
+    chunkCache.markDirtyRect(x, y, x + width - 1, y + height - 1, runs.getFirstLayer(), runs.getLastLayer());
+    revision++;
+}
+
+bool Map::getOccupiedBounds(int layer, int& minX, int& minY, int& maxX, int& maxY) const {
+    if (!isValidLayer(layer)) {
+        return false;
+    }
+    return storage->getOccupiedBounds(layer, minX, minY, maxX, maxY);
+}
+
+EditJournal& Map::getJournal() {
+    return *journal;
+}
+
+uint64_t Map::computeStateHash() const {
+    uint64_t hash = 14695981039346656037ull;
+    hashValue(hash, static_cast<uint32_t>(mapWidth));
+    hashValue(hash, static_cast<uint32_t>(mapHeight));
+    hashValue(hash, static_cast<uint32_t>(numLayers));
+    hashValue(hash, (backgroundColor.r << 24) | (backgroundColor.g << 16) | (backgroundColor.b << 8) | backgroundColor.a);
+
+    // Row-major over each layer's occupied area, empty cells are skipped so
+    // only placed tiles and their positions count
+    for (int layer = 0; layer < numLayers; ++layer) {
+        int minX, minY, maxX, maxY;
+        if (!storage->getOccupiedBounds(layer, minX, minY, maxX, maxY)) {
+            continue;
+        }
+
+        for (int y = minY; y <= maxY; ++y) {
+            for (int runX = minX; runX <= maxX;) {
+                int runLength = 0;
+                const TileID* cells = storage->readRow(runX, y, layer, maxX - runX + 1, runLength);
+                for (int i = 0; cells && i < runLength; ++i) {
+                    if (cells[i] != EMPTY_TILE) {
+                        hashValue(hash, static_cast<uint64_t>(layer) << 48 | static_cast<uint64_t>(static_cast<uint16_t>(cells[i])) << 32);
+                        hashValue(hash, static_cast<uint64_t>(static_cast<uint32_t>(runX + i)) << 32 | static_cast<uint32_t>(y));
+                    }
+                }
+                runX += runLength;
+            }
+        }
+    }
+    return hash;
 }
 
 // Convert screen coordinates to grid coordinates
 void Map::screenToGrid(int screenX, int screenY, int& gridX, int& gridY) const {
-    Math::toGridCoordinates(tileWidth, tileHeight, screenX, screenY, gridX, gridY);
+    projection.toGrid(screenX, screenY, gridX, gridY);
 }
 
 // Convert grid coordinates to screen coordinates
 void Map::gridToScreen(int gridX, int gridY, int& screenX, int& screenY) const {
-    Math::toScreenCoordinates(tileWidth, tileHeight, gridX, gridY, screenX, screenY);
+    projection.toScreen(gridX, gridY, screenX, screenY);
 }
 
-bool Map::getSelectedTile(int screenX, int screenY, int& gridX, int& gridY) const {
+bool Map::getSelectedTile(int screenX, int screenY, int& gridX, int& gridY, int layer) const {
 
+    // Layers are drawn raised by half a tile each, as in renderWithCamera
+    float layerOffset = layer * tileHeight * cameraZoom * 0.5f;
     float adjustedX = (screenX + getCameraX()) / cameraZoom;
-    float adjustedY = (screenY + getCameraY()) / cameraZoom;
+    float adjustedY = (screenY + getCameraY() + layerOffset) / cameraZoom;
     
     screenToGrid(adjustedX, adjustedY, gridX, gridY);
 
     // Check if resulting grid coordinates are valid
-    if (gridX < 0 || gridY < 0 || gridX >= mapWidth || gridY >= mapHeight) {
-        return false;
+    return isValidPosition(gridX, gridY);
+}
+
+bool Map::pickTile(int screenX, int screenY, int& gridX, int& gridY, int& layer) const {
+    const float scaledTileWidth = tileWidth * cameraZoom;
+    const float scaledTileHeight = tileHeight * cameraZoom;
+
+    // Test the centre of the pixel, as the rasterizer does
+    const float pointX = screenX + 0.5f;
+    const float pointY = screenY + 0.5f;
+
+    for (int candidateLayer = numLayers - 1; candidateLayer >= 0; --candidateLayer) {
+        float layerOffset = candidateLayer * tileHeight * cameraZoom * 0.5f;
+
+        // Unzoomed anchors (top-center of the sprite) of the sprites that
+        // can cover the point, bounded like the view in computeVisibleRows
+        float anchorX = (pointX + cameraX) / cameraZoom;
+        float anchorY = (pointY + cameraY + layerOffset) / cameraZoom;
+        float left = anchorX - tileWidth * 0.5f;
+        float right = anchorX + tileWidth * 0.5f;
+        float top = anchorY - tileHeight;
+        float bottom = anchorY;
+
+        const float cornersX[4] = { left, right, left, right };
+        const float cornersY[4] = { top, top, bottom, bottom };
+
+        int minX = INT_MAX, maxX = INT_MIN;
+        int minY = INT_MAX, maxY = INT_MIN;
+        for (int i = 0; i < 4; ++i) {
+            int cornerX, cornerY;
+            screenToGrid(static_cast<int>(std::floor(cornersX[i])), static_cast<int>(std::floor(cornersY[i])), cornerX, cornerY);
+            minX = std::min(minX, cornerX);
+            maxX = std::max(maxX, cornerX);
+            minY = std::min(minY, cornerY);
+            maxY = std::max(maxY, cornerY);
+        }
+        minX -= 1;
+        maxX += 1;
+        minY -= 1;
+        maxY += 1;
+
+        if (isBounded()) {
+            minX = std::max(minX, 0);
+            maxX = std::min(maxX, mapWidth - 1);
+            minY = std::max(minY, 0);
+            maxY = std::min(maxY, mapHeight - 1);
+        }
+
+        // Rows are drawn in order and cells left to right, so walking both
+        // backwards meets the sprite drawn last, the visible one, first
+        for (int y = maxY; y >= minY; --y) {
+            float originX, stepX, originY, stepY;
+            projection.getRowLine(y, originX, stepX, originY, stepY);
+
+            int spanMin = minX;
+            int spanMax = maxX;
+            clipSpan(originX, stepX, left, right, spanMin, spanMax);
+            clipSpan(originY, stepY, top, bottom, spanMin, spanMax);
+
+            for (int x = spanMax; x >= spanMin; --x) {
+                TileID id = storage->get(x, y, candidateLayer);
+                if (id == EMPTY_TILE) {
+                    continue;
+                }
+                const TileType* type = TileRegistry::getType(id);
+                if (!type) {
+                    continue;
+                }
+
+                // Same placement as the destination rectangle of buildBand
+                int anchorScreenX, anchorScreenY;
+                projection.toScreen(x, y, anchorScreenX, anchorScreenY);
+                float spriteX = anchorScreenX * cameraZoom - scaledTileWidth * 0.5f - cameraX;
+                float spriteY = anchorScreenY * cameraZoom - cameraY - layerOffset;
+
+                if (type->isOpaqueAt((pointX - spriteX) / scaledTileWidth, (pointY - spriteY) / scaledTileHeight)) {
+                    gridX = x;
+                    gridY = y;
+                    layer = candidateLayer;
+                    return true;
+                }
+            }
+        }
     }
-    
-    return true;
+    return false;
+}
+
+// Bytes held by tile storage
+size_t Map::getMemoryUsage() const {
+    return storage->getMemoryUsage();
+}
+
+bool Map::flush() {
+    return storage->flush();
+}
+
+ChunkCache& Map::getChunkCache() {
+    return chunkCache;
 }
 
 SDL_Color Map::getBackgroundColor() const {
@@ -218,4 +1048,10 @@ SDL_Color Map::getBackgroundColor() const {
 
 void Map::setBackgroundColor(const SDL_Color& color) {
     backgroundColor = color;
+    revision++;
+}
+
+// Bumped by every change that alters what the map draws
+uint64_t Map::getRevision() const {
+    return revision;
 }
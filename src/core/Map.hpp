@@ -2,14 +2,74 @@
 #pragma once
 
 #include "Tile.hpp"
+#include "TileStorage.hpp"
+#include "ChunkCache.hpp"
+#include "TileStamp.hpp"
+#include "TileRuns.hpp"
+#include "utils/Math.hpp"
 #include <vector>
 #include <memory>
+#include <optional>
+
+class JobSystem;
+class EditJournal;
+
+// Per-frame counters filled by renderWithCamera
+struct RenderStats {
+    int tilesVisited = 0;   // Cells iterated after culling
+    int tilesDrawn = 0;     // Cells that produced a draw
+    int drawCalls = 0;      // Calls submitted to the SDL renderer
+};
+
+// How a map keeps its tiles in memory
+enum class StorageMode {
+    Dense,      // Flat array per layer, allocated up front
+    Chunked,    // Sparse chunks allocated on first write, optionally unbounded
+    Mapped      // Tile-ID file mapped into memory, see MapIO::openWorld
+};
+
+// How renderWithCamera submits tiles
+enum class RenderMode {
+    PerTile,    // One SDL_RenderTexture call per tile
+    Batched,    // One SDL_RenderGeometry call per run of tiles sharing an atlas page
+    ChunkCached // One pre-rendered texture per visible chunk, rebaked on edit
+};
 
 class Map {
 
 private:
-    int mapWidth, mapHeight, numLayers;                                    // Dimensions of the map in tiles
-    std::vector<std::vector<std::vector<std::unique_ptr<Tile>>>> tiles;      // 3D grid of tiles
+    // Visible column range of one grid row
+    struct RowSpan {
+        int y, minX, maxX;
+    };
+
+    // Consecutive quads of a band that share one atlas page
+    struct BatchRun {
+        SDL_Texture* texture;
+        int firstVertex, vertexCount;
+    };
+
+    // One SDL_RenderTexture call of the per-tile path
+    struct TileDraw {
+        SDL_Texture* texture;
+        SDL_FRect srcRect, destRect;
+    };
+
+    // Render list of a contiguous range of rows. Bands are built
+    // independently, possibly on worker threads, and submitted in row order.
+    struct RenderBand {
+        size_t firstRow = 0, endRow = 0;                // Rows [firstRow, endRow) of the span list
+        std::vector<SDL_Vertex> vertices;               // Batched modes
+        std::vector<BatchRun> runs;
+        std::vector<TileDraw> tileDraws;                // Per-tile mode
+        std::vector<TileID> typeIDs;                    // Types drawn, once per change of ID
+        std::vector<int> gridX, gridY, screenX, screenY;    // Storage run being transformed
+        int tilesVisited = 0, tilesDrawn = 0;
+    };
+
+    int mapWidth, mapHeight, numLayers;                                    // Dimensions of the map in tiles, 0x0 when unbounded
+    StorageMode storageMode;
+    std::unique_ptr<TileStorage> storage;
 
     SDL_Color backgroundColor;
 
@@ -20,28 +80,93 @@ private:
     // tile render size
     float tileWidth, tileHeight;
 
+    // Grid/screen transform for the tile size, rebuilt only when it changes
+    Math::Projection projection{ 64.0f, 64.0f };
+
+    // Incremented by tile edits, camera moves and display settings
+    uint64_t revision = 0;
+
+    // Culling scratch buffer, reused across frames
+    std::vector<RowSpan> visibleRows;
+    RenderStats renderStats;
+
+    // Render list state, buffers keep their capacity across frames
+    RenderMode renderMode = RenderMode::Batched;
+    std::vector<RenderBand> renderBands;
+    std::vector<int> batchIndices;          // Shared quad index pattern
+
+    // Views with fewer visible cells are built on the calling thread, the
+    // handoff would cost more than it saves
+    static constexpr size_t PARALLEL_MIN_CELLS = 4096;
+
+    // Undoable edits made through the journal
+    std::unique_ptr<EditJournal> journal;
+
+    // Chunk texture cache state
+    ChunkCache chunkCache;
+    uint64_t bakedRegistryRevision = 0;     // TileRegistry revision the chunks were baked against
+    std::vector<RowSpan> visibleChunks;     // Chunk rows with their chunk columns
+    std::vector<RowSpan> chunkRows;         // Tile rows of the chunk being baked
+
     // Helper method to check if coordinates are valid
     bool isValidPosition(int x, int y) const;
+    bool isValidLayer(int layer) const;
+
+    // Clip a rectangle to the map, false when nothing is left
+    bool clipRect(int& x, int& y, int& width, int& height) const;
+
+    // Collect the rows of a layer whose tiles can intersect the view
+    void computeVisibleRows(int layer, int viewWidth, int viewHeight, std::vector<RowSpan>& rows) const;
+
+    // Render list helpers. Building only reads the map, so bands can be
+    // built concurrently; submission stays on the renderer's thread.
+    void splitBands(const std::vector<RowSpan>& rows, int bandCount);
+    void buildBand(RenderBand& band, int layer, const std::vector<RowSpan>& rows,
+                   float scale, float offsetX, float offsetY, RenderMode mode) const;
+    void submitBand(SDL_Renderer* renderer, const RenderBand& band, RenderMode mode);
+    void drawRows(SDL_Renderer* renderer, int layer, const std::vector<RowSpan>& rows,
+                  float scale, float offsetX, float offsetY, RenderMode mode, JobSystem* jobs = nullptr);
+
+    // Chunk cache helpers
+    SDL_FRect getChunkBounds(int chunkX, int chunkY) const;
+    void getChunkRows(int chunkX, int chunkY, std::vector<RowSpan>& rows) const;
+    bool hasTilesInRows(int layer, const std::vector<RowSpan>& rows) const;
+    void bakeChunk(SDL_Renderer* renderer, ChunkCache::Entry& entry, int layer, const SDL_FRect& bounds);
+    void drawCachedChunks(SDL_Renderer* renderer, int layer);
 
 public:
-    // Constructor - creates empty map
-    Map(int width, int height, int numLayers, SDL_Color bgColor);
+    // Constructor - creates empty map. A chunked map given a zero width or
+    // height has no bounds and accepts any coordinate, negative included.
+    Map(int width, int height, int numLayers, SDL_Color bgColor, StorageMode mode = StorageMode::Dense);
     
+    // Map over a storage made elsewhere, such as a mapped world file
+    Map(std::unique_ptr<TileStorage> storage, int width, int height, int numLayers, SDL_Color bgColor, StorageMode mode);
+
     // Destructor
     ~Map();
+
+    // The journal refers back to its map
+    Map(const Map&) = delete;
+    Map& operator=(const Map&) = delete;
     
     // Tile management
-    void setTile(int x, int y, int layer, std::unique_ptr<Tile> tile);
+    void setTile(int x, int y, int layer, const Tile& tile);
     void setTile(int x, int y, int layer, int tileID);
     void removeTile(int x, int y, int layer);
     
     // Tile access
-    Tile* getTile(int x, int y, int layer) const;
+    std::optional<Tile> getTile(int x, int y, int layer) const;
+    int getTileID(int x, int y, int layer) const;
     bool hasTile(int x, int y, int layer) const;
 
     // Rendering
     //void render(SDL_Renderer* renderer, int layer);
-    void renderWithCamera(SDL_Renderer* renderer, float camX, float camY);
+    // With a job system the render lists of large views are built in
+    // parallel; the SDL calls and their order stay the same
+    void renderWithCamera(SDL_Renderer* renderer, float camX, float camY, JobSystem* jobs = nullptr);
+    const RenderStats& getRenderStats() const;
+    void setRenderMode(RenderMode mode);
+    RenderMode getRenderMode() const;
     
     // Camera control
     void setCamera(float x, float y);
@@ -55,13 +180,57 @@ public:
     int getWidth() const;
     int getHeight() const;
     int getLayerCount() const;
-    bool getSelectedTile(int screenX, int screenY, int& gridX, int& gridY) const;
+    bool isBounded() const;
+    StorageMode getStorageMode() const;
+    // Cell whose diamond is under a screen point at the height of a layer
+    bool getSelectedTile(int screenX, int screenY, int& gridX, int& gridY, int layer = 0) const;
+
+    // Topmost drawn tile with an opaque pixel under a screen point, tested
+    // from the top layer down against the tile types' alpha masks. A few
+    // cells per layer are tested whatever the map size. False when the
+    // point only shows background.
+    bool pickTile(int screenX, int screenY, int& gridX, int& gridY, int& layer) const;
+    size_t getMemoryUsage() const;
+    // Write edits of a mapped map to its file, other maps have nothing to flush
+    bool flush();
+    ChunkCache& getChunkCache();
     SDL_Color getBackgroundColor() const;
     void setBackgroundColor(const SDL_Color& color);
+    uint64_t getRevision() const;
 
     // Utility methods
     void clearMap();
     void fillWithTile(int tileID, int layer);
+
+    // Region editing. Rectangles are clipped to the map; every call writes
+    // whole row spans to the storage and invalidates the touched chunks in
+    // a single pass. A tileID of -1 clears.
+    void fillRect(int x, int y, int width, int height, int layer, int tileID);
+    void clearLayers(int firstLayer, int lastLayer);
+
+    // Copy every layer of a rectangle; cells outside the map come out empty
+    TileStamp copyRect(int x, int y, int width, int height) const;
+
+    // Write a stamp with its top-left cell at (x, y). A masked paste skips
+    // the stamp's empty cells instead of clearing the map under them.
+    void pasteStamp(const TileStamp& stamp, int x, int y, bool masked = true);
+    void copyRectFrom(const Map& source, int sourceX, int sourceY, int width, int height,
+                      int x, int y, bool masked = false);
+
+    // Run-length encoded snapshot of a rectangle over a range of layers,
+    // clipped like the other region edits, and its exact write-back
+    TileRuns encodeRect(int x, int y, int width, int height, int firstLayer, int lastLayer) const;
+    void decodeRect(const TileRuns& runs);
+
+    // Inclusive box that may hold the tiles of a layer, false when it is empty
+    bool getOccupiedBounds(int layer, int& minX, int& minY, int& maxX, int& maxY) const;
+
+    // Undo history of this map
+    EditJournal& getJournal();
+
+    // Hash of the dimensions, background and every placed tile, equal for
+    // equal content whatever the storage mode
+    uint64_t computeStateHash() const;
     
     // Coordinate conversion helpers
     void screenToGrid(int screenX, int screenY, int& gridX, int& gridY) const;
@@ -0,0 +1,704 @@
+// MapIO.cpp
+
+#include "MapIO.hpp"
+#include "JobSystem.hpp"
+#include "utils/BinaryIO.hpp"
+#include "utils/MappedFile.hpp"
+#include "utils/Profiler.hpp"
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <vector>
+
+using namespace BinaryIO;
+
+namespace {
+
+// Literal packets of version 1 files are handed to the encoder in pieces
+// of this many cells
+constexpr uint64_t LITERAL_PIECE = 1 << 16;
+
+// Magic, version, storage mode, reserved byte and header size
+constexpr size_t PREFIX_SIZE = 12;
+
+// Chunks handed to one job, a chunk alone is too little work
+constexpr int CHUNK_GRAIN = 4;
+
+// Bounds on what a version 2 header may declare
+constexpr int MAX_CHUNK_SIZE = 4096;
+constexpr uint32_t MAX_TILES = 65536;
+
+struct ChunkEntry {
+    int x, y, layer;
+    uint64_t offset;    // From the end of the index
+    uint32_t size;
+};
+
+// Everything in a version 2 file before the chunks
+struct FileHeader {
+    StorageMode mode = StorageMode::Dense;
+    int width = 0, height = 0, layers = 0;
+    SDL_Color color{};
+    float cameraX = 0.0f, cameraY = 0.0f, cameraZoom = 1.0f;
+    int chunkSize = 0;
+    std::vector<TileID> tiles;
+    std::vector<ChunkEntry> chunks;
+    uint32_t size = 0;                  // Bytes before the first chunk
+};
+
+// Chunk being saved, its cells and their encoding
+struct SavedChunk {
+    int x, y, layer;
+    TileRuns cells;
+    std::vector<TileID> ids;            // Tiles it uses, sorted
+    std::vector<uint8_t> bytes;
+};
+
+// Chunk being loaded, the bytes sit in buffer from begin
+struct LoadedChunk {
+    const ChunkEntry* entry;
+    const std::vector<uint8_t>* buffer;
+    size_t begin;
+};
+
+void forEachChunk(JobSystem* jobs, const char* name, int count, const std::function<void(int)>& function) {
+    if (!jobs) {
+        for (int i = 0; i < count; ++i) {
+            function(i);
+        }
+        return;
+    }
+    jobs->parallelFor(name, count, CHUNK_GRAIN, [&function](int begin, int end) {
+        for (int i = begin; i < end; ++i) {
+            function(i);
+        }
+    });
+}
+
+int floorDiv(int value, int divisor) {
+    return value >= 0 ? value / divisor : -((-static_cast<int64_t>(value) + divisor - 1) / divisor);
+}
+
+// Cells of a chunk's square that lie on the map, false when none do
+bool getChunkRect(int mapWidth, int mapHeight, int chunkSize, int chunkX, int chunkY,
+                  int& x, int& y, int& width, int& height) {
+    int64_t left = static_cast<int64_t>(chunkX) * chunkSize, top = static_cast<int64_t>(chunkY) * chunkSize;
+    int64_t right = left + chunkSize, bottom = top + chunkSize;
+    if (mapWidth > 0 && mapHeight > 0) {
+        left = std::max<int64_t>(left, 0);
+        top = std::max<int64_t>(top, 0);
+        right = std::min<int64_t>(right, mapWidth);
+        bottom = std::min<int64_t>(bottom, mapHeight);
+    }
+    if (left < INT32_MIN || top < INT32_MIN || right > INT32_MAX || bottom > INT32_MAX || left >= right || top >= bottom) {
+        return false;
+    }
+
+    x = static_cast<int>(left);
+    y = static_cast<int>(top);
+    width = static_cast<int>(right - left);
+    height = static_cast<int>(bottom - top);
+    return true;
+}
+
+// Intersect a rectangle with another in place, false when nothing is left
+bool intersect(int& x, int& y, int& width, int& height, const SDL_Rect& other) {
+    int64_t right = std::min<int64_t>(static_cast<int64_t>(x) + width, static_cast<int64_t>(other.x) + other.w);
+    int64_t bottom = std::min<int64_t>(static_cast<int64_t>(y) + height, static_cast<int64_t>(other.y) + other.h);
+    x = std::max(x, other.x);
+    y = std::max(y, other.y);
+    width = static_cast<int>(std::max<int64_t>(right - x, 0));
+    height = static_cast<int>(std::max<int64_t>(bottom - y, 0));
+    return width > 0 && height > 0;
+}
+
+std::unique_ptr<Map> createMap(const FileHeader& header) {
+    return std::make_unique<Map>(header.width, header.height, header.layers, header.color, header.mode);
+}
+
+void restoreCamera(Map& map, float x, float y, float zoom) {
+    map.setCamera(x, y);
+    map.zoomCamera(zoom / map.getCameraZoom());
+}
+
+// Header, tile table and index of a version 2 file; data holds at least
+// the bytes before the first chunk
+bool parseHeader(const std::vector<uint8_t>& data, FileHeader& header) {
+    size_t cursor = 4;
+    Reader reader(data, cursor);
+    bool magicOk = data.size() >= 4 && std::memcmp(data.data(), MapIO::MAGIC, 4) == 0;
+    uint16_t version = reader.u16();
+    uint8_t mode = reader.u8();
+    reader.u8();
+    header.size = reader.u32();
+    header.width = reader.i32();
+    header.height = reader.i32();
+    header.layers = reader.u16();
+    header.color.r = reader.u8();
+    header.color.g = reader.u8();
+    header.color.b = reader.u8();
+    header.color.a = reader.u8();
+    header.cameraX = reader.f32();
+    header.cameraY = reader.f32();
+    header.cameraZoom = reader.f32();
+    header.chunkSize = reader.u16();
+
+    header.mode = mode == static_cast<uint8_t>(StorageMode::Chunked) ? StorageMode::Chunked : StorageMode::Dense;
+    const bool bounded = header.width > 0 && header.height > 0;
+    if (!magicOk || !reader.isOk() || version != 2 || mode > static_cast<uint8_t>(StorageMode::Chunked)
+        || header.layers <= 0 || header.width < 0 || header.height < 0 || (!bounded && header.mode != StorageMode::Chunked)
+        || header.chunkSize <= 0 || header.chunkSize > MAX_CHUNK_SIZE || header.size > data.size()) {
+        return false;
+    }
+
+    uint32_t tileCount = reader.u32();
+    if (tileCount > MAX_TILES) {
+        return false;
+    }
+    header.tiles.resize(tileCount);
+    for (TileID& id : header.tiles) {
+        id = reader.u16();
+    }
+
+    // Index entries are 22 bytes
+    uint32_t chunkCount = reader.u32();
+    if (!reader.isOk() || cursor > header.size || chunkCount > (header.size - cursor) / 22) {
+        return false;
+    }
+    header.chunks.resize(chunkCount);
+    for (ChunkEntry& entry : header.chunks) {
+        entry.x = reader.i32();
+        entry.y = reader.i32();
+        entry.layer = reader.u16();
+        entry.offset = reader.u64();
+        entry.size = reader.u32();
+
+        int x, y, width, height;
+        if (entry.layer >= header.layers
+            || !getChunkRect(header.width, header.height, header.chunkSize, entry.x, entry.y, x, y, width, height)) {
+            return false;
+        }
+    }
+    return reader.isOk() && cursor == header.size;
+}
+
+// Cells of a chunk's square clipped to the map, row-major
+bool decodeChunk(const std::vector<uint8_t>& data, size_t begin, size_t end,
+                 const std::vector<TileID>& tiles, std::vector<TileID>& cells) {
+    size_t cursor = begin;
+    Reader reader(data, cursor);
+
+    auto lookup = [&tiles](uint64_t index, TileID& id) {
+        if (index > tiles.size()) {
+            return false;
+        }
+        id = index > 0 ? tiles[index - 1] : EMPTY_TILE;
+        return true;
+    };
+
+    size_t filled = 0;
+    while (filled < cells.size()) {
+        uint64_t header = reader.varint();
+        uint64_t count = header >> 1;
+        if (!reader.isOk() || count == 0 || count > cells.size() - filled) {
+            return false;
+        }
+
+        TileID id;
+        if (header & 1) {
+            for (uint64_t i = 0; i < count; ++i) {
+                if (!lookup(reader.varint(), id)) {
+                    return false;
+                }
+                cells[filled++] = id;
+            }
+        } else {
+            if (!lookup(reader.varint(), id)) {
+                return false;
+            }
+            std::fill_n(cells.begin() + filled, count, id);
+            filled += count;
+        }
+    }
+    return reader.isOk() && cursor == end;
+}
+
+// Decode chunks in parallel and write the part of each inside region, all
+// of it without one. Only the writes to the map are serial.
+bool decodeChunks(Map& map, const FileHeader& header, const std::vector<LoadedChunk>& chunks,
+                  const SDL_Rect* region, JobSystem* jobs) {
+    std::vector<TileRuns> runs(chunks.size());
+    std::vector<uint8_t> failed(chunks.size(), 0);
+
+    forEachChunk(jobs, "Decode map chunk", static_cast<int>(chunks.size()), [&](int index) {
+        const ChunkEntry& entry = *chunks[index].entry;
+        int x, y, width, height;
+        getChunkRect(header.width, header.height, header.chunkSize, entry.x, entry.y, x, y, width, height);
+
+        std::vector<TileID> cells(static_cast<size_t>(width) * height);
+        const size_t begin = chunks[index].begin;
+        if (!decodeChunk(*chunks[index].buffer, begin, begin + entry.size, header.tiles, cells)) {
+            failed[index] = 1;
+            return;
+        }
+
+        int targetX = x, targetY = y, targetWidth = width, targetHeight = height;
+        if (region && !intersect(targetX, targetY, targetWidth, targetHeight, *region)) {
+            return;
+        }
+
+        TileRuns& target = runs[index];
+        target = TileRuns(targetX, targetY, targetWidth, targetHeight, entry.layer, entry.layer);
+        for (int row = targetY; row < targetY + targetHeight; ++row) {
+            target.appendCells(cells.data() + static_cast<size_t>(row - y) * width + (targetX - x), targetWidth);
+        }
+        target.finish();
+    });
+
+    if (std::find(failed.begin(), failed.end(), 1) != failed.end()) {
+        return false;
+    }
+    for (const TileRuns& chunkRuns : runs) {
+        map.decodeRect(chunkRuns);
+    }
+    return true;
+}
+
+std::unique_ptr<Map> loadVersion1(const std::vector<uint8_t>& data, const std::string& path) {
+    size_t cursor = 6;
+    Reader reader(data, cursor);
+    uint8_t mode = reader.u8();
+    reader.u8();
+    int width = reader.i32();
+    int height = reader.i32();
+    int layers = reader.u16();
+    SDL_Color color;
+    color.r = reader.u8();
+    color.g = reader.u8();
+    color.b = reader.u8();
+    color.a = reader.u8();
+    float cameraX = reader.f32();
+    float cameraY = reader.f32();
+    float cameraZoom = reader.f32();
+    int regionX = reader.i32();
+    int regionY = reader.i32();
+    int regionWidth = reader.i32();
+    int regionHeight = reader.i32();
+
+    const StorageMode storageMode = mode == static_cast<uint8_t>(StorageMode::Chunked) ? StorageMode::Chunked : StorageMode::Dense;
+    const bool bounded = width > 0 && height > 0;
+    bool valid = reader.isOk() && mode <= static_cast<uint8_t>(StorageMode::Chunked) && layers > 0 && width >= 0 && height >= 0
+                 && (bounded || storageMode == StorageMode::Chunked) && regionWidth >= 0 && regionHeight >= 0;
+    if (valid && bounded && regionWidth > 0 && regionHeight > 0) {
+        valid = regionX >= 0 && regionY >= 0 && regionWidth <= width - regionX && regionHeight <= height - regionY;
+    }
+    if (!valid) {
+        SDL_Log("Map %s has an invalid header", path.c_str());
+        return nullptr;
+    }
+
+    auto map = std::make_unique<Map>(width, height, layers, color, storageMode);
+
+    if (regionWidth > 0 && regionHeight > 0) {
+        TileRuns runs(regionX, regionY, regionWidth, regionHeight, 0, layers - 1);
+        const uint64_t total = runs.getCellCount();
+        std::vector<TileID> literals;
+
+        uint64_t cells = 0;
+        while (cells < total) {
+            uint64_t header = reader.varint();
+            uint64_t count = header >> 1;
+            if (!reader.isOk() || count == 0 || count > total - cells) {
+                break;
+            }
+
+            if (header & 1) {
+                for (uint64_t done = 0; done < count;) {
+                    int piece = static_cast<int>(std::min(count - done, LITERAL_PIECE));
+                    const uint8_t* bytes = reader.bytes(static_cast<size_t>(piece) * 2);
+                    if (!bytes) {
+                        break;
+                    }
+                    literals.resize(piece);
+                    for (int i = 0; i < piece; ++i) {
+                        literals[i] = static_cast<TileID>(bytes[i * 2] | (bytes[i * 2 + 1] << 8));
+                    }
+                    runs.appendCells(literals.data(), piece);
+                    done += piece;
+                }
+            } else {
+                runs.appendRun(reader.u16(), count);
+            }
+            cells += count;
+        }
+
+        if (!reader.isOk() || cells != total || cursor != data.size()) {
+            SDL_Log("Map %s is truncated or corrupt", path.c_str());
+            return nullptr;
+        }
+        runs.finish();
+        map->decodeRect(runs);
+    }
+
+    restoreCamera(*map, cameraX, cameraY, cameraZoom);
+    return map;
+}
+
+}
+
+bool MapIO::saveMap(const Map& map, const std::string& path, JobSystem* jobs) {
+    PROFILE_ZONE("MapIO::saveMap");
+    const int layers = map.getLayerCount();
+
+    // Every chunk square that may hold tiles, layer by layer in row-major order
+    std::vector<SavedChunk> chunks;
+    for (int layer = 0; layer < layers; ++layer) {
+        int minX, minY, maxX, maxY;
+        if (!map.getOccupiedBounds(layer, minX, minY, maxX, maxY)) {
+            continue;
+        }
+        for (int chunkY = floorDiv(minY, CHUNK_SIZE); chunkY <= floorDiv(maxY, CHUNK_SIZE); ++chunkY) {
+            for (int chunkX = floorDiv(minX, CHUNK_SIZE); chunkX <= floorDiv(maxX, CHUNK_SIZE); ++chunkX) {
+                chunks.push_back({ chunkX, chunkY, layer, TileRuns(), {}, {} });
+            }
+        }
+    }
+
+    // Snapshot each chunk and list the tiles it uses
+    forEachChunk(jobs, "Scan map chunk", static_cast<int>(chunks.size()), [&](int index) {
+        SavedChunk& chunk = chunks[index];
+        int x, y, width, height;
+        if (!getChunkRect(map.getWidth(), map.getHeight(), CHUNK_SIZE, chunk.x, chunk.y, x, y, width, height)) {
+            return;
+        }
+        chunk.cells = map.encodeRect(x, y, width, height, chunk.layer, chunk.layer);
+
+        size_t offset = 0;
+        TileRuns::Packet packet;
+        while (chunk.cells.readPacket(offset, packet)) {
+            if (!packet.literals) {
+                if (packet.id != EMPTY_TILE) {
+                    chunk.ids.push_back(packet.id);
+                }
+                continue;
+            }
+            for (uint64_t i = 0; i < packet.count; ++i) {
+                TileID id;
+                std::memcpy(&id, packet.literals + i * sizeof(TileID), sizeof(TileID));
+                if (id != EMPTY_TILE) {
+                    chunk.ids.push_back(id);
+                }
+            }
+        }
+        std::sort(chunk.ids.begin(), chunk.ids.end());
+        chunk.ids.erase(std::unique(chunk.ids.begin(), chunk.ids.end()), chunk.ids.end());
+    });
+
+    chunks.erase(std::remove_if(chunks.begin(), chunks.end(), [](const SavedChunk& chunk) {
+        return chunk.ids.empty();
+    }), chunks.end());
+
+    // Tile table, cells store their tile's index + 1
+    std::vector<TileID> tiles;
+    for (const SavedChunk& chunk : chunks) {
+        tiles.insert(tiles.end(), chunk.ids.begin(), chunk.ids.end());
+    }
+    std::sort(tiles.begin(), tiles.end());
+    tiles.erase(std::unique(tiles.begin(), tiles.end()), tiles.end());
+
+    std::vector<uint32_t> lookup(MAX_TILES, 0);
+    for (size_t i = 0; i < tiles.size(); ++i) {
+        lookup[tiles[i]] = static_cast<uint32_t>(i + 1);
+    }
+
+    forEachChunk(jobs, "Encode map chunk", static_cast<int>(chunks.size()), [&](int index) {
+        SavedChunk& chunk = chunks[index];
+        size_t offset = 0;
+        TileRuns::Packet packet;
+        while (chunk.cells.readPacket(offset, packet)) {
+            putVarint(chunk.bytes, packet.count << 1 | (packet.literals ? 1 : 0));
+            if (!packet.literals) {
+                putVarint(chunk.bytes, lookup[packet.id]);
+                continue;
+            }
+            for (uint64_t i = 0; i < packet.count; ++i) {
+                TileID id;
+                std::memcpy(&id, packet.literals + i * sizeof(TileID), sizeof(TileID));
+                putVarint(chunk.bytes, lookup[id]);
+            }
+        }
+    });
+
+    const SDL_Color color = map.getBackgroundColor();
+    std::vector<uint8_t> out(MAGIC, MAGIC + 4);
+    putU16(out, VERSION);
+    // Mapped maps are bounded, they load back dense
+    putU8(out, static_cast<uint8_t>(map.getStorageMode() == StorageMode::Chunked ? StorageMode::Chunked : StorageMode::Dense));
+    putU8(out, 0);
+    putU32(out, 0);     // Header size, patched below
+    putI32(out, map.getWidth());
+    putI32(out, map.getHeight());
+    putU16(out, static_cast<uint16_t>(layers));
+    putU8(out, color.r);
+    putU8(out, color.g);
+    putU8(out, color.b);
+    putU8(out, color.a);
+    putF32(out, map.getCameraX());
+    putF32(out, map.getCameraY());
+    putF32(out, map.getCameraZoom());
+    putU16(out, static_cast<uint16_t>(CHUNK_SIZE));
+
+    putU32(out, static_cast<uint32_t>(tiles.size()));
+    for (TileID id : tiles) {
+        putU16(out, id);
+    }
+
+    putU32(out, static_cast<uint32_t>(chunks.size()));
+    uint64_t offset = 0;
+    for (const SavedChunk& chunk : chunks) {
+        putI32(out, chunk.x);
+        putI32(out, chunk.y);
+        putU16(out, static_cast<uint16_t>(chunk.layer));
+        putU64(out, offset);
+        putU32(out, static_cast<uint32_t>(chunk.bytes.size()));
+        offset += chunk.bytes.size();
+    }
+
+    const uint32_t headerSize = static_cast<uint32_t>(out.size());
+    for (int i = 0; i < 4; ++i) {
+        out[8 + i] = static_cast<uint8_t>(headerSize >> (i * 8));
+    }
+
+    out.reserve(out.size() + offset);
+    for (const SavedChunk& chunk : chunks) {
+        out.insert(out.end(), chunk.bytes.begin(), chunk.bytes.end());
+    }
+
+    if (!writeFile(path, out)) {
+        SDL_Log("Couldn't write map %s", path.c_str());
+        return false;
+    }
+    return true;
+}
+
+std::unique_ptr<Map> MapIO::loadMap(const std::string& path, JobSystem* jobs) {
+    PROFILE_ZONE("MapIO::loadMap");
+
+    // World files are mapped, not read
+    FileReader probe;
+    std::vector<uint8_t> data;
+    if (probe.open(path) && probe.read(0, 4, data) && std::memcmp(data.data(), WORLD_MAGIC, 4) == 0) {
+        return openWorld(path);
+    }
+    probe.close();
+
+    if (!readFile(path, data)) {
+        SDL_Log("Couldn't open map %s", path.c_str());
+        return nullptr;
+    }
+
+    size_t cursor = 4;
+    Reader reader(data, cursor);
+    bool magicOk = data.size() >= 4 && std::memcmp(data.data(), MAGIC, 4) == 0;
+    uint16_t version = reader.u16();
+    if (!magicOk || !reader.isOk() || version == 0 || version > VERSION) {
+        SDL_Log("%s is not a version %u map", path.c_str(), VERSION);
+        return nullptr;
+    }
+    if (version == 1) {
+        return loadVersion1(data, path);
+    }
+
+    FileHeader header;
+    if (!parseHeader(data, header)) {
+        SDL_Log("Map %s has an invalid header", path.c_str());
+        return nullptr;
+    }
+
+    std::vector<LoadedChunk> chunks;
+    chunks.reserve(header.chunks.size());
+    const uint64_t dataSize = data.size() - header.size;
+    for (const ChunkEntry& entry : header.chunks) {
+        if (entry.offset > dataSize || entry.size > dataSize - entry.offset) {
+            SDL_Log("Map %s is truncated or corrupt", path.c_str());
+            return nullptr;
+        }
+        chunks.push_back({ &entry, &data, static_cast<size_t>(header.size + entry.offset) });
+    }
+
+    auto map = createMap(header);
+    if (!decodeChunks(*map, header, chunks, nullptr, jobs)) {
+        SDL_Log("Map %s is truncated or corrupt", path.c_str());
+        return nullptr;
+    }
+    restoreCamera(*map, header.cameraX, header.cameraY, header.cameraZoom);
+    return map;
+}
+
+std::unique_ptr<Map> MapIO::loadMapRegion(const std::string& path, int x, int y, int width, int height, JobSystem* jobs) {
+    PROFILE_ZONE("MapIO::loadMapRegion");
+    FileReader file;
+    if (!file.open(path)) {
+        SDL_Log("Couldn't open map %s", path.c_str());
+        return nullptr;
+    }
+
+    // The prefix gives the size of everything before the chunks
+    std::vector<uint8_t> data;
+    FileHeader header;
+    bool versionOk = file.read(0, PREFIX_SIZE, data) && std::memcmp(data.data(), MAGIC, 4) == 0
+                     && (data[4] | (data[5] << 8)) == 2;
+    if (!versionOk) {
+        SDL_Log("%s is not a version 2 map", path.c_str());
+        return nullptr;
+    }
+    uint32_t headerSize = data[8] | (data[9] << 8) | (data[10] << 16) | (static_cast<uint32_t>(data[11]) << 24);
+    if (!file.read(0, headerSize, data) || !parseHeader(data, header)) {
+        SDL_Log("Map %s has an invalid header", path.c_str());
+        return nullptr;
+    }
+
+    SDL_Rect region = { x, y, std::max(width, 0), std::max(height, 0) };
+    if (header.width > 0 && header.height > 0 && !intersect(region.x, region.y, region.w, region.h,
+                                                            SDL_Rect{ 0, 0, header.width, header.height })) {
+        region.w = region.h = 0;
+    }
+
+    // Chunk bytes are read one by one, in file order
+    std::vector<const ChunkEntry*> selected;
+    for (const ChunkEntry& entry : header.chunks) {
+        int chunkX, chunkY, chunkWidth, chunkHeight;
+        getChunkRect(header.width, header.height, header.chunkSize, entry.x, entry.y, chunkX, chunkY, chunkWidth, chunkHeight);
+        if (intersect(chunkX, chunkY, chunkWidth, chunkHeight, region)) {
+            selected.push_back(&entry);
+        }
+    }
+
+    std::vector<std::vector<uint8_t>> buffers(selected.size());
+    std::vector<LoadedChunk> chunks;
+    chunks.reserve(selected.size());
+    for (size_t i = 0; i < selected.size(); ++i) {
+        if (!file.read(header.size + selected[i]->offset, selected[i]->size, buffers[i])) {
+            SDL_Log("Map %s is truncated or corrupt", path.c_str());
+            return nullptr;
+        }
+        chunks.push_back({ selected[i], &buffers[i], 0 });
+    }
+
+    auto map = createMap(header);
+    if (!decodeChunks(*map, header, chunks, &region, jobs)) {
+        SDL_Log("Map %s is truncated or corrupt", path.c_str());
+        return nullptr;
+    }
+    restoreCamera(*map, header.cameraX, header.cameraY, header.cameraZoom);
+    return map;
+}
+
+bool MapIO::saveWorld(const Map& map, const std::string& path) {
+    PROFILE_ZONE("MapIO::saveWorld");
+    if (!map.isBounded()) {
+        SDL_Log("Couldn't write world %s, the map has no bounds", path.c_str());
+        return false;
+    }
+
+    const int width = map.getWidth(), height = map.getHeight(), layers = map.getLayerCount();
+    const uint64_t layerBytes = static_cast<uint64_t>(width) * height * sizeof(TileID);
+    const uint64_t layerStride = (layerBytes + WORLD_ALIGNMENT - 1) / WORLD_ALIGNMENT * WORLD_ALIGNMENT;
+    const SDL_Color color = map.getBackgroundColor();
+
+    std::vector<uint8_t> header(WORLD_MAGIC, WORLD_MAGIC + 4);
+    putU16(header, WORLD_VERSION);
+    putU16(header, static_cast<uint16_t>(layers));
+    putI32(header, width);
+    putI32(header, height);
+    putU8(header, color.r);
+    putU8(header, color.g);
+    putU8(header, color.b);
+    putU8(header, color.a);
+    putU64(header, WORLD_ALIGNMENT);
+    putU64(header, layerStride);
+    header.resize(WORLD_ALIGNMENT, 0);
+
+    FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        SDL_Log("Couldn't write world %s", path.c_str());
+        return false;
+    }
+    bool written = std::fwrite(header.data(), 1, header.size(), file) == header.size();
+
+    // Row by row, a world may not fit in memory twice
+    std::vector<uint8_t> row(static_cast<size_t>(width) * sizeof(TileID));
+    const std::vector<uint8_t> padding(static_cast<size_t>(layerStride - layerBytes), 0);
+    for (int layer = 0; layer < layers && written; ++layer) {
+        for (int y = 0; y < height && written; ++y) {
+            TileRuns runs = map.encodeRect(0, y, width, 1, layer, layer);
+            size_t cell = 0, offset = 0;
+            TileRuns::Packet packet;
+            while (runs.readPacket(offset, packet)) {
+                for (uint64_t i = 0; i < packet.count; ++i, ++cell) {
+                    TileID id = packet.id;
+                    if (packet.literals) {
+                        std::memcpy(&id, packet.literals + i * sizeof(TileID), sizeof(TileID));
+                    }
+                    row[cell * 2] = static_cast<uint8_t>(id);
+                    row[cell * 2 + 1] = static_cast<uint8_t>(id >> 8);
+                }
+            }
+            written = std::fwrite(row.data(), 1, row.size(), file) == row.size();
+        }
+        written = written && (padding.empty() || std::fwrite(padding.data(), 1, padding.size(), file) == padding.size());
+    }
+
+    if (std::fclose(file) != 0 || !written) {
+        SDL_Log("Couldn't write world %s", path.c_str());
+        return false;
+    }
+    return true;
+}
+
+std::unique_ptr<Map> MapIO::openWorld(const std::string& path) {
+    PROFILE_ZONE("MapIO::openWorld");
+
+    // Cells are used in place, so they must already be in the machine's order
+    if (SDL_BYTEORDER != SDL_LIL_ENDIAN) {
+        SDL_Log("Couldn't open world %s, world files need a little endian machine", path.c_str());
+        return nullptr;
+    }
+
+    auto file = std::make_unique<MappedFile>();
+    if (!file->open(path, MappedFile::Access::CopyOnWrite)) {
+        SDL_Log("Couldn't map world %s", path.c_str());
+        return nullptr;
+    }
+
+    const size_t headerSize = 36;
+    std::vector<uint8_t> header(file->getData(), file->getData() + std::min(file->getSize(), headerSize));
+    size_t cursor = 4;
+    Reader reader(header, cursor);
+    bool magicOk = header.size() >= 4 && std::memcmp(header.data(), WORLD_MAGIC, 4) == 0;
+    uint16_t version = reader.u16();
+    int layers = reader.u16();
+    int width = reader.i32();
+    int height = reader.i32();
+    SDL_Color color;
+    color.r = reader.u8();
+    color.g = reader.u8();
+    color.b = reader.u8();
+    color.a = reader.u8();
+    uint64_t dataOffset = reader.u64();
+    uint64_t layerStride = reader.u64();
+
+    const uint64_t layerBytes = static_cast<uint64_t>(std::max(width, 0)) * std::max(height, 0) * sizeof(TileID);
+    bool valid = magicOk && reader.isOk() && version == WORLD_VERSION && layers > 0 && width > 0 && height > 0
+                 && dataOffset >= headerSize && dataOffset % sizeof(TileID) == 0 && layerStride % sizeof(TileID) == 0
+                 && layerStride >= layerBytes && dataOffset <= file->getSize()
+                 && layerStride <= (file->getSize() - dataOffset) / layers;
+    if (!valid) {
+        SDL_Log("%s is not a version %u world", path.c_str(), WORLD_VERSION);
+        return nullptr;
+    }
+
+    auto storage = std::make_unique<MappedTileStorage>(std::move(file), width, height, layers,
+                                                       static_cast<size_t>(dataOffset), static_cast<size_t>(layerStride));
+    return std::make_unique<Map>(std::move(storage), width, height, layers, color, StorageMode::Mapped);
+}
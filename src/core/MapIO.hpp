@@ -0,0 +1,75 @@
+// MapIO.hpp
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "Map.hpp"
+
+class JobSystem;
+
+// Binary map files, little endian. Version 2:
+//   header  "ISOM", u16 version, u8 storage mode, u8 reserved,
+//           u32 size of the header, tile table and index together,
+//           i32 width, i32 height (0x0 when unbounded), u16 layers,
+//           u8 background r, g, b, a, f32 camera x, y and zoom,
+//           u16 chunk size in cells
+//   tiles   u32 count, then count u16 tile IDs; cells refer to a tile by
+//           its index + 1, 0 is an empty cell
+//   index   u32 chunk count, then per chunk i32 chunk x, i32 chunk y,
+//           u16 layer, u64 offset from the end of the index, u32 size
+//   chunks  cells of the chunk's square clipped to the map, row-major,
+//           as packets: varint (count << 1 | literal), then one varint
+//           tile index, or count of them for a literal packet
+// Chunks without tiles are left out. Every chunk is compressed on its own,
+// so chunks are encoded and decoded in parallel and a region is read
+// without the rest of the file.
+//
+// Version 1 files still load:
+//   header  "ISOM", u16 version, u8 storage mode, u8 reserved,
+//           i32 width, i32 height, u16 layers, u8 background r, g, b, a,
+//           f32 camera x, y and zoom
+//   region  i32 x, i32 y, i32 width, i32 height of the box holding every
+//           layer's tiles, 0x0 when the map is empty
+//   cells   the region's cells layer by layer in row-major order, as
+//           TileRuns packets: varint (count << 1 | literal), then one
+//           u16 tile ID, or count of them for a literal packet
+namespace MapIO {
+    constexpr char MAGIC[4] = { 'I', 'S', 'O', 'M' };
+    constexpr uint16_t VERSION = 2;
+    constexpr int CHUNK_SIZE = 64;
+
+    // Chunks are encoded on the job system when one is given
+    bool saveMap(const Map& map, const std::string& path, JobSystem* jobs = nullptr);
+
+    // nullptr when the file can't be read or is not a valid map. Touches
+    // no renderer state, so it can run on a worker thread.
+    std::unique_ptr<Map> loadMap(const std::string& path, JobSystem* jobs = nullptr);
+
+    // Only the chunks overlapping the rectangle are read. The map has the
+    // file's size and settings but holds the rectangle's tiles only.
+    // Version 2 files only.
+    std::unique_ptr<Map> loadMapRegion(const std::string& path, int x, int y, int width, int height,
+                                       JobSystem* jobs = nullptr);
+
+    // World files, uncompressed for huge read-mostly maps, little endian:
+    //   header  "ISOW", u16 version, u16 layers, i32 width, i32 height,
+    //           u8 background r, g, b, a, u64 offset of the first layer,
+    //           u64 bytes from one layer to the next
+    //   cells   per layer, width * height u16 tile IDs in row-major order,
+    //           starting on a WORLD_ALIGNMENT boundary
+    // Opening maps the file rather than reading it. loadMap opens world
+    // files too.
+    constexpr char WORLD_MAGIC[4] = { 'I', 'S', 'O', 'W' };
+    constexpr uint16_t WORLD_VERSION = 1;
+    constexpr size_t WORLD_ALIGNMENT = 65536;  // A multiple of every common page size
+
+    // Bounded maps only
+    bool saveWorld(const Map& map, const std::string& path);
+
+    // Mapped map over the file, edits stay in memory until Map::flush
+    std::unique_ptr<Map> openWorld(const std::string& path);
+}
@@ -1,23 +1,11 @@
 // Tile.cpp
 #include "Tile.hpp"
-#include <iostream>
 #include "utils/Math.hpp"
 
 
-// Constructor - loads texture from file
+// Constructor
 Tile::Tile(int id, int posX, int posY, int width, int height)
     : tileID(id), gridX(posX), gridY(posY), width(width), height(height) {
-
-    // Calculate screen position from grid position
-    updateScreenPosition();
-}
-
-// Destructor
-Tile::~Tile() {
-    auto type = TileRegistry::getType(tileID);
-    if (type) {
-        // Texture will be freed if handled in TileType destructor
-    }
 }
 
 // Getters
@@ -42,10 +30,14 @@ int Tile::getGridY() const {
 }
 
 int Tile::getScreenX() const {
+    int screenX, screenY;
+    Math::toScreenCoordinates(width, height, gridX, gridY, screenX, screenY);
     return screenX;
 }
 
 int Tile::getScreenY() const {
+    int screenX, screenY;
+    Math::toScreenCoordinates(width, height, gridX, gridY, screenX, screenY);
     return screenY;
 }
 
@@ -54,18 +46,3 @@ SDL_Texture* Tile::getTexture() const {
     if (!type) return nullptr;
     return type->getTexture();
 }
-
-// Setters
-void Tile::setPosition(int posX, int posY) {
-    gridX = posX;
-    gridY = posY;
-    updateScreenPosition(); // Recalculate screen position
-}
-
-void Tile::setID(int id) {
-    tileID = id;
-}
-
-void Tile::updateScreenPosition() {
-    Math::toScreenCoordinates(width, height, gridX, gridY, screenX, screenY);
-}
\ No newline at end of file
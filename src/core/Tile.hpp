@@ -2,32 +2,34 @@
 
 #pragma once
 
+#include <cstdint>
 #include <string>
 
 #include <SDL3_image/SDL_image.h>
 #include "TileRegistry.hpp"
 
+// Compact tile type identifier stored in map cells
+using TileID = std::uint16_t;
+
+// Sentinel stored in cells that hold no tile
+constexpr TileID EMPTY_TILE = 0xFFFF;
+
+// Lightweight view of one map cell. Maps only store TileIDs; a Tile is built
+// on demand and derives its screen position from its grid position.
 class Tile {
 
 private: 
     int tileID; // ID of the tile type
     int gridX, gridY;    // Position in tile grid (0,0), (1,0), etc.
-    int screenX, screenY; // Actual screen position in pixels
     
     // tile render size
     int width;
     int height;
 
 public:
-    // Constructor to initialize the tile with a texture, ID, and position
+    // Constructor to initialize the tile view with an ID and position
     Tile(int id, int posX, int posY, int width, int height);
 
-    // Destructor to clean up the texture
-    ~Tile();
-
-    // Update screen position based on grid position
-    void updateScreenPosition();
-
     // Getters for tile properties
     int getID() const;
     int getWidth() const;
@@ -37,8 +39,4 @@ public:
     int getScreenX() const;
     int getScreenY() const;
     SDL_Texture* getTexture() const;
-
-    // Setters for tile properties
-    void setPosition(int posX, int posY);
-    void setID(int id);
-};
\ No newline at end of file
+};
@@ -1,59 +1,679 @@
 #include "TileRegistry.hpp"
+#include "AssetLoader.hpp"
+#include "AssetPack.hpp"
+#include "Tile.hpp"
+#include "utils/Profiler.hpp"
 #include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
 #include <SDL3_image/SDL_image.h>
 
-std::unordered_map<int, std::shared_ptr<TileType>> TileRegistry::registry;
+std::vector<std::unique_ptr<TileType>> TileRegistry::registry;
+std::unordered_map<const TileType*, int> TileRegistry::typeIDs;
+std::vector<AtlasPage> TileRegistry::atlasPages;
+uint64_t TileRegistry::revision = 0;
+std::unordered_map<std::string, TileRegistry::PackedImage> TileRegistry::packedImages;
+int TileRegistry::placeholderPage = -1;
+PackedRect TileRegistry::placeholderRect = { 0, 0, 0, 0 };
+AlphaMask TileRegistry::placeholderMask;
+std::vector<std::unique_ptr<TileRegistry::ManagedType>> TileRegistry::managedTypes;
+std::mutex TileRegistry::requestMutex;
+std::vector<int> TileRegistry::requestedIDs;
+std::atomic<uint64_t> TileRegistry::frameHits{ 0 };
+std::atomic<uint64_t> TileRegistry::frameMisses{ 0 };
+uint64_t TileRegistry::residencyFrame = 1;
+uint64_t TileRegistry::lastLoadTicket = 0;
+std::vector<uint64_t> TileRegistry::asyncTickets;
+size_t TileRegistry::textureBudget = TileRegistry::DEFAULT_TEXTURE_BUDGET;
+TileResidencyStats TileRegistry::residencyStats;
+
+namespace {
+
+// Placeholder: the top face of a tile as a grey checkered diamond
+constexpr int PLACEHOLDER_SIZE = 32;
+
+}
+
+bool TileRegistry::loadPack(SDL_Renderer* renderer, const AssetPack& pack) {
+    if (pack.getPadding() != ATLAS_PADDING) {
+        SDL_Log("Asset pack was built with padding %d, expected %d", pack.getPadding(), ATLAS_PADDING);
+        return false;
+    }
+
+    // Packing the images again in the pack's order must give its layout;
+    // it also leaves each page's packer knowing what is taken
+    std::vector<RectPacker> packers;
+    for (const AssetPack::Page& page : pack.getPages()) {
+        packers.emplace_back(page.width, page.height, ATLAS_PADDING);
+    }
+    for (const AssetPack::Image& image : pack.getImages()) {
+        PackedRect rect;
+        if (!packers[image.page].insert(image.rect.w, image.rect.h, rect) || rect.x != image.rect.x || rect.y != image.rect.y) {
+            SDL_Log("Asset pack layout doesn't match the atlas packer, rebuild the pack");
+            return false;
+        }
+    }
+
+    const int firstPage = static_cast<int>(atlasPages.size());
+    const std::vector<AssetPack::Page>& pages = pack.getPages();
+    for (size_t i = 0; i < pages.size(); ++i) {
+        const AssetPack::Page& page = pages[i];
+        SDL_Texture* texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STATIC, page.width, page.height);
+        if (!texture) {
+            SDL_Log("Failed to create atlas page: %s", SDL_GetError());
+            return false;
+        }
+        SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+        SDL_SetTextureScaleMode(texture, SDL_SCALEMODE_NEAREST);
+
+        // Straight from the mapped file, gutters included
+        if (!SDL_UpdateTexture(texture, nullptr, page.pixels, page.width * AssetPack::BYTES_PER_PIXEL)) {
+            SDL_Log("Failed to upload atlas page: %s", SDL_GetError());
+        }
+        atlasPages.push_back({ texture, std::move(packers[i]) });
+    }
+
+    for (const AssetPack::Image& image : pack.getImages()) {
+        AlphaMask mask(pack.getPixels(image), image.rect.w, image.rect.h, pack.getPitch(image));
+        packedImages[image.name] = { firstPage + image.page, image.rect, std::move(mask) };
+    }
+    return true;
+}
 
 void TileRegistry::registerType(int id, const std::string& name, SDL_Renderer* renderer, const char* imagePath) {
+    if (registerPacked(id, name, imagePath)) {
+        return;
+    }
+
+    SDL_Surface* surface = loadSurface(imagePath);
+
+    registerType(id, name, renderer, surface);
+
+    if (surface) {
+        SDL_DestroySurface(surface);
+    }
+}
+
+void TileRegistry::registerType(int id, const std::string& name, SDL_Renderer* renderer, SDL_Surface* surface) {
+    if (id < 0) {
+        SDL_Log("Invalid tile type ID %d for %s", id, name.c_str());
+        return;
+    }
+    forgetID(id);
+
+    int page = -1;
+    PackedRect rect = { 0, 0, 0, 0 };
+    AlphaMask mask;
+
+    // Types without an image are still registered, they just never draw
+    if (!surface || !packIntoAtlas(renderer, surface, page, rect, mask)) {
+        storeType(id, std::make_unique<TileType>(name, nullptr, -1, SDL_FRect{ 0, 0, 0, 0 }, SDL_FRect{ 0, 0, 0, 0 }));
+        return;
+    }
+
+    storeAtlasType(id, name, page, rect, std::move(mask));
+}
+
+void TileRegistry::registerType(int id, const std::string& name, SDL_Renderer* renderer, const char* imagePath, AssetLoader& loader) {
+    if (registerPacked(id, name, imagePath)) {
+        return;
+    }
+    if (id < 0) {
+        SDL_Log("Invalid tile type ID %d for %s", id, name.c_str());
+        return;
+    }
+
+    forgetID(id);
+    storePlaceholderType(id, name, renderer);
+
+    // Registered again by the time the image arrives, the newer type stays
+    if (id >= static_cast<int>(asyncTickets.size())) {
+        asyncTickets.resize(id + 1, 0);
+    }
+    const uint64_t ticket = ++lastLoadTicket;
+    asyncTickets[id] = ticket;
+    loader.load(imagePath, [id, name, renderer, ticket](SDL_Surface* surface) {
+        if (id < static_cast<int>(asyncTickets.size()) && asyncTickets[id] == ticket) {
+            registerType(id, name, renderer, surface);
+        }
+    });
+}
+
+// False when no loaded pack holds the image
+bool TileRegistry::registerPacked(int id, const std::string& name, const char* imagePath) {
+    auto it = packedImages.find(imagePath);
+    if (it == packedImages.end()) {
+        return false;
+    }
+    if (id < 0) {
+        SDL_Log("Invalid tile type ID %d for %s", id, name.c_str());
+    } else {
+        forgetID(id);
+        storeAtlasType(id, name, it->second.page, it->second.rect, it->second.mask);
+    }
+    return true;
+}
+
+// Types whose image isn't there yet draw the shared placeholder
+void TileRegistry::storePlaceholderType(int id, const std::string& name, SDL_Renderer* renderer, bool changesImage) {
+    if (packPlaceholder(renderer)) {
+        storeAtlasType(id, name, placeholderPage, placeholderRect, placeholderMask, changesImage);
+    } else {
+        storeType(id, std::make_unique<TileType>(name, nullptr, -1, SDL_FRect{ 0, 0, 0, 0 }, SDL_FRect{ 0, 0, 0, 0 }), changesImage);
+    }
+}
+
+// Type drawn from an atlas entry
+void TileRegistry::storeAtlasType(int id, const std::string& name, int page, const PackedRect& rect, AlphaMask mask,
+                                  bool changesImage) {
+    const RectPacker& packer = atlasPages[page].packer;
+    float pageWidth = static_cast<float>(packer.getWidth());
+    float pageHeight = static_cast<float>(packer.getHeight());
 
-    SDL_Texture* texture = nullptr;
+    SDL_FRect sourceRect = {
+        static_cast<float>(rect.x), static_cast<float>(rect.y),
+        static_cast<float>(rect.w), static_cast<float>(rect.h)
+    };
+    SDL_FRect uvRect = {
+        rect.x / pageWidth, rect.y / pageHeight,
+        rect.w / pageWidth, rect.h / pageHeight
+    };
 
-    texture = loadSprite(renderer, imagePath);
+    storeType(id, std::make_unique<TileType>(name, atlasPages[page].texture, page, sourceRect, uvRect, std::move(mask)), changesImage);
+}
+
+// Put a type in its dense slot and keep the reverse map in sync. Evictions
+// don't change the image, chunks baked with it can keep it.
+void TileRegistry::storeType(int id, std::unique_ptr<TileType> type, bool changesImage) {
+    if (id >= static_cast<int>(registry.size())) {
+        registry.resize(id + 1);
+    }
 
-    registry[id] = std::make_shared<TileType>(name, texture);
+    if (registry[id]) {
+        typeIDs.erase(registry[id].get());
+    }
+    typeIDs[type.get()] = id;
+    registry[id] = std::move(type);
+    if (changesImage) {
+        revision++;
+    }
 }
 
-SDL_Texture* TileRegistry::loadSprite(SDL_Renderer* renderer, const char* imagePath) {
+SDL_Surface* TileRegistry::loadSurface(const char* imagePath) {
     SDL_Surface* surface = IMG_Load(imagePath);
     if (!surface) {
         SDL_Log("Failed to load image %s: %s", imagePath, SDL_GetError());
         return nullptr;
     }
+    return surface;
+}
 
-    SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, surface);
-    if (!texture) {
-        SDL_Log("Failed to create texture from %s: %s", imagePath, SDL_GetError());
-    } else {
-        SDL_SetTextureScaleMode(texture, SDL_SCALEMODE_NEAREST);
+bool TileRegistry::packPlaceholder(SDL_Renderer* renderer) {
+    if (placeholderPage >= 0) {
+        return true;
     }
 
+    SDL_Surface* surface = SDL_CreateSurface(PLACEHOLDER_SIZE, PLACEHOLDER_SIZE, SDL_PIXELFORMAT_RGBA32);
+    if (!surface) {
+        SDL_Log("Failed to create placeholder image: %s", SDL_GetError());
+        return false;
+    }
+
+    const float half = PLACEHOLDER_SIZE * 0.5f;
+    for (int y = 0; y < PLACEHOLDER_SIZE; ++y) {
+        Uint8* pixel = static_cast<Uint8*>(surface->pixels) + y * surface->pitch;
+        for (int x = 0; x < PLACEHOLDER_SIZE; ++x, pixel += 4) {
+            bool inside = std::fabs(x + 0.5f - half) / half + std::fabs(y + 0.5f - half * 0.5f) / (half * 0.5f) <= 1.0f;
+            Uint8 shade = ((x / 4 + y / 4) % 2 == 0) ? 150 : 110;
+            pixel[0] = pixel[1] = pixel[2] = shade;
+            pixel[3] = inside ? 255 : 0;
+        }
+    }
+
+    bool packed = packIntoAtlas(renderer, surface, placeholderPage, placeholderRect, placeholderMask);
     SDL_DestroySurface(surface);
-    return texture;
+    if (!packed) {
+        placeholderPage = -1;
+    }
+    return packed;
 }
 
-std::shared_ptr<TileType> TileRegistry::getType(int id) {
-    auto it = registry.find(id);
-    return (it != registry.end()) ? it->second : nullptr;
+// Create an empty, transparent atlas page and return its index
+int TileRegistry::createAtlasPage(SDL_Renderer* renderer, int minWidth, int minHeight) {
+    int width = std::max(ATLAS_PAGE_SIZE, minWidth + ATLAS_PADDING * 2);
+    int height = std::max(ATLAS_PAGE_SIZE, minHeight + ATLAS_PADDING * 2);
+
+    SDL_Texture* texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STATIC, width, height);
+    if (!texture) {
+        SDL_Log("Failed to create atlas page: %s", SDL_GetError());
+        return -1;
+    }
+    SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+    SDL_SetTextureScaleMode(texture, SDL_SCALEMODE_NEAREST);
+
+    // Texture contents start undefined, clear the gutters once
+    std::vector<Uint32> clearPixels(static_cast<size_t>(width) * height, 0);
+    SDL_UpdateTexture(texture, nullptr, clearPixels.data(), width * static_cast<int>(sizeof(Uint32)));
+
+    // Reuse the slot of a freed page, types refer to pages by index
+    for (int page = 0; page < static_cast<int>(atlasPages.size()); ++page) {
+        if (!atlasPages[page].texture) {
+            atlasPages[page] = { texture, RectPacker(width, height, ATLAS_PADDING) };
+            return page;
+        }
+    }
+    atlasPages.push_back({ texture, RectPacker(width, height, ATLAS_PADDING) });
+    return static_cast<int>(atlasPages.size()) - 1;
 }
 
-int TileRegistry::getTileID(const TileType* tile) {
-    for (const auto& pair : registry) {
-        if (pair.second.get() == tile) {
-            return pair.first;
+// Find room for the image on an existing page or a new one and upload it,
+// keeping its alpha mask on the CPU side
+bool TileRegistry::packIntoAtlas(SDL_Renderer* renderer, SDL_Surface* surface, int& page, PackedRect& rect, AlphaMask& mask) {
+    // Surfaces from the AssetLoader already are RGBA32
+    SDL_Surface* converted = surface->format == SDL_PIXELFORMAT_RGBA32 ? surface : SDL_ConvertSurface(surface, SDL_PIXELFORMAT_RGBA32);
+    if (!converted) {
+        SDL_Log("Failed to convert image for atlas: %s", SDL_GetError());
+        return false;
+    }
+
+    page = -1;
+    for (int i = 0; i < static_cast<int>(atlasPages.size()); ++i) {
+        if (atlasPages[i].texture && atlasPages[i].packer.insert(converted->w, converted->h, rect)) {
+            page = i;
+            break;
+        }
+    }
+
+    // Every page is full, start a new one
+    if (page < 0) {
+        page = createAtlasPage(renderer, converted->w, converted->h);
+        if (page < 0 || !atlasPages[page].packer.insert(converted->w, converted->h, rect)) {
+            if (converted != surface) {
+                SDL_DestroySurface(converted);
+            }
+            return false;
         }
     }
-    return -1;  // Not found
+
+    mask = AlphaMask(converted->pixels, converted->w, converted->h, converted->pitch);
+
+    SDL_Rect destRect = { rect.x, rect.y, rect.w, rect.h };
+    if (!SDL_UpdateTexture(atlasPages[page].texture, &destRect, converted->pixels, converted->pitch)) {
+        SDL_Log("Failed to upload image to atlas: %s", SDL_GetError());
+    }
+
+    if (converted != surface) {
+        SDL_DestroySurface(converted);
+    }
+    return true;
+}
+
+// Hot path: bounds check plus an index, no ownership changes hands
+const TileType* TileRegistry::getType(int id) {
+    if (id < 0 || id >= static_cast<int>(registry.size())) {
+        return nullptr;
+    }
+    return registry[id].get();
 }
 
+int TileRegistry::getTileID(const TileType* tile) {
+    auto it = typeIDs.find(tile);
+    return (it != typeIDs.end()) ? it->second : -1;  // -1 if not found
+}
+
+// Registered types in ID order
 std::vector<const TileType*> TileRegistry::getAllTypes() {
     std::vector<const TileType*> types;
-    for (const auto& pair : registry) {
-        types.push_back(pair.second.get());
+    types.reserve(typeIDs.size());
+    for (const auto& type : registry) {
+        if (type) {
+            types.push_back(type.get());
+        }
     }
     return types;
 }
 
+size_t TileRegistry::getPageBytes(int page) {
+    if (!atlasPages[page].texture) {
+        return 0;
+    }
+    return static_cast<size_t>(atlasPages[page].packer.getWidth()) * atlasPages[page].packer.getHeight() * sizeof(Uint32);
+}
+
+size_t TileRegistry::getAtlasBytes() {
+    size_t bytes = 0;
+    for (int page = 0; page < static_cast<int>(atlasPages.size()); ++page) {
+        bytes += getPageBytes(page);
+    }
+    return bytes;
+}
+
+int TileRegistry::getAtlasPageCount() {
+    return static_cast<int>(atlasPages.size());
+}
+
+const AtlasPage& TileRegistry::getAtlasPage(int page) {
+    return atlasPages[page];
+}
+
+uint64_t TileRegistry::getRevision() {
+    return revision;
+}
+
+bool TileRegistry::loadManifest(SDL_Renderer* renderer, const std::string& path, AssetLoader* loader) {
+    PROFILE_ZONE("TileRegistry::loadManifest");
+    std::ifstream file(path);
+    if (!file) {
+        SDL_Log("Couldn't open tile manifest %s", path.c_str());
+        return false;
+    }
+
+    std::vector<bool> listed;
+    std::vector<int> residentIDs;
+    std::string line;
+    for (int lineNumber = 1; std::getline(file, line); ++lineNumber) {
+        std::istringstream fields(line);
+        std::string first;
+        if (!(fields >> first) || first[0] == '#') {
+            continue;
+        }
+
+        fields.seekg(0);
+        int id = -1;
+        std::string name, imagePath, word;
+        fields >> id >> std::quoted(name) >> imagePath;
+        bool valid = !fields.fail() && id >= 0 && id < EMPTY_TILE;
+        uint32_t flags = 0;
+        while (valid && fields >> word) {
+            if (word == "resident") {
+                flags |= TILE_RESIDENT;
+            } else if (word == "hidden") {
+                flags |= TILE_HIDDEN;
+            } else {
+                valid = false;
+            }
+        }
+        if (!valid) {
+            SDL_Log("%s:%d: expected id \"name\" image-path [resident] [hidden]", path.c_str(), lineNumber);
+            return false;
+        }
+        if (id < static_cast<int>(listed.size()) && listed[id]) {
+            SDL_Log("%s:%d: tile type ID %d is listed twice", path.c_str(), lineNumber, id);
+            return false;
+        }
+        if (id >= static_cast<int>(listed.size())) {
+            listed.resize(id + 1, false);
+        }
+        listed[id] = true;
+
+        forgetID(id);
+        storePlaceholderType(id, name, renderer);
+        if (id >= static_cast<int>(managedTypes.size())) {
+            managedTypes.resize(id + 1);
+        }
+        managedTypes[id] = std::make_unique<ManagedType>();
+        managedTypes[id]->imagePath = imagePath;
+        managedTypes[id]->flags = flags;
+        if (flags & TILE_RESIDENT) {
+            residentIDs.push_back(id);
+        }
+    }
+
+    for (int id : residentIDs) {
+        managedTypes[id]->requested = true;
+        startLoad(id, renderer, loader);
+    }
+    return true;
+}
+
+void TileRegistry::markUsedSlow(ManagedType& type, int id) {
+    // Several threads may draw the type in one frame, only one counts it
+    if (type.lastUsedFrame.exchange(residencyFrame, std::memory_order_relaxed) == residencyFrame) {
+        return;
+    }
+    if (type.resident) {
+        frameHits.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    frameMisses.fetch_add(1, std::memory_order_relaxed);
+    if (!type.requested.exchange(true)) {
+        std::lock_guard<std::mutex> lock(requestMutex);
+        requestedIDs.push_back(id);
+    }
+}
+
+void TileRegistry::updateResidency(SDL_Renderer* renderer, AssetLoader* loader) {
+    PROFILE_ZONE("TileRegistry::updateResidency");
+    std::vector<int> requests;
+    {
+        std::lock_guard<std::mutex> lock(requestMutex);
+        requests.swap(requestedIDs);
+    }
+    for (int id : requests) {
+        // Types registered some other way since they were requested are skipped
+        if (id < static_cast<int>(managedTypes.size()) && managedTypes[id]
+            && !managedTypes[id]->resident && !managedTypes[id]->loading) {
+            startLoad(id, renderer, loader);
+        }
+    }
+
+    residencyStats.hits += frameHits.exchange(0);
+    residencyStats.misses += frameMisses.exchange(0);
+    enforceTextureBudget(renderer);
+    residencyFrame++;
+}
+
+void TileRegistry::startLoad(int id, SDL_Renderer* renderer, AssetLoader* loader) {
+    ManagedType& type = *managedTypes[id];
+
+    // Already on a pack's page, nothing to load
+    auto packed = packedImages.find(type.imagePath);
+    if (packed != packedImages.end()) {
+        storeAtlasType(id, registry[id]->getName(), packed->second.page, packed->second.rect, packed->second.mask);
+        type.resident = true;
+        type.packed = true;
+        type.page = packed->second.page;
+        type.rect = packed->second.rect;
+        type.requested = false;
+        residencyStats.loads++;
+        return;
+    }
+
+    type.loading = true;
+    type.loadTicket = ++lastLoadTicket;
+    const uint64_t ticket = type.loadTicket;
+    if (loader) {
+        loader->load(type.imagePath, [id, renderer, ticket](SDL_Surface* surface) {
+            finishLoad(id, renderer, surface, ticket);
+        });
+    } else {
+        SDL_Surface* surface = loadSurface(type.imagePath.c_str());
+        finishLoad(id, renderer, surface, ticket);
+        if (surface) {
+            SDL_DestroySurface(surface);
+        }
+    }
+}
+
+void TileRegistry::finishLoad(int id, SDL_Renderer* renderer, SDL_Surface* surface, uint64_t ticket) {
+    // Cleared or registered again while the image was loading
+    if (id >= static_cast<int>(managedTypes.size()) || !managedTypes[id]
+        || !managedTypes[id]->loading || managedTypes[id]->loadTicket != ticket) {
+        return;
+    }
+    ManagedType& type = *managedTypes[id];
+    type.loading = false;
+
+    // A failed type keeps its placeholder and stays requested, so it isn't
+    // retried every frame
+    int page = -1;
+    PackedRect rect = { 0, 0, 0, 0 };
+    AlphaMask mask;
+    if (!surface || !packIntoAtlas(renderer, surface, page, rect, mask)) {
+        return;
+    }
+
+    storeAtlasType(id, registry[id]->getName(), page, rect, std::move(mask));
+    type.resident = true;
+    type.page = page;
+    type.rect = rect;
+    type.requested = false;
+    residencyStats.loads++;
+}
+
+// Give the type's atlas area back, freeing the page once it is empty. Pack
+// images stay where they are.
+void TileRegistry::releaseImage(ManagedType& type) {
+    if (!type.resident) {
+        return;
+    }
+    if (!type.packed) {
+        AtlasPage& page = atlasPages[type.page];
+        page.packer.release(type.rect);
+        if (page.packer.isEmpty()) {
+            // Nothing draws from it any more
+            SDL_DestroyTexture(page.texture);
+            page.texture = nullptr;
+        } else {
+            // Cleared so a smaller image placed here later has clean gutters
+            std::vector<Uint32> clearPixels(static_cast<size_t>(type.rect.w) * type.rect.h, 0);
+            SDL_Rect area = { type.rect.x, type.rect.y, type.rect.w, type.rect.h };
+            SDL_UpdateTexture(page.texture, &area, clearPixels.data(), type.rect.w * static_cast<int>(sizeof(Uint32)));
+        }
+    }
+    type.resident = false;
+    type.packed = false;
+    type.page = -1;
+}
+
+void TileRegistry::evict(int id, SDL_Renderer* renderer) {
+    ManagedType& type = *managedTypes[id];
+    releaseImage(type);
+    storePlaceholderType(id, registry[id]->getName(), renderer, false);
+    type.requested = false;
+    residencyStats.evictions++;
+}
+
+// The ID is being registered again: drop its manifest entry and ignore any
+// image still being decoded for it
+void TileRegistry::forgetID(int id) {
+    if (id < static_cast<int>(managedTypes.size()) && managedTypes[id]) {
+        releaseImage(*managedTypes[id]);
+        managedTypes[id].reset();
+    }
+    if (id < static_cast<int>(asyncTickets.size())) {
+        asyncTickets[id] = 0;
+    }
+}
+
+// Whole pages are freed, least recently drawn first. A page only goes when
+// every image on it is a manifest type that may be evicted and wasn't
+// drawn this frame.
+void TileRegistry::enforceTextureBudget(SDL_Renderer* renderer) {
+    size_t atlasBytes = getAtlasBytes();
+    if (atlasBytes <= textureBudget) {
+        return;
+    }
+
+    struct PageUse {
+        long long evictableArea = 0;
+        uint64_t lastUsedFrame = 0;
+        bool pinned = false;
+        std::vector<int> ids;
+    };
+    std::vector<PageUse> pages(atlasPages.size());
+    for (int id = 0; id < static_cast<int>(managedTypes.size()); ++id) {
+        const ManagedType* type = managedTypes[id].get();
+        if (!type || !type->resident || type->packed) {
+            continue;
+        }
+        PageUse& page = pages[type->page];
+        const uint64_t lastUsed = type->lastUsedFrame.load(std::memory_order_relaxed);
+        if ((type->flags & TILE_RESIDENT) || lastUsed >= residencyFrame) {
+            page.pinned = true;
+            continue;
+        }
+        page.evictableArea += static_cast<long long>(type->rect.w + ATLAS_PADDING * 2) * (type->rect.h + ATLAS_PADDING * 2);
+        page.lastUsedFrame = std::max(page.lastUsedFrame, lastUsed);
+        page.ids.push_back(id);
+    }
+
+    std::vector<int> candidates;
+    for (int page = 0; page < static_cast<int>(pages.size()); ++page) {
+        if (!pages[page].pinned && !pages[page].ids.empty()
+            && pages[page].evictableArea == atlasPages[page].packer.getUsedArea()) {
+            candidates.push_back(page);
+        }
+    }
+    std::sort(candidates.begin(), candidates.end(), [&pages](int a, int b) {
+        return pages[a].lastUsedFrame < pages[b].lastUsedFrame;
+    });
+
+    for (int page : candidates) {
+        if (atlasBytes <= textureBudget) {
+            break;
+        }
+        atlasBytes -= getPageBytes(page);
+        for (int id : pages[page].ids) {
+            evict(id, renderer);
+        }
+    }
+}
+
+void TileRegistry::setTextureBudget(size_t bytes) {
+    textureBudget = bytes;
+}
+
+size_t TileRegistry::getTextureBudget() {
+    return textureBudget;
+}
+
+TileResidencyStats TileRegistry::getResidencyStats() {
+    TileResidencyStats stats = residencyStats;
+    for (const auto& type : managedTypes) {
+        if (type) {
+            stats.managedTypes++;
+            stats.residentTypes += type->resident ? 1 : 0;
+            stats.loadingTypes += type->loading ? 1 : 0;
+        }
+    }
+    for (int page = 0; page < static_cast<int>(atlasPages.size()); ++page) {
+        stats.atlasPages += atlasPages[page].texture ? 1 : 0;
+    }
+    stats.atlasBytes = getAtlasBytes();
+    stats.budgetBytes = textureBudget;
+    return stats;
+}
+
+// Manifest flags of the type, 0 for types registered otherwise
+uint32_t TileRegistry::getFlags(int id) {
+    if (id < 0 || id >= static_cast<int>(managedTypes.size()) || !managedTypes[id]) {
+        return 0;
+    }
+    return managedTypes[id]->flags;
+}
+
 
 void TileRegistry::clear() {
     registry.clear(); 
-}
\ No newline at end of file
+    typeIDs.clear();
+
+    for (auto& page : atlasPages) {
+        if (page.texture) {
+            SDL_DestroyTexture(page.texture);
+        }
+    }
+    atlasPages.clear();
+    packedImages.clear();
+    placeholderPage = -1;
+    placeholderMask = AlphaMask();
+    revision++;
+
+    managedTypes.clear();
+    requestedIDs.clear();
+    asyncTickets.clear();
+    residencyStats = TileResidencyStats();
+}
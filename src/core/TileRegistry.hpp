@@ -1,21 +1,166 @@
 #pragma once
 
+#include <atomic>
+#include <cstdint>
+#include <mutex>
 #include <unordered_map>
 #include <memory>
 #include <string>
 #include <vector>
 
 #include "TileType.hpp"
+#include "utils/RectPacker.hpp"
+
+class AssetLoader;
+class AssetPack;
+
+// One texture page of the tile atlas
+struct AtlasPage {
+    SDL_Texture* texture;
+    RectPacker packer;
+};
+
+// Flags of a manifest entry
+enum TileFlags : uint32_t {
+    TILE_RESIDENT = 1 << 0,     // Image loaded up front and never evicted
+    TILE_HIDDEN = 1 << 1,       // Left out of the tile palette
+};
+
+// Image residency of the types loaded from manifests
+struct TileResidencyStats {
+    int managedTypes = 0;
+    int residentTypes = 0;      // With their image on the atlas
+    int loadingTypes = 0;
+    int atlasPages = 0;         // Allocated atlas pages, pack pages included
+    size_t atlasBytes = 0;      // Their memory, what the budget limits
+    size_t budgetBytes = 0;
+    uint64_t hits = 0;          // Once per type and frame, drawn with its image
+    uint64_t misses = 0;        // Drawn as a placeholder, its image requested
+    uint64_t loads = 0;
+    uint64_t evictions = 0;
+};
 
 class TileRegistry {
 private:
-    static std::unordered_map<int, std::shared_ptr<TileType>> registry;
-    static SDL_Texture* loadSprite(SDL_Renderer* renderer, const char* imagePath);
+    static std::vector<std::unique_ptr<TileType>> registry;    // Indexed by tile ID, null where unregistered
+    static std::unordered_map<const TileType*, int> typeIDs;   // Reverse lookup for getTileID
+    static std::vector<AtlasPage> atlasPages;
+    static uint64_t revision;
+
+    // Images of loaded packs by name, already on atlas pages
+    struct PackedImage {
+        int page;
+        PackedRect rect;
+        AlphaMask mask;
+    };
+    static std::unordered_map<std::string, PackedImage> packedImages;
+
+    // Manifest types, their images are loaded when first drawn and evicted
+    // with the atlas page they are on once over budget
+    struct ManagedType {
+        std::string imagePath;
+        uint32_t flags = 0;
+        std::atomic<uint64_t> lastUsedFrame{ 0 };
+        std::atomic<bool> requested{ false };   // Queued for loading, or failed to
+        bool resident = false;
+        bool loading = false;
+        bool packed = false;        // Held by an asset pack page, never evicted
+        uint64_t loadTicket = 0;
+        int page = -1;
+        PackedRect rect = { 0, 0, 0, 0 };
+    };
+    static std::vector<std::unique_ptr<ManagedType>> managedTypes;     // By tile ID, null for other types
+    static std::mutex requestMutex;
+    static std::vector<int> requestedIDs;      // Drawn as placeholders since the last update
+    static std::atomic<uint64_t> frameHits, frameMisses;
+    static uint64_t residencyFrame;
+    static uint64_t lastLoadTicket;            // Tells a load's result from an older one's
+    static std::vector<uint64_t> asyncTickets; // By tile ID, the loader registration in flight or 0
+    static size_t textureBudget;
+    static TileResidencyStats residencyStats;
+
+    // Shared image of types still loading, packed on first use
+    static int placeholderPage;
+    static PackedRect placeholderRect;
+    static AlphaMask placeholderMask;
+
+    static SDL_Surface* loadSurface(const char* imagePath);
+    static int createAtlasPage(SDL_Renderer* renderer, int minWidth, int minHeight);
+    static bool packIntoAtlas(SDL_Renderer* renderer, SDL_Surface* surface, int& page, PackedRect& rect, AlphaMask& mask);
+    static bool packPlaceholder(SDL_Renderer* renderer);
+    static void storeAtlasType(int id, const std::string& name, int page, const PackedRect& rect, AlphaMask mask,
+                               bool changesImage = true);
+    static void storeType(int id, std::unique_ptr<TileType> type, bool changesImage = true);
+    static bool registerPacked(int id, const std::string& name, const char* imagePath);
+    static void storePlaceholderType(int id, const std::string& name, SDL_Renderer* renderer, bool changesImage = true);
+    static void startLoad(int id, SDL_Renderer* renderer, AssetLoader* loader);
+    static void finishLoad(int id, SDL_Renderer* renderer, SDL_Surface* surface, uint64_t ticket);
+    static void evict(int id, SDL_Renderer* renderer);
+    static void releaseImage(ManagedType& type);
+    static void forgetID(int id);
+    static void enforceTextureBudget(SDL_Renderer* renderer);
+    static size_t getPageBytes(int page);
+    static size_t getAtlasBytes();
+
+    static void markUsedSlow(ManagedType& type, int id);
 
 public:
+    // Default edge length of an atlas page in pixels
+    static constexpr int ATLAS_PAGE_SIZE = 1024;
+
+    // Transparent gutter between atlas entries so neighbours never bleed
+    static constexpr int ATLAS_PADDING = 1;
+
+    // Memory of the atlas pages the residency tries to stay within. Only
+    // pages holding nothing but evictable manifest images can be freed, so
+    // the budget is a target rather than a hard cap.
+    static constexpr size_t DEFAULT_TEXTURE_BUDGET = 64u * 1024u * 1024u;
+
+    // Add the pack's pages to the atlas as they are. Image paths the pack
+    // holds are then registered from it, without decoding.
+    static bool loadPack(SDL_Renderer* renderer, const AssetPack& pack);
+
     static void registerType(int id, const std::string& name, SDL_Renderer* renderer, const char* imagePath);
-    static std::shared_ptr<TileType> getType(int id);
+    static void registerType(int id, const std::string& name, SDL_Renderer* renderer, SDL_Surface* surface);
+
+    // Registered at once with a placeholder image, the type is replaced by
+    // the real one when the loader hands it back
+    static void registerType(int id, const std::string& name, SDL_Renderer* renderer, const char* imagePath, AssetLoader& loader);
+
+    static const TileType* getType(int id);
     static int getTileID(const TileType* tile);
     static std::vector<const TileType*> getAllTypes();
+    // Page slots, a freed page keeps its slot with a null texture
+    static int getAtlasPageCount();
+    static const AtlasPage& getAtlasPage(int page);
+
+    // Register the types listed in a manifest, one per line:
+    //   id "name" image-path [resident] [hidden]
+    // Blank lines and lines starting with # are skipped. Each type draws a
+    // placeholder until it is first seen; resident types start loading
+    // right away. Images load through the loader when one is given.
+    static bool loadManifest(SDL_Renderer* renderer, const std::string& path, AssetLoader* loader = nullptr);
+
+    // Called by whatever draws a type, from any thread. A manifest type
+    // still without its image gets it requested.
+    static void markUsed(int id) {
+        if (id >= 0 && id < static_cast<int>(managedTypes.size()) && managedTypes[id]
+            && managedTypes[id]->lastUsedFrame.load(std::memory_order_relaxed) != residencyFrame) {
+            markUsedSlow(*managedTypes[id], id);
+        }
+    }
+
+    // Once per frame, after drawing: start loading the requested images
+    // and, while the atlas is over budget, free the pages drawn from least
+    // recently
+    static void updateResidency(SDL_Renderer* renderer, AssetLoader* loader = nullptr);
+
+    static void setTextureBudget(size_t bytes);
+    static size_t getTextureBudget();
+    static TileResidencyStats getResidencyStats();
+    static uint32_t getFlags(int id);
+
+    // Incremented whenever a type is registered or its image replaced
+    static uint64_t getRevision();
     static void clear();
-};
\ No newline at end of file
+};
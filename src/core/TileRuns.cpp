@@ -0,0 +1,147 @@
+// TileRuns.cpp
+
+#include "TileRuns.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+void putVarint(std::vector<uint8_t>& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+}
+
+TileRuns::TileRuns(int x, int y, int width, int height, int firstLayer, int lastLayer)
+    : x(x), y(y), width(std::max(width, 0)), height(std::max(height, 0)), firstLayer(firstLayer), lastLayer(lastLayer) {
+}
+
+int TileRuns::getX() const {
+    return x;
+}
+
+int TileRuns::getY() const {
+    return y;
+}
+
+int TileRuns::getWidth() const {
+    return width;
+}
+
+int TileRuns::getHeight() const {
+    return height;
+}
+
+int TileRuns::getFirstLayer() const {
+    return firstLayer;
+}
+
+int TileRuns::getLastLayer() const {
+    return lastLayer;
+}
+
+bool TileRuns::isEmpty() const {
+    return getCellCount() == 0;
+}
+
+uint64_t TileRuns::getCellCount() const {
+    if (lastLayer < firstLayer) {
+        return 0;
+    }
+    return static_cast<uint64_t>(width) * height * (lastLayer - firstLayer + 1);
+}
+
+size_t TileRuns::getMemoryUsage() const {
+    return sizeof(TileRuns) + bytes.capacity() + literals.capacity() * sizeof(TileID);
+}
+
+void TileRuns::flushLiterals() {
+    if (literals.empty()) {
+        return;
+    }
+    putVarint(bytes, (static_cast<uint64_t>(literals.size()) << 1) | 1);
+    size_t offset = bytes.size();
+    bytes.resize(offset + literals.size() * sizeof(TileID));
+    std::memcpy(bytes.data() + offset, literals.data(), literals.size() * sizeof(TileID));
+    literals.clear();
+}
+
+void TileRuns::flushRun() {
+    if (runLength == 0) {
+        return;
+    }
+    if (runLength < MIN_RUN) {
+        literals.insert(literals.end(), static_cast<size_t>(runLength), runID);
+    } else {
+        flushLiterals();
+        putVarint(bytes, runLength << 1);
+        bytes.push_back(static_cast<uint8_t>(runID));
+        bytes.push_back(static_cast<uint8_t>(runID >> 8));
+    }
+    runLength = 0;
+}
+
+void TileRuns::appendRun(TileID id, uint64_t count) {
+    if (count == 0) {
+        return;
+    }
+    if (runLength > 0 && id != runID) {
+        flushRun();
+    }
+    runID = id;
+    runLength += count;
+}
+
+void TileRuns::appendCells(const TileID* ids, int count) {
+    const TileID* end = ids + count;
+    while (ids < end) {
+        TileID id = *ids;
+        const TileID* next = std::find_if(ids + 1, end, [id](TileID other) { return other != id; });
+        appendRun(id, static_cast<uint64_t>(next - ids));
+        ids = next;
+    }
+}
+
+void TileRuns::finish() {
+    flushRun();
+    flushLiterals();
+    bytes.shrink_to_fit();
+    literals.shrink_to_fit();
+}
+
+// The encoding of a cell sequence is unique, so equal bytes mean equal cells
+bool TileRuns::operator==(const TileRuns& other) const {
+    return x == other.x && y == other.y && width == other.width && height == other.height &&
+           firstLayer == other.firstLayer && lastLayer == other.lastLayer && bytes == other.bytes;
+}
+
+bool TileRuns::readPacket(size_t& offset, Packet& packet) const {
+    if (offset >= bytes.size()) {
+        return false;
+    }
+
+    uint64_t header = 0;
+    for (int shift = 0; offset < bytes.size() && shift < 64; shift += 7) {
+        uint8_t byte = bytes[offset++];
+        header |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            break;
+        }
+    }
+
+    packet.count = header >> 1;
+    if (header & 1) {
+        packet.literals = bytes.data() + offset;
+        packet.id = EMPTY_TILE;
+        offset += packet.count * sizeof(TileID);
+    } else {
+        packet.literals = nullptr;
+        packet.id = static_cast<TileID>(bytes[offset] | (bytes[offset + 1] << 8));
+        offset += 2;
+    }
+    return true;
+}
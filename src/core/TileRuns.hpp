@@ -0,0 +1,65 @@
+// TileRuns.hpp
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Tile.hpp"
+
+// Run-length encoded contents of a rectangle over a range of layers, read
+// layer by layer in row-major order. Runs carry on across row and layer
+// ends, so a uniform region costs a few bytes whatever its size; stretches
+// without repeats become literal packets at two bytes per cell.
+class TileRuns {
+
+public:
+    // count cells, all equal to id, or copied from literals when it is set
+    struct Packet {
+        uint64_t count = 0;
+        TileID id = EMPTY_TILE;
+        const uint8_t* literals = nullptr;
+    };
+
+private:
+    int x = 0, y = 0, width = 0, height = 0;
+    int firstLayer = 0, lastLayer = -1;
+    std::vector<uint8_t> bytes;     // Varint header (count << 1 | literal) then the ID or IDs
+
+    // Encoder state, the run being extended and the literals before it
+    TileID runID = EMPTY_TILE;
+    uint64_t runLength = 0;
+    std::vector<TileID> literals;
+
+    // Shorter repeats are cheaper inside a literal packet
+    static constexpr uint64_t MIN_RUN = 3;
+
+    void flushRun();
+    void flushLiterals();
+
+public:
+    TileRuns() = default;
+    TileRuns(int x, int y, int width, int height, int firstLayer, int lastLayer);
+
+    int getX() const;
+    int getY() const;
+    int getWidth() const;
+    int getHeight() const;
+    int getFirstLayer() const;
+    int getLastLayer() const;
+    bool isEmpty() const;
+    uint64_t getCellCount() const;
+    size_t getMemoryUsage() const;
+
+    // Encoding, cells in the order described above; finish before reading
+    void appendRun(TileID id, uint64_t count);
+    void appendCells(const TileID* ids, int count);
+    void finish();
+
+    // Same rectangle, layers and cells
+    bool operator==(const TileRuns& other) const;
+
+    // Decode the packet at offset and advance it, false at the end
+    bool readPacket(size_t& offset, Packet& packet) const;
+};
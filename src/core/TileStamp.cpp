@@ -0,0 +1,92 @@
+// TileStamp.cpp
+
+#include "TileStamp.hpp"
+#include <algorithm>
+
+TileStamp::TileStamp(int width, int height, int numLayers)
+    : width(std::max(width, 0)), height(std::max(height, 0)), numLayers(std::max(numLayers, 0)) {
+    cells.assign(static_cast<size_t>(this->width) * this->height * this->numLayers, EMPTY_TILE);
+}
+
+int TileStamp::getWidth() const {
+    return width;
+}
+
+int TileStamp::getHeight() const {
+    return height;
+}
+
+int TileStamp::getLayerCount() const {
+    return numLayers;
+}
+
+bool TileStamp::isEmpty() const {
+    return cells.empty();
+}
+
+TileID TileStamp::get(int x, int y, int layer) const {
+    return getRow(y, layer)[x];
+}
+
+void TileStamp::set(int x, int y, int layer, TileID id) {
+    getRow(y, layer)[x] = id;
+}
+
+TileID* TileStamp::getRow(int y, int layer) {
+    return cells.data() + (static_cast<size_t>(layer) * height + y) * width;
+}
+
+const TileID* TileStamp::getRow(int y, int layer) const {
+    return cells.data() + (static_cast<size_t>(layer) * height + y) * width;
+}
+
+// (x, y) moves to (height - 1 - y, x), width and height swap
+void TileStamp::rotateClockwise() {
+    std::vector<TileID> rotated(cells.size());
+    for (int layer = 0; layer < numLayers; ++layer) {
+        const TileID* source = cells.data() + static_cast<size_t>(layer) * width * height;
+        TileID* target = rotated.data() + static_cast<size_t>(layer) * width * height;
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                target[static_cast<size_t>(x) * height + (height - 1 - y)] = source[static_cast<size_t>(y) * width + x];
+            }
+        }
+    }
+    cells.swap(rotated);
+    std::swap(width, height);
+}
+
+// (x, y) moves to (y, width - 1 - x), width and height swap
+void TileStamp::rotateCounterClockwise() {
+    std::vector<TileID> rotated(cells.size());
+    for (int layer = 0; layer < numLayers; ++layer) {
+        const TileID* source = cells.data() + static_cast<size_t>(layer) * width * height;
+        TileID* target = rotated.data() + static_cast<size_t>(layer) * width * height;
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                target[static_cast<size_t>(width - 1 - x) * height + y] = source[static_cast<size_t>(y) * width + x];
+            }
+        }
+    }
+    cells.swap(rotated);
+    std::swap(width, height);
+}
+
+// Mirror along x, each row is reversed in place
+void TileStamp::flipHorizontal() {
+    for (int layer = 0; layer < numLayers; ++layer) {
+        for (int y = 0; y < height; ++y) {
+            TileID* row = getRow(y, layer);
+            std::reverse(row, row + width);
+        }
+    }
+}
+
+// Mirror along y, rows swap places
+void TileStamp::flipVertical() {
+    for (int layer = 0; layer < numLayers; ++layer) {
+        for (int y = 0; y < height / 2; ++y) {
+            std::swap_ranges(getRow(y, layer), getRow(y, layer) + width, getRow(height - 1 - y, layer));
+        }
+    }
+}
@@ -0,0 +1,39 @@
+// TileStamp.hpp
+
+#pragma once
+
+#include <vector>
+
+#include "Tile.hpp"
+
+// Rectangular block of tile IDs over one or more layers, copied out of a
+// map or built by hand and pasted back with Map::pasteStamp. EMPTY_TILE
+// cells are holes that a masked paste leaves untouched.
+class TileStamp {
+
+private:
+    int width = 0, height = 0, numLayers = 0;
+    std::vector<TileID> cells;      // Layer by layer, rows in order
+
+public:
+    TileStamp() = default;
+    TileStamp(int width, int height, int numLayers);
+
+    int getWidth() const;
+    int getHeight() const;
+    int getLayerCount() const;
+    bool isEmpty() const;
+
+    TileID get(int x, int y, int layer) const;
+    void set(int x, int y, int layer, TileID id);
+
+    // Contiguous cells of one stamp row
+    TileID* getRow(int y, int layer);
+    const TileID* getRow(int y, int layer) const;
+
+    // Transforms in grid space, applied to every layer
+    void rotateClockwise();
+    void rotateCounterClockwise();
+    void flipHorizontal();
+    void flipVertical();
+};
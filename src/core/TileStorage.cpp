@@ -0,0 +1,315 @@
+// TileStorage.cpp
+
+#include "TileStorage.hpp"
+#include "utils/MappedFile.hpp"
+#include <algorithm>
+
+// ---------------------------------------------------------------------------
+// DenseTileStorage
+
+DenseTileStorage::DenseTileStorage(int width, int height, int numLayers)
+    : width(width), height(height) {
+
+    // One flat array per layer, every cell starts empty
+    layers.resize(numLayers);
+    for (auto& layer : layers) {
+        layer.assign(static_cast<size_t>(width) * height, EMPTY_TILE);
+    }
+}
+
+size_t DenseTileStorage::cellIndex(int x, int y) const {
+    return static_cast<size_t>(y) * width + x;
+}
+
+TileID DenseTileStorage::get(int x, int y, int layer) const {
+    return layers[layer][cellIndex(x, y)];
+}
+
+void DenseTileStorage::set(int x, int y, int layer, TileID id) {
+    layers[layer][cellIndex(x, y)] = id;
+}
+
+const TileID* DenseTileStorage::readRow(int x, int y, int layer, int maxCount, int& count) const {
+    count = std::min(maxCount, width - x);
+    return layers[layer].data() + cellIndex(x, y);
+}
+
+void DenseTileStorage::fillRow(int x, int y, int layer, int count, TileID id) {
+    TileID* cells = layers[layer].data() + cellIndex(x, y);
+    std::fill(cells, cells + count, id);
+}
+
+void DenseTileStorage::writeRow(int x, int y, int layer, int count, const TileID* ids) {
+    std::copy(ids, ids + count, layers[layer].data() + cellIndex(x, y));
+}
+
+void DenseTileStorage::clearLayer(int layer) {
+    std::fill(layers[layer].begin(), layers[layer].end(), EMPTY_TILE);
+}
+
+// Every cell is allocated, report the whole map
+bool DenseTileStorage::getOccupiedBounds(int layer, int& minX, int& minY, int& maxX, int& maxY) const {
+    (void)layer;
+    if (width <= 0 || height <= 0) {
+        return false;
+    }
+
+    minX = 0;
+    minY = 0;
+    maxX = width - 1;
+    maxY = height - 1;
+    return true;
+}
+
+size_t DenseTileStorage::getMemoryUsage() const {
+    size_t bytes = 0;
+    for (const auto& layer : layers) {
+        bytes += layer.capacity() * sizeof(TileID);
+    }
+    return bytes;
+}
+
+// ---------------------------------------------------------------------------
+// ChunkedTileStorage
+
+ChunkedTileStorage::Chunk* ChunkedTileStorage::findChunk(int x, int y, int layer) const {
+    // Arithmetic shifts floor, so negative coordinates land in the right chunk
+    auto it = chunks.find(ChunkKey{ x >> CHUNK_SHIFT, y >> CHUNK_SHIFT, layer });
+    return (it != chunks.end()) ? it->second.get() : nullptr;
+}
+
+ChunkedTileStorage::Chunk* ChunkedTileStorage::acquireChunk(int x, int y, int layer) {
+    auto& chunk = chunks[ChunkKey{ x >> CHUNK_SHIFT, y >> CHUNK_SHIFT, layer }];
+    if (!chunk) {
+        chunk = std::make_unique<Chunk>();
+        chunk->cells.fill(EMPTY_TILE);
+    }
+    return chunk.get();
+}
+
+TileID ChunkedTileStorage::get(int x, int y, int layer) const {
+    const Chunk* chunk = findChunk(x, y, layer);
+    if (!chunk) {
+        return EMPTY_TILE;
+    }
+    return chunk->cells[(y & CHUNK_MASK) * CHUNK_SIZE + (x & CHUNK_MASK)];
+}
+
+void ChunkedTileStorage::set(int x, int y, int layer, TileID id) {
+    fillRow(x, y, layer, 1, id);
+}
+
+const TileID* ChunkedTileStorage::readRow(int x, int y, int layer, int maxCount, int& count) const {
+    int localX = x & CHUNK_MASK;
+    count = std::min(maxCount, CHUNK_SIZE - localX);
+
+    const Chunk* chunk = findChunk(x, y, layer);
+    if (!chunk) {
+        return nullptr;
+    }
+    return chunk->cells.data() + (y & CHUNK_MASK) * CHUNK_SIZE + localX;
+}
+
+void ChunkedTileStorage::fillRow(int x, int y, int layer, int count, TileID id) {
+    while (count > 0) {
+        int localX = x & CHUNK_MASK;
+        int run = std::min(count, CHUNK_SIZE - localX);
+
+        // Clearing never allocates, writing allocates on demand
+        Chunk* chunk = (id == EMPTY_TILE) ? findChunk(x, y, layer) : acquireChunk(x, y, layer);
+        if (chunk) {
+            TileID* cells = chunk->cells.data() + (y & CHUNK_MASK) * CHUNK_SIZE + localX;
+            for (int i = 0; i < run; ++i) {
+                chunk->occupied += (id != EMPTY_TILE) - (cells[i] != EMPTY_TILE);
+                cells[i] = id;
+            }
+
+            if (chunk->occupied == 0) {
+                chunks.erase(ChunkKey{ x >> CHUNK_SHIFT, y >> CHUNK_SHIFT, layer });
+            }
+        }
+
+        x += run;
+        count -= run;
+    }
+}
+
+void ChunkedTileStorage::writeRow(int x, int y, int layer, int count, const TileID* ids) {
+    while (count > 0) {
+        int localX = x & CHUNK_MASK;
+        int run = std::min(count, CHUNK_SIZE - localX);
+
+        // Runs of empty IDs never allocate
+        bool anyTile = std::any_of(ids, ids + run, [](TileID id) { return id != EMPTY_TILE; });
+        Chunk* chunk = anyTile ? acquireChunk(x, y, layer) : findChunk(x, y, layer);
+        if (chunk) {
+            TileID* cells = chunk->cells.data() + (y & CHUNK_MASK) * CHUNK_SIZE + localX;
+            for (int i = 0; i < run; ++i) {
+                chunk->occupied += (ids[i] != EMPTY_TILE) - (cells[i] != EMPTY_TILE);
+                cells[i] = ids[i];
+            }
+
+            if (chunk->occupied == 0) {
+                chunks.erase(ChunkKey{ x >> CHUNK_SHIFT, y >> CHUNK_SHIFT, layer });
+            }
+        }
+
+        x += run;
+        ids += run;
+        count -= run;
+    }
+}
+
+void ChunkedTileStorage::clearLayer(int layer) {
+    for (auto it = chunks.begin(); it != chunks.end();) {
+        if (it->first.layer == layer) {
+            it = chunks.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+// Union of the layer's allocated chunks
+bool ChunkedTileStorage::getOccupiedBounds(int layer, int& minX, int& minY, int& maxX, int& maxY) const {
+    bool found = false;
+    for (const auto& entry : chunks) {
+        if (entry.first.layer != layer) {
+            continue;
+        }
+
+        int x0 = entry.first.x * CHUNK_SIZE;
+        int y0 = entry.first.y * CHUNK_SIZE;
+        if (!found) {
+            minX = x0;
+            minY = y0;
+            maxX = x0 + CHUNK_MASK;
+            maxY = y0 + CHUNK_MASK;
+            found = true;
+        } else {
+            minX = std::min(minX, x0);
+            minY = std::min(minY, y0);
+            maxX = std::max(maxX, x0 + CHUNK_MASK);
+            maxY = std::max(maxY, y0 + CHUNK_MASK);
+        }
+    }
+    return found;
+}
+
+size_t ChunkedTileStorage::getMemoryUsage() const {
+    return chunks.size() * sizeof(Chunk);
+}
+
+size_t ChunkedTileStorage::getChunkCount() const {
+    return chunks.size();
+}
+
+// ---------------------------------------------------------------------------
+// MappedTileStorage
+
+MappedTileStorage::MappedTileStorage(std::unique_ptr<MappedFile> file, int width, int height, int numLayers,
+                                     size_t dataOffset, size_t layerStride)
+    : width(width), height(height), numLayers(numLayers), file(std::move(file)),
+      dataOffset(dataOffset), layerStride(layerStride), pageSize(MappedFile::getPageSize()) {
+
+    size_t pages = (this->file->getSize() + pageSize - 1) / pageSize;
+    dirtyPages.assign((pages + 63) / 64, 0);
+}
+
+MappedTileStorage::~MappedTileStorage() = default;
+
+TileID* MappedTileStorage::cells(int x, int y, int layer) const {
+    uint8_t* layerData = file->getData() + dataOffset + layer * layerStride;
+    return reinterpret_cast<TileID*>(layerData) + static_cast<size_t>(y) * width + x;
+}
+
+void MappedTileStorage::markDirty(int x, int y, int layer, int count) {
+    size_t begin = dataOffset + layer * layerStride + (static_cast<size_t>(y) * width + x) * sizeof(TileID);
+    size_t end = begin + static_cast<size_t>(count) * sizeof(TileID);
+    for (size_t page = begin / pageSize; page <= (end - 1) / pageSize; ++page) {
+        uint64_t bit = uint64_t(1) << (page & 63);
+        if (!(dirtyPages[page >> 6] & bit)) {
+            dirtyPages[page >> 6] |= bit;
+            dirtyPageCount++;
+        }
+    }
+}
+
+TileID MappedTileStorage::get(int x, int y, int layer) const {
+    return *cells(x, y, layer);
+}
+
+void MappedTileStorage::set(int x, int y, int layer, TileID id) {
+    markDirty(x, y, layer, 1);
+    *cells(x, y, layer) = id;
+}
+
+const TileID* MappedTileStorage::readRow(int x, int y, int layer, int maxCount, int& count) const {
+    count = std::min(maxCount, width - x);
+    return cells(x, y, layer);
+}
+
+void MappedTileStorage::fillRow(int x, int y, int layer, int count, TileID id) {
+    markDirty(x, y, layer, count);
+    TileID* row = cells(x, y, layer);
+    std::fill(row, row + count, id);
+}
+
+void MappedTileStorage::writeRow(int x, int y, int layer, int count, const TileID* ids) {
+    markDirty(x, y, layer, count);
+    std::copy(ids, ids + count, cells(x, y, layer));
+}
+
+// Copies every page of the layer
+void MappedTileStorage::clearLayer(int layer) {
+    for (int y = 0; y < height; ++y) {
+        fillRow(0, y, layer, width, EMPTY_TILE);
+    }
+}
+
+// Reading the whole file to find the tiles would defeat the mapping
+bool MappedTileStorage::getOccupiedBounds(int layer, int& minX, int& minY, int& maxX, int& maxY) const {
+    (void)layer;
+    if (width <= 0 || height <= 0) {
+        return false;
+    }
+
+    minX = 0;
+    minY = 0;
+    maxX = width - 1;
+    maxY = height - 1;
+    return true;
+}
+
+size_t MappedTileStorage::getMemoryUsage() const {
+    return dirtyPageCount * pageSize + dirtyPages.capacity() * sizeof(uint64_t);
+}
+
+// Consecutive dirty pages are written back together
+bool MappedTileStorage::flush() {
+    bool flushed = true;
+    const size_t pageCount = dirtyPages.size() * 64;
+    for (size_t page = 0; page < pageCount;) {
+        if (dirtyPages[page >> 6] == 0) {
+            page = (page | 63) + 1;
+            continue;
+        }
+        if (!(dirtyPages[page >> 6] >> (page & 63) & 1)) {
+            page++;
+            continue;
+        }
+
+        size_t end = page;
+        while (end < pageCount && (dirtyPages[end >> 6] >> (end & 63) & 1)) {
+            end++;
+        }
+        flushed = file->writeBack(page * pageSize, (end - page) * pageSize) && flushed;
+        page = end;
+    }
+
+    if (flushed) {
+        std::fill(dirtyPages.begin(), dirtyPages.end(), 0);
+        dirtyPageCount = 0;
+    }
+    return flushed;
+}
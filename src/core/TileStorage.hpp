@@ -0,0 +1,142 @@
+// TileStorage.hpp
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "Tile.hpp"
+#include "utils/ChunkKey.hpp"
+
+class MappedFile;
+
+// Backing store for the tile IDs of a map. Callers validate coordinates;
+// storages only hold cells.
+class TileStorage {
+
+public:
+    virtual ~TileStorage() = default;
+
+    virtual TileID get(int x, int y, int layer) const = 0;
+    virtual void set(int x, int y, int layer, TileID id) = 0;
+
+    // Cells starting at (x, y) that are contiguous in memory, at most
+    // maxCount of them. The run length is written to count; a null return
+    // means the whole run is unallocated and therefore empty.
+    virtual const TileID* readRow(int x, int y, int layer, int maxCount, int& count) const = 0;
+
+    // Set count cells of a row starting at (x, y) to the same ID
+    virtual void fillRow(int x, int y, int layer, int count, TileID id) = 0;
+
+    // Copy count IDs into a row starting at (x, y)
+    virtual void writeRow(int x, int y, int layer, int count, const TileID* ids) = 0;
+
+    // Remove every tile of a layer
+    virtual void clearLayer(int layer) = 0;
+
+    // Conservative bounding box of the cells of a layer that may hold
+    // tiles, inclusive. Returns false when the layer is certainly empty.
+    virtual bool getOccupiedBounds(int layer, int& minX, int& minY, int& maxX, int& maxY) const = 0;
+
+    // Bytes held for tile data
+    virtual size_t getMemoryUsage() const = 0;
+
+    // Write edits to the file behind the storage, storages that only live
+    // in memory have nothing to do
+    virtual bool flush() { return true; }
+};
+
+// One contiguous row-major array per layer, sized up front
+class DenseTileStorage : public TileStorage {
+
+private:
+    int width, height;
+    std::vector<std::vector<TileID>> layers;
+
+    size_t cellIndex(int x, int y) const;
+
+public:
+    DenseTileStorage(int width, int height, int numLayers);
+
+    TileID get(int x, int y, int layer) const override;
+    void set(int x, int y, int layer, TileID id) override;
+    const TileID* readRow(int x, int y, int layer, int maxCount, int& count) const override;
+    void fillRow(int x, int y, int layer, int count, TileID id) override;
+    void writeRow(int x, int y, int layer, int count, const TileID* ids) override;
+    void clearLayer(int layer) override;
+    bool getOccupiedBounds(int layer, int& minX, int& minY, int& maxX, int& maxY) const override;
+    size_t getMemoryUsage() const override;
+};
+
+// Sparse storage made of fixed-size square chunks, allocated on first
+// write and freed once they hold no tile. Any int coordinate is valid,
+// including negative ones.
+class ChunkedTileStorage : public TileStorage {
+
+public:
+    static constexpr int CHUNK_SHIFT = 5;
+    static constexpr int CHUNK_SIZE = 1 << CHUNK_SHIFT;   // 32x32 cells per chunk
+    static constexpr int CHUNK_MASK = CHUNK_SIZE - 1;
+
+    struct Chunk {
+        std::array<TileID, CHUNK_SIZE * CHUNK_SIZE> cells;
+        int occupied = 0;   // Non-empty cells, the chunk is freed at zero
+    };
+
+private:
+    std::unordered_map<ChunkKey, std::unique_ptr<Chunk>, ChunkKeyHash> chunks;
+
+    Chunk* findChunk(int x, int y, int layer) const;
+    Chunk* acquireChunk(int x, int y, int layer);
+
+public:
+    TileID get(int x, int y, int layer) const override;
+    void set(int x, int y, int layer, TileID id) override;
+    const TileID* readRow(int x, int y, int layer, int maxCount, int& count) const override;
+    void fillRow(int x, int y, int layer, int count, TileID id) override;
+    void writeRow(int x, int y, int layer, int count, const TileID* ids) override;
+    void clearLayer(int layer) override;
+    bool getOccupiedBounds(int layer, int& minX, int& minY, int& maxX, int& maxY) const override;
+    size_t getMemoryUsage() const override;
+
+    size_t getChunkCount() const;
+};
+
+// Cells read in place from a memory-mapped tile-ID file, one row-major
+// array of little endian IDs per layer. Only the pages that are read get
+// loaded, so a huge world costs memory for the area that is visited.
+// Edits land in private copy-on-write pages and reach the file on flush.
+class MappedTileStorage : public TileStorage {
+
+private:
+    int width, height, numLayers;
+    std::unique_ptr<MappedFile> file;
+    size_t dataOffset, layerStride;     // Bytes to the first layer and between layers
+    size_t pageSize;
+    std::vector<uint64_t> dirtyPages;   // One bit per page of the file written since the last flush
+    size_t dirtyPageCount = 0;
+
+    TileID* cells(int x, int y, int layer) const;
+    void markDirty(int x, int y, int layer, int count);
+
+public:
+    // The file must hold every layer at the given offsets
+    MappedTileStorage(std::unique_ptr<MappedFile> file, int width, int height, int numLayers,
+                      size_t dataOffset, size_t layerStride);
+    ~MappedTileStorage() override;
+
+    TileID get(int x, int y, int layer) const override;
+    void set(int x, int y, int layer, TileID id) override;
+    const TileID* readRow(int x, int y, int layer, int maxCount, int& count) const override;
+    void fillRow(int x, int y, int layer, int count, TileID id) override;
+    void writeRow(int x, int y, int layer, int count, const TileID* ids) override;
+    void clearLayer(int layer) override;
+    bool getOccupiedBounds(int layer, int& minX, int& minY, int& maxX, int& maxY) const override;
+
+    // Private pages not flushed yet, the clean ones are the OS's to drop
+    size_t getMemoryUsage() const override;
+    bool flush() override;
+};
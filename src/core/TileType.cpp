@@ -1,12 +1,12 @@
 #include "TileType.hpp"
+#include <utility>
 
-TileType::TileType(const std::string& name, SDL_Texture* texture)
-    : name(name), texture(texture) {}
+TileType::TileType(const std::string& name, SDL_Texture* texture, int atlasPage, const SDL_FRect& sourceRect, const SDL_FRect& uvRect,
+                   AlphaMask alphaMask)
+    : name(name), texture(texture), atlasPage(atlasPage), sourceRect(sourceRect), uvRect(uvRect), alphaMask(std::move(alphaMask)) {}
 
 TileType::~TileType() {
-    if (texture) {
-        SDL_DestroyTexture(texture);
-    }
+    // The atlas page is shared with other types and freed by TileRegistry
 }
 
 const std::string& TileType::getName() const {
@@ -16,3 +16,29 @@ const std::string& TileType::getName() const {
 SDL_Texture* TileType::getTexture() const {
     return texture;
 }
+
+int TileType::getAtlasPage() const {
+    return atlasPage;
+}
+
+const SDL_FRect& TileType::getSourceRect() const {
+    return sourceRect;
+}
+
+const SDL_FRect& TileType::getUVRect() const {
+    return uvRect;
+}
+
+const AlphaMask& TileType::getAlphaMask() const {
+    return alphaMask;
+}
+
+bool TileType::isOpaqueAt(float u, float v) const {
+    if (!texture) {
+        return false;
+    }
+    if (alphaMask.isEmpty()) {
+        return u >= 0.0f && u < 1.0f && v >= 0.0f && v < 1.0f;
+    }
+    return alphaMask.testUV(u, v);
+}
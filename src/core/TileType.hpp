@@ -3,17 +3,31 @@
 #include <string>
 #include <SDL3/SDL.h>
 
+#include "AlphaMask.hpp"
+
 class TileType {
 private:
     std::string name;
-    SDL_Texture* texture;
+    SDL_Texture* texture;   // Atlas page holding the image, owned by TileRegistry
+    int atlasPage;
+    SDL_FRect sourceRect;   // Image location on the page in pixels
+    SDL_FRect uvRect;       // Same location in normalized texture coordinates
+    AlphaMask alphaMask;    // Opaque pixels of the image, for picking
 
 public:
-    TileType(const std::string& name, SDL_Texture* texture);
+    TileType(const std::string& name, SDL_Texture* texture, int atlasPage, const SDL_FRect& sourceRect, const SDL_FRect& uvRect,
+             AlphaMask alphaMask = AlphaMask());
     ~TileType();
 
     const std::string& getName() const;
     SDL_Texture* getTexture() const;
+    int getAtlasPage() const;
+    const SDL_FRect& getSourceRect() const;
+    const SDL_FRect& getUVRect() const;
+    const AlphaMask& getAlphaMask() const;
 
+    // Whether the drawn image covers a point given in [0, 1) over the
+    // sprite. Without a mask the whole rectangle counts.
+    bool isOpaqueAt(float u, float v) const;
 
 };
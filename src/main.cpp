@@ -14,7 +14,12 @@ int SDL_AppMain(int argc, char *argv[]) {
     SDL_AppResult result = SDL_APP_CONTINUE;
 
     while (result == SDL_APP_CONTINUE) {
-        while (SDL_PollEvent(&e)) {
+        // Sleep until input arrives while nothing on screen would change
+        if (engine.isIdle() && SDL_WaitEventTimeout(&e, engine.getIdleTimeout())) {
+            result = engine.EngineEvent(appstate, &e);
+        }
+
+        while (result == SDL_APP_CONTINUE && SDL_PollEvent(&e)) {
             result = engine.EngineEvent(appstate, &e);
             if (result != SDL_APP_CONTINUE)
                 break;
@@ -0,0 +1,218 @@
+// BinaryIO.hpp
+
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/types.h>
+#endif
+
+// Little endian helpers shared by the engine's binary file formats
+namespace BinaryIO {
+
+inline void putU8(std::vector<uint8_t>& out, uint8_t value) {
+    out.push_back(value);
+}
+
+inline void putU16(std::vector<uint8_t>& out, uint16_t value) {
+    out.push_back(static_cast<uint8_t>(value));
+    out.push_back(static_cast<uint8_t>(value >> 8));
+}
+
+inline void putU32(std::vector<uint8_t>& out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out.push_back(static_cast<uint8_t>(value >> (i * 8)));
+    }
+}
+
+inline void putI32(std::vector<uint8_t>& out, int32_t value) {
+    putU32(out, static_cast<uint32_t>(value));
+}
+
+inline void putU64(std::vector<uint8_t>& out, uint64_t value) {
+    for (int i = 0; i < 8; ++i) {
+        out.push_back(static_cast<uint8_t>(value >> (i * 8)));
+    }
+}
+
+// Floats are stored bit for bit so values read back exactly
+inline void putF32(std::vector<uint8_t>& out, float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    putU32(out, bits);
+}
+
+inline void putVarint(std::vector<uint8_t>& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value) | 0x80);
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+// Bounds-checked reader over bytes in memory. Reads past the end return
+// zero and clear isOk, so a format can read a whole header before checking.
+class Reader {
+
+private:
+    const std::vector<uint8_t>& data;
+    size_t& cursor;
+    bool ok = true;
+
+public:
+    Reader(const std::vector<uint8_t>& bytes, size_t& position) : data(bytes), cursor(position) {}
+
+    bool isOk() const { return ok; }
+
+    uint8_t u8() {
+        if (cursor + 1 > data.size()) {
+            ok = false;
+            return 0;
+        }
+        return data[cursor++];
+    }
+
+    uint16_t u16() {
+        uint16_t low = u8();
+        return static_cast<uint16_t>(low | (u8() << 8));
+    }
+
+    uint32_t u32() {
+        uint32_t value = 0;
+        for (int i = 0; i < 4; ++i) {
+            value |= static_cast<uint32_t>(u8()) << (i * 8);
+        }
+        return value;
+    }
+
+    int32_t i32() {
+        return static_cast<int32_t>(u32());
+    }
+
+    uint64_t u64() {
+        uint64_t low = u32();
+        return low | static_cast<uint64_t>(u32()) << 32;
+    }
+
+    float f32() {
+        uint32_t bits = u32();
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    uint64_t varint() {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            uint8_t byte = u8();
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) {
+                return value;
+            }
+        }
+        ok = false;
+        return 0;
+    }
+
+    // Pointer to the next count bytes and skip them, nullptr when fewer are left
+    const uint8_t* bytes(size_t count) {
+        if (count > data.size() - cursor) {
+            ok = false;
+            cursor = data.size();
+            return nullptr;
+        }
+        const uint8_t* start = data.data() + cursor;
+        cursor += count;
+        return start;
+    }
+};
+
+// Whole file into out, false when it can't be opened
+inline bool readFile(const std::string& path, std::vector<uint8_t>& out) {
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) {
+        return false;
+    }
+
+    out.clear();
+    uint8_t buffer[4096];
+    size_t read;
+    while ((read = std::fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        out.insert(out.end(), buffer, buffer + read);
+    }
+    std::fclose(file);
+    return true;
+}
+
+// Byte ranges of an open file, for formats with an index that are read
+// piece by piece
+class FileReader {
+
+private:
+    FILE* file = nullptr;
+
+public:
+    FileReader() = default;
+    ~FileReader() { close(); }
+
+    FileReader(const FileReader&) = delete;
+    FileReader& operator=(const FileReader&) = delete;
+
+    bool open(const std::string& path) {
+        close();
+        file = std::fopen(path.c_str(), "rb");
+        return file != nullptr;
+    }
+
+    void close() {
+        if (file) {
+            std::fclose(file);
+            file = nullptr;
+        }
+    }
+
+    // Replace out with size bytes from offset, false when fewer are there
+    bool read(uint64_t offset, size_t size, std::vector<uint8_t>& out) {
+        out.resize(size);
+        if (!file) {
+            return false;
+        }
+#ifdef _WIN32
+        bool sought = _fseeki64(file, static_cast<long long>(offset), SEEK_SET) == 0;
+#else
+        bool sought = fseeko(file, static_cast<off_t>(offset), SEEK_SET) == 0;
+#endif
+        return sought && std::fread(out.data(), 1, size, file) == size;
+    }
+};
+
+// Written beside the target and renamed over it, so a failed save leaves
+// the previous file intact
+inline bool writeFile(const std::string& path, const std::vector<uint8_t>& bytes) {
+    const std::string tempPath = path + ".tmp";
+    FILE* file = std::fopen(tempPath.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+
+    bool written = std::fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size();
+    written = std::fclose(file) == 0 && written;
+#ifdef _WIN32
+    // rename doesn't replace an existing file here
+    if (written) {
+        std::remove(path.c_str());
+    }
+#endif
+    if (!written || std::rename(tempPath.c_str(), path.c_str()) != 0) {
+        std::remove(tempPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+}
@@ -0,0 +1,27 @@
+// ChunkKey.hpp
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Chunk coordinates and layer used as a hash map key. Every int value is
+// kept as is, so no two chunks of any map share a key.
+struct ChunkKey {
+    int x, y, layer;
+
+    bool operator==(const ChunkKey& other) const {
+        return x == other.x && y == other.y && layer == other.layer;
+    }
+};
+
+struct ChunkKeyHash {
+    size_t operator()(const ChunkKey& key) const {
+        // Mix all three so rows of neighbouring chunks spread over buckets
+        uint64_t hash = static_cast<uint32_t>(key.x);
+        hash = (hash * 0x9E3779B97F4A7C15ull) ^ static_cast<uint32_t>(key.y);
+        hash = (hash * 0x9E3779B97F4A7C15ull) ^ static_cast<uint32_t>(key.layer);
+        hash ^= hash >> 31;
+        return static_cast<size_t>(hash * 0xBF58476D1CE4E5B9ull);
+    }
+};
@@ -0,0 +1,220 @@
+// MappedFile.cpp
+
+#include "MappedFile.hpp"
+#include <algorithm>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const std::string& path, Access access) {
+    close();
+    const bool copyOnWrite = access == Access::CopyOnWrite;
+
+    HANDLE file = INVALID_HANDLE_VALUE;
+    if (copyOnWrite) {
+        file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+                           OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        writable = file != INVALID_HANDLE_VALUE;
+    }
+    if (file == INVALID_HANDLE_VALUE) {
+        file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                           OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    }
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    fileHandle = file;
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart <= 0) {
+        close();
+        return false;
+    }
+
+    mappingHandle = CreateFileMappingA(file, nullptr, copyOnWrite ? PAGE_WRITECOPY : PAGE_READONLY, 0, 0, nullptr);
+    void* view = mappingHandle ? MapViewOfFile(mappingHandle, copyOnWrite ? FILE_MAP_COPY : FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (!view) {
+        close();
+        return false;
+    }
+
+    data = static_cast<uint8_t*>(view);
+    size = static_cast<size_t>(fileSize.QuadPart);
+    return true;
+}
+
+void MappedFile::close() {
+    if (data) {
+        UnmapViewOfFile(data);
+    }
+    if (mappingHandle) {
+        CloseHandle(mappingHandle);
+    }
+    if (fileHandle) {
+        CloseHandle(fileHandle);
+    }
+    data = nullptr;
+    size = 0;
+    writable = false;
+    mappingHandle = nullptr;
+    fileHandle = nullptr;
+}
+
+// Copy-on-write pages of a view can't be reverted, they stay private
+bool MappedFile::writeBack(size_t offset, size_t count) {
+    if (!data || !writable || offset > size) {
+        return false;
+    }
+    count = std::min(count, size - offset);
+
+    size_t written = 0;
+    while (written < count) {
+        OVERLAPPED position = {};
+        uint64_t fileOffset = offset + written;
+        position.Offset = static_cast<DWORD>(fileOffset);
+        position.OffsetHigh = static_cast<DWORD>(fileOffset >> 32);
+
+        DWORD chunk = static_cast<DWORD>(std::min<size_t>(count - written, 1u << 30));
+        DWORD done = 0;
+        if (!WriteFile(fileHandle, data + offset + written, chunk, &done, &position) || done == 0) {
+            return false;
+        }
+        written += done;
+    }
+    return true;
+}
+
+size_t MappedFile::getPageSize() {
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwPageSize;
+}
+
+#else
+
+bool MappedFile::open(const std::string& path, Access access) {
+    close();
+    const bool copyOnWrite = access == Access::CopyOnWrite;
+
+    if (copyOnWrite) {
+        fd = ::open(path.c_str(), O_RDWR);
+        writable = fd >= 0;
+    }
+    if (fd < 0) {
+        fd = ::open(path.c_str(), O_RDONLY);
+    }
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+        close();
+        return false;
+    }
+
+    // Private either way, so writes never reach the file behind our back
+    int protection = PROT_READ | (copyOnWrite ? PROT_WRITE : 0);
+    void* address = mmap(nullptr, static_cast<size_t>(info.st_size), protection, MAP_PRIVATE, fd, 0);
+    if (address == MAP_FAILED) {
+        close();
+        return false;
+    }
+
+    // Reads jump between rows far apart, read-ahead would mostly load
+    // cells nobody looks at
+    madvise(address, static_cast<size_t>(info.st_size), MADV_RANDOM);
+
+    data = static_cast<uint8_t*>(address);
+    size = static_cast<size_t>(info.st_size);
+    return true;
+}
+
+void MappedFile::close() {
+    if (data) {
+        munmap(data, size);
+    }
+    if (fd >= 0) {
+        ::close(fd);
+    }
+    data = nullptr;
+    size = 0;
+    writable = false;
+    fd = -1;
+}
+
+bool MappedFile::writeBack(size_t offset, size_t count) {
+    if (!data || !writable || offset > size) {
+        return false;
+    }
+    count = std::min(count, size - offset);
+
+    size_t written = 0;
+    while (written < count) {
+        ssize_t done = pwrite(fd, data + offset + written, count - written, static_cast<off_t>(offset + written));
+        if (done < 0 && errno == EINTR) {
+            continue;
+        }
+        if (done <= 0) {
+            return false;
+        }
+        written += static_cast<size_t>(done);
+    }
+
+#ifdef __linux__
+    // On a private file mapping this discards the copies, the next access
+    // reads the pages just written from the page cache
+    const size_t page = getPageSize();
+    size_t first = (offset + page - 1) / page * page;
+    size_t last = (offset + count) / page * page;
+    if (offset + count == size) {
+        last = (size + page - 1) / page * page;
+    }
+    if (last > first) {
+        madvise(data + first, last - first, MADV_DONTNEED);
+    }
+#endif
+    return true;
+}
+
+size_t MappedFile::getPageSize() {
+    return static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
+
+#endif
+
+bool MappedFile::isOpen() const {
+    return data != nullptr;
+}
+
+bool MappedFile::isWritable() const {
+    return writable;
+}
+
+uint8_t* MappedFile::getData() {
+    return data;
+}
+
+const uint8_t* MappedFile::getData() const {
+    return data;
+}
+
+size_t MappedFile::getSize() const {
+    return size;
+}
@@ -0,0 +1,57 @@
+// MappedFile.hpp
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// A whole file mapped into memory, paged in by the OS as it is touched.
+// A copy-on-write mapping can be written to: changed pages become private
+// copies that the file never sees until they are written back.
+class MappedFile {
+
+public:
+    enum class Access {
+        ReadOnly,
+        CopyOnWrite
+    };
+
+private:
+    uint8_t* data = nullptr;
+    size_t size = 0;
+    bool writable = false;      // The file accepts write-backs
+
+#ifdef _WIN32
+    void* fileHandle = nullptr;
+    void* mappingHandle = nullptr;
+#else
+    int fd = -1;
+#endif
+
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // False when the file can't be opened, is empty or can't be mapped. A
+    // copy-on-write mapping of a read-only file still opens; its changes
+    // just can't be written back.
+    bool open(const std::string& path, Access access);
+    void close();
+
+    bool isOpen() const;
+    bool isWritable() const;
+    uint8_t* getData();
+    const uint8_t* getData() const;
+    size_t getSize() const;
+
+    // Write a byte range of the mapping to the same range of the file.
+    // Where the platform allows, the range's private pages are then
+    // dropped and read from the file again, returning their memory.
+    bool writeBack(size_t offset, size_t count);
+
+    static size_t getPageSize();
+};
@@ -3,25 +3,140 @@
 #include "Math.hpp"
 #include <cmath>
 
+#include <SDL3/SDL.h>
+
+// The vector paths mirror the scalar expressions operation for operation,
+// which only matches bit for bit when the scalar code also uses SSE
+// arithmetic, so they are limited to x86-64.
+#if defined(__x86_64__) || defined(_M_X64)
+#define MATH_HAS_X86_SIMD 1
+#include <immintrin.h>
+#if defined(__GNUC__) || defined(__clang__)
+#define MATH_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define MATH_TARGET_AVX2
+#endif
+#else
+#define MATH_HAS_X86_SIMD 0
+#endif
+
+namespace {
+
+Math::SimdLevel activeLevel = Math::getSupportedSimdLevel();
+
+#if MATH_HAS_X86_SIMD
+
+// Truncate, then step down one where truncation rounded up (negative
+// fractions). Matches floor for every result representable as an int.
+inline __m128i floorToInt(__m128 value) {
+    __m128i truncated = _mm_cvttps_epi32(value);
+    __m128 roundedUp = _mm_cmpgt_ps(_mm_cvtepi32_ps(truncated), value);
+    return _mm_add_epi32(truncated, _mm_castps_si128(roundedUp));
+}
+
+void toScreenSSE2(const float* forward, const int* gridX, const int* gridY, int* screenX, int* screenY, std::size_t count) {
+    const __m128 f0 = _mm_set1_ps(forward[0]);
+    const __m128 f1 = _mm_set1_ps(forward[1]);
+    const __m128 f2 = _mm_set1_ps(forward[2]);
+    const __m128 f3 = _mm_set1_ps(forward[3]);
+
+    for (std::size_t i = 0; i < count; i += 4) {
+        __m128 gx = _mm_cvtepi32_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(gridX + i)));
+        __m128 gy = _mm_cvtepi32_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(gridY + i)));
+
+        __m128 sx = _mm_add_ps(_mm_mul_ps(gx, f0), _mm_mul_ps(gy, f1));
+        __m128 sy = _mm_add_ps(_mm_mul_ps(gx, f2), _mm_mul_ps(gy, f3));
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(screenX + i), _mm_cvttps_epi32(sx));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(screenY + i), _mm_cvttps_epi32(sy));
+    }
+}
+
+void toGridSSE2(const float* inverse, const int* screenX, const int* screenY, int* gridX, int* gridY, std::size_t count) {
+    const __m128 a = _mm_set1_ps(inverse[0]);
+    const __m128 b = _mm_set1_ps(inverse[1]);
+    const __m128 c = _mm_set1_ps(inverse[2]);
+    const __m128 d = _mm_set1_ps(inverse[3]);
+
+    for (std::size_t i = 0; i < count; i += 4) {
+        __m128 sx = _mm_cvtepi32_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(screenX + i)));
+        __m128 sy = _mm_cvtepi32_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(screenY + i)));
+
+        __m128 rawX = _mm_add_ps(_mm_mul_ps(sx, a), _mm_mul_ps(sy, b));
+        __m128 rawY = _mm_add_ps(_mm_mul_ps(sx, c), _mm_mul_ps(sy, d));
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(gridX + i), floorToInt(rawX));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(gridY + i), floorToInt(rawY));
+    }
+}
+
+MATH_TARGET_AVX2 inline __m256i floorToInt(__m256 value) {
+    __m256i truncated = _mm256_cvttps_epi32(value);
+    __m256 roundedUp = _mm256_cmp_ps(_mm256_cvtepi32_ps(truncated), value, _CMP_GT_OQ);
+    return _mm256_add_epi32(truncated, _mm256_castps_si256(roundedUp));
+}
+
+MATH_TARGET_AVX2 void toScreenAVX2(const float* forward, const int* gridX, const int* gridY, int* screenX, int* screenY, std::size_t count) {
+    const __m256 f0 = _mm256_set1_ps(forward[0]);
+    const __m256 f1 = _mm256_set1_ps(forward[1]);
+    const __m256 f2 = _mm256_set1_ps(forward[2]);
+    const __m256 f3 = _mm256_set1_ps(forward[3]);
+
+    for (std::size_t i = 0; i < count; i += 8) {
+        __m256 gx = _mm256_cvtepi32_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(gridX + i)));
+        __m256 gy = _mm256_cvtepi32_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(gridY + i)));
+
+        // Separate multiply and add, never FMA, to round like the scalar code
+        __m256 sx = _mm256_add_ps(_mm256_mul_ps(gx, f0), _mm256_mul_ps(gy, f1));
+        __m256 sy = _mm256_add_ps(_mm256_mul_ps(gx, f2), _mm256_mul_ps(gy, f3));
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(screenX + i), _mm256_cvttps_epi32(sx));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(screenY + i), _mm256_cvttps_epi32(sy));
+    }
+}
+
+MATH_TARGET_AVX2 void toGridAVX2(const float* inverse, const int* screenX, const int* screenY, int* gridX, int* gridY, std::size_t count) {
+    const __m256 a = _mm256_set1_ps(inverse[0]);
+    const __m256 b = _mm256_set1_ps(inverse[1]);
+    const __m256 c = _mm256_set1_ps(inverse[2]);
+    const __m256 d = _mm256_set1_ps(inverse[3]);
+
+    for (std::size_t i = 0; i < count; i += 8) {
+        __m256 sx = _mm256_cvtepi32_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(screenX + i)));
+        __m256 sy = _mm256_cvtepi32_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(screenY + i)));
+
+        __m256 rawX = _mm256_add_ps(_mm256_mul_ps(a, sx), _mm256_mul_ps(b, sy));
+        __m256 rawY = _mm256_add_ps(_mm256_mul_ps(c, sx), _mm256_mul_ps(d, sy));
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(gridX + i), floorToInt(rawX));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(gridY + i), floorToInt(rawY));
+    }
+}
+
+#endif
+
+// Elements the vector path for the active level can process in full lanes.
+// Staggered rows are not a single affine map and always run scalar.
+std::size_t vectorCount(std::size_t count) {
+    if (ActiveProjection::staggered) {
+        return 0;
+    }
+
+    switch (activeLevel) {
+        case Math::SimdLevel::AVX2: return count & ~std::size_t(7);
+        case Math::SimdLevel::SSE2: return count & ~std::size_t(3);
+        default: return 0;
+    }
+}
+
+}
+
 void Math::toScreenCoordinates(int w, int h, int gridX, int gridY, int& screenX, int& screenY) {
-    screenX = gridX * i_x * 0.5f * w + gridY * j_x * 0.5f * w;
-    screenY = gridX * i_y * 0.5f * h + gridY * j_y * 0.5f * h;
-}
-
-void Math::toGridCoordinates(int w, int h, int screenX, int screenY, int& gridX, int& gridY) {    
-    float a = i_x * 0.5f * w;
-    float b = j_x * 0.5f * w;
-    float c = i_y * 0.5f * h;
-    float d = j_y * 0.5f * h;
-        
-    invertMatrix(a, b, c, d);
-        
-    float rawX = a * screenX + b * screenY;
-    float rawY = c * screenX + d * screenY;
-        
-    gridX = static_cast<int>(std::floor(rawX));
-    gridY = static_cast<int>(std::floor(rawY));
-    
+    Projection(w, h).toScreen(gridX, gridY, screenX, screenY);
+}
+
+void Math::toGridCoordinates(int w, int h, int screenX, int screenY, int& gridX, int& gridY) {
+    Projection(w, h).toGrid(screenX, screenY, gridX, gridY);
 }
 
 void Math::invertMatrix(float& a, float& b, float& c, float& d) {
@@ -36,3 +151,64 @@ void Math::invertMatrix(float& a, float& b, float& c, float& d) {
     c = -det * c;
     d = det * origA;
 }
+
+void Math::toScreenCoordinates(int w, int h, const int* gridX, const int* gridY, int* screenX, int* screenY, std::size_t count) {
+    const Projection projection(w, h);
+    std::size_t done = vectorCount(count);
+
+#if MATH_HAS_X86_SIMD
+    if (activeLevel == SimdLevel::AVX2) {
+        toScreenAVX2(projection.getForward(), gridX, gridY, screenX, screenY, done);
+    } else if (activeLevel == SimdLevel::SSE2) {
+        toScreenSSE2(projection.getForward(), gridX, gridY, screenX, screenY, done);
+    }
+#endif
+
+    for (std::size_t i = done; i < count; ++i) {
+        projection.toScreen(gridX[i], gridY[i], screenX[i], screenY[i]);
+    }
+}
+
+void Math::toGridCoordinates(int w, int h, const int* screenX, const int* screenY, int* gridX, int* gridY, std::size_t count) {
+    const Projection projection(w, h);
+    std::size_t done = vectorCount(count);
+
+#if MATH_HAS_X86_SIMD
+    if (activeLevel == SimdLevel::AVX2) {
+        toGridAVX2(projection.getInverse(), screenX, screenY, gridX, gridY, done);
+    } else if (activeLevel == SimdLevel::SSE2) {
+        toGridSSE2(projection.getInverse(), screenX, screenY, gridX, gridY, done);
+    }
+#endif
+
+    for (std::size_t i = done; i < count; ++i) {
+        projection.toGrid(screenX[i], screenY[i], gridX[i], gridY[i]);
+    }
+}
+
+Math::SimdLevel Math::getSupportedSimdLevel() {
+#if MATH_HAS_X86_SIMD
+    static const SimdLevel supported = SDL_HasAVX2() ? SimdLevel::AVX2 : SimdLevel::SSE2;
+    return supported;
+#else
+    return SimdLevel::Scalar;
+#endif
+}
+
+Math::SimdLevel Math::getSimdLevel() {
+    return activeLevel;
+}
+
+void Math::setSimdLevel(SimdLevel level) {
+    SimdLevel supported = getSupportedSimdLevel();
+    activeLevel = (static_cast<int>(level) > static_cast<int>(supported)) ? supported : level;
+}
+
+const char* Math::getSimdLevelName(SimdLevel level) {
+    switch (level) {
+        case SimdLevel::Scalar: return "scalar";
+        case SimdLevel::SSE2: return "sse2";
+        case SimdLevel::AVX2: return "avx2";
+    }
+    return "unknown";
+}
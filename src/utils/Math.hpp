@@ -2,18 +2,45 @@
 
 #pragma once
 
-class Math {
+#include <cstddef>
+#include "Projection.hpp"
+
+// Projection the engine is built with, see ISOENGINE_PROJECTION in CMake
+#if defined(ISOENGINE_PROJECTION_DIMETRIC)
+using ActiveProjection = DimetricProjection;
+#elif defined(ISOENGINE_PROJECTION_STAGGERED)
+using ActiveProjection = StaggeredProjection;
+#else
+using ActiveProjection = IsometricProjection;
+#endif
 
-private:
-    constexpr static float i_x = 1.0f;
-    constexpr static float i_y = 0.5f;
-    constexpr static float j_x = -1.0f;
-    constexpr static float j_y = 0.5f;
+class Math {
 
 public:
+    using Projection = TileProjection<ActiveProjection>;
+
+    // Instruction set used by the batch transforms
+    enum class SimdLevel {
+        Scalar,
+        SSE2,
+        AVX2
+    };
+
     static void toScreenCoordinates(int w, int h, int gridX, int gridY, int& screenX, int& screenY);
 
     static void invertMatrix(float &a, float &b, float &c, float &d);
     static void toGridCoordinates(int w, int h, int screenX, int screenY, int& gridX, int& gridY);
 
-};
\ No newline at end of file
+    // Batch variants over parallel coordinate arrays. Results are
+    // bit-identical to calling the single-point functions per element.
+    static void toScreenCoordinates(int w, int h, const int* gridX, const int* gridY, int* screenX, int* screenY, std::size_t count);
+    static void toGridCoordinates(int w, int h, const int* screenX, const int* screenY, int* gridX, int* gridY, std::size_t count);
+
+    // Best level the CPU supports, detected once
+    static SimdLevel getSupportedSimdLevel();
+    static SimdLevel getSimdLevel();
+    // Force a lower level, e.g. to compare paths; clamped to what is supported
+    static void setSimdLevel(SimdLevel level);
+    static const char* getSimdLevelName(SimdLevel level);
+
+};
@@ -0,0 +1,169 @@
+// Profiler.cpp
+
+#include "Profiler.hpp"
+#include "Statistics.hpp"
+
+#include <SDL3/SDL.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+
+std::atomic<bool> Profiler::enabled{ false };
+std::mutex Profiler::buffersMutex;
+std::vector<std::unique_ptr<Profiler::ThreadBuffer>> Profiler::buffers;
+
+namespace {
+
+// Zone names are literals, but escape them anyway to keep the JSON valid
+void writeEscaped(FILE* out, const char* text) {
+    for (; *text; ++text) {
+        if (*text == '"' || *text == '\\') {
+            std::fputc('\\', out);
+        }
+        std::fputc(*text, out);
+    }
+}
+
+}
+
+// Buffers outlive their threads so exports still include finished workers
+Profiler::ThreadBuffer& Profiler::getThreadBuffer() {
+    thread_local ThreadBuffer* buffer = nullptr;
+    if (!buffer) {
+        auto created = std::make_unique<ThreadBuffer>();
+        created->events.resize(RING_CAPACITY);
+
+        std::lock_guard<std::mutex> lock(buffersMutex);
+        created->threadID = static_cast<uint32_t>(buffers.size() + 1);
+        created->threadName = "Thread " + std::to_string(created->threadID);
+        buffer = created.get();
+        buffers.push_back(std::move(created));
+    }
+    return *buffer;
+}
+
+void Profiler::setEnabled(bool enable) {
+    enabled.store(enable, std::memory_order_relaxed);
+}
+
+void Profiler::setThreadName(const char* name) {
+    ThreadBuffer& buffer = getThreadBuffer();
+    std::lock_guard<std::mutex> lock(buffersMutex);
+    buffer.threadName = name;
+}
+
+uint64_t Profiler::beginZone() {
+    getThreadBuffer().depth++;
+    return SDL_GetTicksNS();
+}
+
+void Profiler::endZone(const char* name, uint64_t startNs) {
+    uint64_t endNs = SDL_GetTicksNS();
+    ThreadBuffer& buffer = getThreadBuffer();
+    buffer.depth--;
+
+    uint64_t index = buffer.written.load(std::memory_order_relaxed);
+    buffer.events[index & (RING_CAPACITY - 1)] = { name, startNs, endNs, buffer.depth };
+    buffer.written.store(index + 1, std::memory_order_release);
+}
+
+// Copy the ring's live events, oldest first
+void Profiler::snapshot(const ThreadBuffer& buffer, std::vector<ProfileEvent>& events) {
+    uint64_t end = buffer.written.load(std::memory_order_acquire);
+    uint64_t begin = end > RING_CAPACITY ? end - RING_CAPACITY : 0;
+
+    size_t first = events.size();
+    for (uint64_t i = begin; i < end; ++i) {
+        events.push_back(buffer.events[i & (RING_CAPACITY - 1)]);
+    }
+
+    // The owner kept writing while we copied; drop the slots it may have
+    // reused, including the one it could be in the middle of writing
+    uint64_t after = buffer.written.load(std::memory_order_acquire);
+    uint64_t firstValid = after + 1 > RING_CAPACITY ? after + 1 - RING_CAPACITY : 0;
+    if (firstValid > begin) {
+        size_t stale = static_cast<size_t>(std::min(firstValid, end) - begin);
+        events.erase(events.begin() + first, events.begin() + first + stale);
+    }
+}
+
+void Profiler::collectZoneStats(std::vector<ProfileZoneStats>& stats) {
+    stats.clear();
+
+    std::vector<ProfileEvent> events;
+    {
+        std::lock_guard<std::mutex> lock(buffersMutex);
+        for (const auto& buffer : buffers) {
+            snapshot(*buffer, events);
+        }
+    }
+
+    std::map<std::string, std::vector<double>> durations;
+    for (const ProfileEvent& event : events) {
+        durations[event.name].push_back((event.endNs - event.startNs) / 1.0e6);
+    }
+
+    for (auto& [name, values] : durations) {
+        std::sort(values.begin(), values.end());
+
+        double total = 0.0;
+        for (double value : values) {
+            total += value;
+        }
+
+        ProfileZoneStats zone;
+        zone.name = name;
+        zone.count = static_cast<int>(values.size());
+        zone.meanMs = total / values.size();
+        zone.p50Ms = Statistics::percentile(values, 0.50);
+        zone.p95Ms = Statistics::percentile(values, 0.95);
+        zone.p99Ms = Statistics::percentile(values, 0.99);
+        zone.maxMs = values.back();
+        stats.push_back(std::move(zone));
+    }
+}
+
+bool Profiler::exportChromeTrace(const char* path) {
+    FILE* out = std::fopen(path, "w");
+    if (!out) {
+        SDL_Log("Couldn't open %s for writing", path);
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(buffersMutex);
+
+    std::vector<std::vector<ProfileEvent>> threadEvents(buffers.size());
+    uint64_t origin = UINT64_MAX;
+    for (size_t t = 0; t < buffers.size(); ++t) {
+        snapshot(*buffers[t], threadEvents[t]);
+        for (const ProfileEvent& event : threadEvents[t]) {
+            origin = std::min(origin, event.startNs);
+        }
+    }
+
+    std::fprintf(out, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    bool first = true;
+    for (size_t t = 0; t < buffers.size(); ++t) {
+        uint32_t tid = buffers[t]->threadID;
+
+        std::fprintf(out, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"", first ? "" : ",\n", tid);
+        writeEscaped(out, buffers[t]->threadName.c_str());
+        std::fprintf(out, "\"}}");
+        first = false;
+
+        // Timestamps and durations are in microseconds
+        for (const ProfileEvent& event : threadEvents[t]) {
+            std::fprintf(out, ",\n{\"name\":\"");
+            writeEscaped(out, event.name);
+            std::fprintf(out, "\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                         tid, (event.startNs - origin) / 1000.0, (event.endNs - event.startNs) / 1000.0);
+        }
+    }
+    std::fprintf(out, "\n]}\n");
+
+    bool ok = std::ferror(out) == 0;
+    std::fclose(out);
+    return ok;
+}
@@ -0,0 +1,99 @@
+// Profiler.hpp
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// One closed zone as recorded by the thread that ran it
+struct ProfileEvent {
+    const char* name;       // String literal, zones are grouped by its content
+    uint64_t startNs;
+    uint64_t endNs;
+    uint32_t depth;         // Nesting level on its thread, 0 for outermost zones
+};
+
+// Timing summary of every recorded instance of one zone
+struct ProfileZoneStats {
+    std::string name;
+    int count = 0;
+    double meanMs = 0.0;
+    double p50Ms = 0.0;
+    double p95Ms = 0.0;
+    double p99Ms = 0.0;
+    double maxMs = 0.0;
+};
+
+class Profiler {
+
+private:
+    // Ring of the most recent events of one thread. Only the owning thread
+    // writes; readers copy it and drop whatever was overwritten meanwhile.
+    struct ThreadBuffer {
+        std::vector<ProfileEvent> events;
+        std::atomic<uint64_t> written{ 0 };
+        uint32_t threadID = 0;
+        std::string threadName;
+        uint32_t depth = 0;
+    };
+
+    static std::atomic<bool> enabled;
+    static std::mutex buffersMutex;
+    static std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+
+    static ThreadBuffer& getThreadBuffer();
+    static void snapshot(const ThreadBuffer& buffer, std::vector<ProfileEvent>& events);
+
+public:
+    static constexpr size_t RING_CAPACITY = 1 << 15;   // Events kept per thread, power of two
+
+    static void setEnabled(bool enable);
+    static bool isEnabled() { return enabled.load(std::memory_order_relaxed); }
+
+    // Name shown for the calling thread in exported traces
+    static void setThreadName(const char* name);
+
+    // Used by ProfileZone, returns the start timestamp
+    static uint64_t beginZone();
+    static void endZone(const char* name, uint64_t startNs);
+
+    // Per-zone percentiles over everything still held in the rings
+    static void collectZoneStats(std::vector<ProfileZoneStats>& stats);
+
+    // Write the rings as Chrome trace JSON, loadable in Perfetto or chrome://tracing
+    static bool exportChromeTrace(const char* path);
+};
+
+// Records the enclosing scope as a zone while the profiler is enabled
+class ProfileZone {
+
+private:
+    const char* name;
+    uint64_t startNs;
+
+public:
+    explicit ProfileZone(const char* zoneName)
+        : name(zoneName), startNs(Profiler::isEnabled() ? Profiler::beginZone() : 0) {}
+
+    ~ProfileZone() {
+        if (startNs != 0) {
+            Profiler::endZone(name, startNs);
+        }
+    }
+
+    ProfileZone(const ProfileZone&) = delete;
+    ProfileZone& operator=(const ProfileZone&) = delete;
+};
+
+// Zones compile away entirely when ISOENGINE_PROFILING is not defined
+#if defined(ISOENGINE_PROFILING)
+#define PROFILE_ZONE_CONCAT_INNER(a, b) a##b
+#define PROFILE_ZONE_CONCAT(a, b) PROFILE_ZONE_CONCAT_INNER(a, b)
+#define PROFILE_ZONE(name) ProfileZone PROFILE_ZONE_CONCAT(profileZone, __LINE__)(name)
+#else
+#define PROFILE_ZONE(name) ((void)0)
+#endif
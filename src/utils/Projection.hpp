@@ -0,0 +1,124 @@
+// Projection.hpp
+
+#pragma once
+
+#include <cmath>
+
+// Grid to screen projection policies. The basis gives the screen offset of
+// one step along grid x (i) and grid y (j), in half tile widths and heights.
+
+// Classic pixel art isometric, 2:1 diamonds
+struct IsometricProjection {
+    static constexpr const char* name = "isometric";
+    static constexpr bool staggered = false;
+    static constexpr float i_x = 1.0f;
+    static constexpr float i_y = 0.5f;
+    static constexpr float j_x = -1.0f;
+    static constexpr float j_y = 0.5f;
+};
+
+// Dimetric with the ground axes at a true 30 degrees (tan 30 = 0.57735)
+// instead of the 26.57 degrees of 2:1 pixel art
+struct DimetricProjection {
+    static constexpr const char* name = "dimetric";
+    static constexpr bool staggered = false;
+    static constexpr float i_x = 1.0f;
+    static constexpr float i_y = 0.57735027f;
+    static constexpr float j_x = -1.0f;
+    static constexpr float j_y = 0.57735027f;
+};
+
+// 2:1 diamonds laid out in staggered rows, odd rows shifted half a tile
+// right, so a rectangular map covers a rectangular screen area
+struct StaggeredProjection {
+    static constexpr const char* name = "staggered";
+    static constexpr bool staggered = true;
+    static constexpr float i_x = 1.0f;
+    static constexpr float i_y = 0.5f;
+    static constexpr float j_x = -1.0f;
+    static constexpr float j_y = 0.5f;
+};
+
+// A projection policy bound to a tile size. The basis inverse is folded at
+// compile time, so constructing one costs four divisions and transforming a
+// point two multiplies and an add per axis.
+template <typename Policy>
+class TileProjection {
+
+private:
+    static constexpr float determinant = Policy::i_x * Policy::j_y - Policy::j_x * Policy::i_y;
+
+    // Inverse basis, scaled by two to undo the half tile units
+    static constexpr float inverse_i_x = 2.0f * Policy::j_y / determinant;
+    static constexpr float inverse_i_y = 2.0f * -Policy::j_x / determinant;
+    static constexpr float inverse_j_x = 2.0f * -Policy::i_y / determinant;
+    static constexpr float inverse_j_y = 2.0f * Policy::i_x / determinant;
+
+    static_assert(determinant != 0.0f, "projection basis must be invertible");
+
+    // Row-major screen = forward * grid and grid = inverse * screen
+    float forward[4];
+    float inverse[4];
+
+public:
+    using PolicyType = Policy;
+
+    constexpr TileProjection(float tileWidth, float tileHeight)
+        : forward{ Policy::i_x * 0.5f * tileWidth, Policy::j_x * 0.5f * tileWidth,
+                   Policy::i_y * 0.5f * tileHeight, Policy::j_y * 0.5f * tileHeight },
+          inverse{ inverse_i_x / tileWidth, inverse_i_y / tileHeight,
+                   inverse_j_x / tileWidth, inverse_j_y / tileHeight } {}
+
+    constexpr void toScreen(int gridX, int gridY, int& screenX, int& screenY) const {
+        if constexpr (Policy::staggered) {
+            // Column and row of a staggered cell to its diamond coordinates
+            int parity = gridY & 1;
+            int diagonal = 2 * gridX + parity;
+            int column = (gridY + diagonal) / 2;
+            gridY = (gridY - diagonal) / 2;
+            gridX = column;
+        }
+
+        screenX = static_cast<int>(gridX * forward[0] + gridY * forward[1]);
+        screenY = static_cast<int>(gridX * forward[2] + gridY * forward[3]);
+    }
+
+    void toGrid(int screenX, int screenY, int& gridX, int& gridY) const {
+        float rawX = screenX * inverse[0] + screenY * inverse[1];
+        float rawY = screenX * inverse[2] + screenY * inverse[3];
+
+        gridX = static_cast<int>(std::floor(rawX));
+        gridY = static_cast<int>(std::floor(rawY));
+
+        if constexpr (Policy::staggered) {
+            // Diamond coordinates back to staggered column and row,
+            // the shift floors the halved difference
+            int row = gridX + gridY;
+            gridX = (gridX - gridY) >> 1;
+            gridY = row;
+        }
+    }
+
+    // Unrounded screen position of a row's anchors as origin + gridX * step
+    constexpr void getRowLine(int gridY, float& originX, float& stepX, float& originY, float& stepY) const {
+        if constexpr (Policy::staggered) {
+            // Column 0 of the row in diamond coordinates, each column
+            // further moves one step along i and one back along j
+            int parity = gridY & 1;
+            int diamondX = (gridY + parity) / 2;
+            int diamondY = (gridY - parity) / 2;
+            originX = diamondX * forward[0] + diamondY * forward[1];
+            originY = diamondX * forward[2] + diamondY * forward[3];
+            stepX = forward[0] - forward[1];
+            stepY = forward[2] - forward[3];
+        } else {
+            originX = gridY * forward[1];
+            originY = gridY * forward[3];
+            stepX = forward[0];
+            stepY = forward[2];
+        }
+    }
+
+    const float* getForward() const { return forward; }
+    const float* getInverse() const { return inverse; }
+};
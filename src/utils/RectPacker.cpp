@@ -0,0 +1,123 @@
+// RectPacker.cpp
+
+#include "RectPacker.hpp"
+
+#include <algorithm>
+
+RectPacker::RectPacker(int width, int height, int padding)
+    : width(width), height(height), padding(padding) {}
+
+bool RectPacker::insert(int w, int h, PackedRect& out) {
+    int paddedW = w + padding * 2;
+    int paddedH = h + padding * 2;
+
+    // Released space first, the smallest free rectangle that fits
+    int bestFree = -1;
+    for (int i = 0; i < static_cast<int>(freeRects.size()); ++i) {
+        const PackedRect& free = freeRects[i];
+        if (free.w >= paddedW && free.h >= paddedH
+            && (bestFree < 0 || static_cast<long long>(free.w) * free.h < static_cast<long long>(freeRects[bestFree].w) * freeRects[bestFree].h)) {
+            bestFree = i;
+        }
+    }
+    if (bestFree >= 0) {
+        PackedRect slot = freeRects[bestFree];
+        freeRects[bestFree] = freeRects.back();
+        freeRects.pop_back();
+
+        // Keep what is left to the right and below
+        if (slot.w > paddedW) {
+            freeRects.push_back({ slot.x + paddedW, slot.y, slot.w - paddedW, paddedH });
+        }
+        if (slot.h > paddedH) {
+            freeRects.push_back({ slot.x, slot.y + paddedH, slot.w, slot.h - paddedH });
+        }
+
+        out = { slot.x + padding, slot.y + padding, w, h };
+        usedArea += static_cast<long long>(paddedW) * paddedH;
+        return true;
+    }
+
+    // Best fit: the shelf that wastes the least height
+    Shelf* best = nullptr;
+    for (auto& shelf : shelves) {
+        if (shelf.height >= paddedH && shelf.nextX + paddedW <= width) {
+            if (!best || shelf.height < best->height) {
+                best = &shelf;
+            }
+        }
+    }
+
+    // Otherwise open a new shelf under the last one
+    if (!best) {
+        if (nextShelfY + paddedH > height || paddedW > width) {
+            return false;
+        }
+        shelves.push_back({ nextShelfY, paddedH, 0 });
+        nextShelfY += paddedH;
+        best = &shelves.back();
+    }
+
+    out = { best->nextX + padding, best->y + padding, w, h };
+    best->nextX += paddedW;
+    usedArea += static_cast<long long>(paddedW) * paddedH;
+    return true;
+}
+
+void RectPacker::release(const PackedRect& rect) {
+    PackedRect padded = { rect.x - padding, rect.y - padding, rect.w + padding * 2, rect.h + padding * 2 };
+    usedArea -= static_cast<long long>(padded.w) * padded.h;
+
+    // Nothing left, start over with the whole area
+    if (usedArea == 0) {
+        shelves.clear();
+        freeRects.clear();
+        nextShelfY = 0;
+        return;
+    }
+
+    // Merge with free neighbours sharing a whole edge, so released images
+    // next to each other can take a larger one
+    for (bool merged = true; merged;) {
+        merged = false;
+        for (size_t i = 0; i < freeRects.size() && !merged; ++i) {
+            const PackedRect other = freeRects[i];
+            if (other.x == padded.x && other.w == padded.w
+                && (other.y + other.h == padded.y || padded.y + padded.h == other.y)) {
+                padded.y = std::min(padded.y, other.y);
+                padded.h += other.h;
+                merged = true;
+            } else if (other.y == padded.y && other.h == padded.h
+                       && (other.x + other.w == padded.x || padded.x + padded.w == other.x)) {
+                padded.x = std::min(padded.x, other.x);
+                padded.w += other.w;
+                merged = true;
+            }
+            if (merged) {
+                freeRects[i] = freeRects.back();
+                freeRects.pop_back();
+            }
+        }
+    }
+    freeRects.push_back(padded);
+}
+
+int RectPacker::getWidth() const {
+    return width;
+}
+
+int RectPacker::getHeight() const {
+    return height;
+}
+
+long long RectPacker::getUsedArea() const {
+    return usedArea;
+}
+
+bool RectPacker::isEmpty() const {
+    return usedArea == 0;
+}
+
+float RectPacker::getOccupancy() const {
+    return static_cast<float>(usedArea) / (static_cast<float>(width) * height);
+}
@@ -0,0 +1,48 @@
+// RectPacker.hpp
+
+#pragma once
+
+#include <vector>
+
+// Rectangle placed inside a packer's area
+struct PackedRect {
+    int x, y, w, h;
+};
+
+// Shelf bin packer used to lay out images on atlas pages. Rectangles are
+// placed left to right on horizontal shelves; a new shelf is opened below
+// the last one when no existing shelf fits. Released rectangles go to a
+// free list that is searched first, a larger free rectangle is split and
+// its remainder stays free. Neighbouring free rectangles sharing an edge
+// are merged, and the packer starts over once everything is released.
+class RectPacker {
+
+private:
+    struct Shelf {
+        int y, height, nextX;
+    };
+
+    int width, height;
+    int padding;                // Empty border kept around every rectangle
+    int nextShelfY = 0;
+    std::vector<Shelf> shelves;
+    std::vector<PackedRect> freeRects;      // Released areas, padding included
+    long long usedArea = 0;
+
+public:
+    RectPacker(int width, int height, int padding = 0);
+
+    // Reserve a w x h rectangle, returns false when the area is full
+    bool insert(int w, int h, PackedRect& out);
+
+    // Give back a rectangle returned by insert
+    void release(const PackedRect& rect);
+
+    int getWidth() const;
+    int getHeight() const;
+    float getOccupancy() const;
+
+    // Area taken by the reserved rectangles, padding included
+    long long getUsedArea() const;
+    bool isEmpty() const;
+};
@@ -0,0 +1,21 @@
+// Statistics.hpp
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+namespace Statistics {
+
+// Nearest-rank percentile of sorted values, p in [0, 1]
+inline double percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    size_t index = static_cast<size_t>(std::ceil(p * sorted.size()));
+    return sorted[std::min(index > 0 ? index - 1 : 0, sorted.size() - 1)];
+}
+
+}
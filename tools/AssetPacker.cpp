@@ -0,0 +1,72 @@
+// AssetPacker.cpp
+//
+// Offline asset packer: decodes images once and bakes them into an asset
+// pack the engine maps at startup instead of decoding PNGs. Images are
+// named by the path given on the command line, so run it from the
+// directory the engine runs in:
+//
+//   isoEngine_assetpacker assets/assets.isopack assets/*.png
+//
+// The pack must be rebuilt whenever an image changes.
+
+#include <SDL3/SDL.h>
+#include <SDL3_image/SDL_image.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "core/AssetPack.hpp"
+#include "core/TileRegistry.hpp"
+
+int main(int argc, char* argv[]) {
+    int pageSize = TileRegistry::ATLAS_PAGE_SIZE;
+    std::string output;
+    std::vector<std::string> inputs;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--page-size" && i + 1 < argc) {
+            pageSize = std::max(16, std::atoi(argv[++i]));
+        } else if (output.empty()) {
+            output = arg;
+        } else {
+            inputs.push_back(arg);
+        }
+    }
+    if (output.empty() || inputs.empty()) {
+        std::fprintf(stderr, "usage: isoEngine_assetpacker [--page-size N] output.isopack image...\n");
+        return 2;
+    }
+
+    // Later copies of the same path would only repeat it
+    std::sort(inputs.begin(), inputs.end());
+    inputs.erase(std::unique(inputs.begin(), inputs.end()), inputs.end());
+
+    std::vector<SDL_Surface*> surfaces;
+    bool loaded = true;
+    for (const std::string& input : inputs) {
+        SDL_Surface* surface = IMG_Load(input.c_str());
+        if (!surface) {
+            std::fprintf(stderr, "Failed to load image %s: %s\n", input.c_str(), SDL_GetError());
+            loaded = false;
+        }
+        surfaces.push_back(surface);
+    }
+
+    bool built = loaded && AssetPack::build(output, inputs, surfaces, pageSize, TileRegistry::ATLAS_PADDING);
+    for (SDL_Surface* surface : surfaces) {
+        SDL_DestroySurface(surface);
+    }
+    if (!built) {
+        return 1;
+    }
+
+    AssetPack pack;
+    if (!pack.open(output)) {
+        return 1;
+    }
+    std::printf("Packed %zu images on %zu pages into %s\n", pack.getImages().size(), pack.getPages().size(), output.c_str());
+    return 0;
+}